@@ -0,0 +1,365 @@
+#include "ChinesePostman.hpp"
+#include "CutCombiner.hpp"
+#include "IncrementalSolver.hpp"
+#include "SyntheticNetwork.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 計測の結果は、1行目を見出しとするタブ区切りの表で標準出力に書き出す。
+// 条件などは「# 名前 = 値」の形の行で表の前に書き出す。
+
+// プロセスのメモリ使用量の最大値（KB）。取得できなければ-1
+long peak_memory_kb(){
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+	return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#else
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef __APPLE__
+	return static_cast<long>(usage.ru_maxrss / 1024); // macOSではバイト単位
+#else
+	return static_cast<long>(usage.ru_maxrss);
+#endif // __APPLE__
+#endif // _WIN32
+}
+
+// 段階ごとの計測結果。繰り返した回数だけ時間を記録し、中央値などを出力する
+class StageTimer{
+private:
+	std::vector<std::string> names_;
+	std::vector< std::vector<double> > seconds_;
+	std::vector<long> peak_kb_;
+	std::chrono::steady_clock::time_point start_;
+	size_t current_;
+
+public:
+	StageTimer() : current_(0) {}
+	
+	void start(const std::string & name){
+		current_ = std::find(names_.begin(), names_.end(), name) - names_.begin();
+		if(current_ == names_.size()){
+			names_.push_back(name);
+			seconds_.push_back(std::vector<double>());
+			peak_kb_.push_back(-1);
+		}
+		start_ = std::chrono::steady_clock::now();
+	}
+	
+	void stop(){
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+		seconds_[current_].push_back(elapsed.count());
+		peak_kb_[current_] = std::max(peak_kb_[current_], peak_memory_kb());
+	}
+	
+	// 段階ごとに、時間の中央値・最小値・最大値（ミリ秒）と、その段階を終えた時点でのメモリ使用量の最大値を書き出す
+	void write(std::ostream & os) const{
+		os << "stage\tmedian_ms\tmin_ms\tmax_ms\trepeat\tpeak_memory_kb" << std::endl;
+		for(size_t i = 0; i < names_.size(); ++i){
+			std::vector<double> sorted(seconds_[i]);
+			std::sort(sorted.begin(), sorted.end());
+			size_t n = sorted.size();
+			double median = (n % 2 == 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0);
+			os << names_[i] << "\t" << median * 1000.0 << "\t" << sorted.front() * 1000.0 << "\t" << sorted.back() * 1000.0 << "\t" << n << "\t" << peak_kb_[i] << std::endl;
+		}
+	}
+};
+
+// マスクの1のビットの数
+size_t count_bits(boost::uint64_t mask){
+	size_t result = 0;
+	for(; mask != 0; mask &= mask - 1) ++result;
+	return result;
+}
+
+// カットの組み合わせの計測用に、部分ごとの境界の頂点のマスク→距離の表と、カットに使った辺を合成する。
+// 部分を輪の形に並べ、辺は近く（2つ先まで）の部分同士を結ぶ。1つの部分の境界の頂点はmax_bits個まで。
+// 実現可能な組み合わせが必ず1つはあるように、ランダムに選んだ辺を2回通ったときのマスクと、
+// ビットの数の偶奇が同じマスクにだけ距離を与える（実際の表でも偶奇は部分ごとに決まっている）。
+void make_cut_problem(size_t num_parts, size_t num_edges, size_t max_bits, unsigned int seed,
+	std::vector<ChinesePostman::BasicCutCombiner<boost::uint64_t>::CostTable> & costs,
+	std::vector<ChinesePostman::BasicCutCombiner<boost::uint64_t>::CutEdge> & edges){
+	typedef ChinesePostman::BasicCutCombiner<boost::uint64_t> CutCombiner;
+	std::mt19937 generator(seed);
+	std::vector<size_t> bits(num_parts, 0);
+	std::vector<boost::uint64_t> reference_masks(num_parts, 0);
+	
+	edges.clear();
+	for(size_t attempts = 0; edges.size() < num_edges && attempts < 16 * num_edges; ++attempts){
+		size_t part1 = generator() % num_parts;
+		size_t part2 = (part1 + 1 + generator() % 2) % num_parts;
+		if(part1 == part2 || bits[part1] >= max_bits || bits[part2] >= max_bits) continue;
+		edges.push_back(CutCombiner::CutEdge(part1, bits[part1]++, part2, bits[part2]++, 10 + generator() % 291));
+		if(generator() % 2 == 0){
+			reference_masks[part1] ^= (boost::uint64_t(1) << edges.back().bit1);
+			reference_masks[part2] ^= (boost::uint64_t(1) << edges.back().bit2);
+		}
+	}
+	
+	costs.assign(num_parts, CutCombiner::CostTable());
+	for(size_t c = 0; c < num_parts; ++c){
+		size_t parity = count_bits(reference_masks[c]) % 2;
+		boost::uint64_t num_masks = boost::uint64_t(1) << bits[c];
+		for(boost::uint64_t mask = 0; mask < num_masks; ++mask){
+			size_t popcount = count_bits(mask);
+			if(popcount % 2 != parity) continue;
+			costs[c][mask] = static_cast<ChinesePostman::EdgeWeightType>(100 * popcount + generator() % 1000);
+		}
+	}
+}
+
+int main(int argc, char ** argv){
+	// ---------- オプションの解釈
+	// --shape grid|planar|cycles : 合成グラフの形（SyntheticNetwork.hppを参照）
+	// --vertices N : 合成グラフの（盲腸線を除いた）頂点の数の目安
+	// --bridges R : 辺のうち橋が占める割合の目安
+	// --odd K : 奇数次の頂点の数（指定しなければ調整しない）
+	// --seed S : 合成グラフの乱数の種
+	// --input FILE : 合成グラフの代わりに、FILEのグラフを計測する
+	// --repeat N : 各段階をN回繰り返し、中央値を求める
+	// --threads N : 連結成分ごとの計算をNスレッドで並行して行う（0ならCPUのコア数）
+	// --cut-parts P, --cut-edges C : カットの組み合わせの計測で、部分の数とカットに使う辺の数
+	// --updates U : 辺を1本ずつU回変更し、そのたびにIncrementalSolverで解き直す（0なら計測しない）
+	// --work PREFIX : 計測に使う一時ファイルの名前（PREFIX.edges, PREFIX.cpg）
+	// --keep : 一時ファイルを消さない
+	ChinesePostman::SyntheticOptions synthetic_options;
+	std::string shape_name("grid");
+	const char * input_filename = NULL;
+	size_t repeat = 5;
+	size_t cut_parts = 16, cut_edges = 40;
+	size_t num_updates = 20;
+	std::string work_prefix("benchmark-network");
+	bool keep_files = false;
+	ChinesePostman::MatchingOptions matching_options;
+	for(int i = 1; i < argc; ++i){
+		std::string arg(argv[i]);
+		if(arg == "--shape" && i + 1 < argc){
+			shape_name = argv[++i];
+			if(!ChinesePostman::SyntheticNetwork::parse_shape(shape_name, synthetic_options.shape)){
+				std::cerr << "Error: Unknown shape \"" << shape_name << "\"" << std::endl;
+				return 1;
+			}
+		}else if(arg == "--vertices" && i + 1 < argc){
+			synthetic_options.num_vertices = std::strtoul(argv[++i], NULL, 10);
+		}else if(arg == "--bridges" && i + 1 < argc){
+			synthetic_options.bridge_ratio = std::strtod(argv[++i], NULL);
+		}else if(arg == "--odd" && i + 1 < argc){
+			synthetic_options.num_odd_vertices = std::strtol(argv[++i], NULL, 10);
+		}else if(arg == "--seed" && i + 1 < argc){
+			synthetic_options.seed = static_cast<unsigned int>(std::strtoul(argv[++i], NULL, 10));
+		}else if(arg == "--input" && i + 1 < argc){
+			input_filename = argv[++i];
+		}else if(arg == "--repeat" && i + 1 < argc){
+			repeat = std::max<size_t>(1, std::strtoul(argv[++i], NULL, 10));
+		}else if(arg == "--threads" && i + 1 < argc){
+			matching_options.num_threads = std::strtoul(argv[++i], NULL, 10);
+		}else if(arg == "--cut-parts" && i + 1 < argc){
+			cut_parts = std::max<size_t>(2, std::strtoul(argv[++i], NULL, 10));
+		}else if(arg == "--cut-edges" && i + 1 < argc){
+			cut_edges = std::strtoul(argv[++i], NULL, 10);
+		}else if(arg == "--updates" && i + 1 < argc){
+			num_updates = std::strtoul(argv[++i], NULL, 10);
+		}else if(arg == "--work" && i + 1 < argc){
+			work_prefix = argv[++i];
+		}else if(arg == "--keep"){
+			keep_files = true;
+		}else{
+			std::cerr << "Usage: " << argv[0] << " [--shape grid|planar|cycles] [--vertices N] [--bridges R] [--odd K] [--seed S] [--input FILE]" << std::endl;
+			std::cerr << "       [--repeat N] [--threads N] [--cut-parts P] [--cut-edges C] [--updates U] [--work PREFIX] [--keep]" << std::endl;
+			return 1;
+		}
+	}
+	
+	// ---------- 計測するグラフを用意する（テキスト形式と、ConvertGraphと同じバイナリ形式）
+	std::string text_filename = work_prefix + ".edges";
+	std::string binary_filename = work_prefix + ".cpg";
+	if(input_filename == NULL){
+		ChinesePostman::SyntheticNetwork network(synthetic_options);
+		std::ofstream ofs(text_filename.c_str(), std::ios::binary);
+		if(!ofs){
+			std::cerr << "Error: When opening \"" << text_filename << "\"" << std::endl;
+			return 1;
+		}
+		network.write(ofs);
+		ofs.close();
+		std::cout << "# shape = " << shape_name << std::endl;
+		std::cout << "# seed = " << synthetic_options.seed << std::endl;
+		std::cout << "# synthetic_bridges = " << network.num_bridges() << std::endl;
+	}else{
+		text_filename = input_filename;
+		std::cout << "# input = " << input_filename << std::endl;
+	}
+	{
+		ChinesePostman::CompactGraph graph;
+		if(ChinesePostman::read_from(text_filename.c_str(), graph) == 0){
+			std::cerr << "Error: When reading \"" << text_filename << "\"" << std::endl;
+			return 1;
+		}
+		std::vector<ChinesePostman::EdgeId> bridges;
+		ChinesePostman::bridge_edges(graph, bridges);
+		std::vector<size_t> component;
+		size_t num_components = ChinesePostman::connected_components(graph, component);
+		if(!ChinesePostman::write_graph_file(binary_filename.c_str(), graph, &bridges, &component, num_components)){
+			return 1;
+		}
+		
+		size_t num_odd = 0;
+		for(ChinesePostman::VertexId v = 0; v < graph.num_vertices(); ++v){
+			if(graph.degree(v) % 2 == 1) ++num_odd;
+		}
+		std::cout << "# vertices = " << graph.num_vertices() << std::endl;
+		std::cout << "# edges = " << graph.num_edges() << std::endl;
+		std::cout << "# odd_vertices = " << num_odd << std::endl;
+		std::cout << "# bridges = " << bridges.size() << std::endl;
+		std::cout << "# connected_components = " << num_components << std::endl;
+	}
+	std::cout << "# threads = " << matching_options.num_threads << std::endl;
+	std::cout << "# cut_parts = " << cut_parts << std::endl;
+	std::cout << "# cut_edges = " << cut_edges << std::endl;
+	std::cout << "# updates = " << num_updates << std::endl;
+	
+	// ---------- 各段階を順に計測する（SolveChinesePostmanと同じ順）
+	StageTimer timer;
+	ChinesePostman::EdgeWeightType doubled_distance = 0;
+	for(size_t r = 0; r < repeat; ++r){
+		{
+			ChinesePostman::CompactGraph graph;
+			timer.start("load_binary");
+			ChinesePostman::read_from(binary_filename.c_str(), graph);
+			timer.stop();
+		}
+		
+		ChinesePostman::RouteNetwork rn;
+		timer.start("load_text");
+		ChinesePostman::read_from(text_filename.c_str(), rn);
+		timer.stop();
+		
+		timer.start("bridges");
+		ChinesePostman::BridgeDetector bd(rn);
+		timer.stop();
+		for(std::vector<ChinesePostman::Graph::edge_descriptor>::const_iterator ite = bd.result().begin(); ite != bd.result().end(); ++ite){
+			boost::remove_edge(*ite, rn);
+		}
+		
+		timer.start("trivial_vertices");
+		rn.remove_trivial_vertices();
+		timer.stop();
+		
+		ChinesePostman::RouteNetworkList graph_divisions;
+		timer.start("components");
+		rn.connectedcomponents(graph_divisions);
+		timer.stop();
+		
+		std::vector<ChinesePostman::DistanceMatrix> distance_tables(graph_divisions.size());
+		timer.start("shortest_paths");
+		ChinesePostman::parallel_for(graph_divisions.size(), matching_options.num_threads, [&](size_t id){
+			std::vector<ChinesePostman::Graph::vertex_descriptor> odd_vertices;
+			graph_divisions[id].odd_vertex_candidates(odd_vertices);
+			ChinesePostman::terminal_shortest_distances(graph_divisions[id], odd_vertices, distance_tables[id]);
+		});
+		timer.stop();
+		
+		std::vector< std::deque<ChinesePostman::SubRoute> > doubled_edges(graph_divisions.size());
+		timer.start("matching");
+		ChinesePostman::parallel_for(graph_divisions.size(), matching_options.effective_num_threads(), [&](size_t id){
+			graph_divisions[id].find_doubled_edges(distance_tables[id], doubled_edges[id], matching_options);
+		});
+		timer.stop();
+		
+		doubled_distance = 0;
+		for(size_t id = 0; id < doubled_edges.size(); ++id){
+			for(std::deque<ChinesePostman::SubRoute>::const_iterator its = doubled_edges[id].begin(); its != doubled_edges[id].end(); ++its){
+				doubled_distance += its->weight;
+			}
+		}
+	}
+	
+	// 辺の変更を1本ずつ反映して解き直す。距離を増やす・減らす・閉じる（閉じた辺なら開く）をランダムに選ぶ。
+	// 変更のたびに（計測の外で）、変更後の路線網（閉じた辺を除く）を最初から解いた結果と比べる
+	size_t resolved_components = 0;
+	size_t failed_update = 0; // 結果が食い違った最初の変更（1から数える。0なら食い違いなし）
+	{
+		ChinesePostman::CompactGraph graph;
+		ChinesePostman::read_from(binary_filename.c_str(), graph);
+		if(num_updates > 0 && graph.num_edges() > 0){
+			timer.start("incremental_build");
+			ChinesePostman::IncrementalSolver solver(graph, matching_options);
+			timer.stop();
+			
+			auto solve_from_scratch = [&](){
+				ChinesePostman::CompactGraph::Builder builder;
+				builder.reserve_vertices(graph.num_vertices());
+				for(ChinesePostman::EdgeId e = 0; e < graph.num_edges(); ++e){
+					if(!solver.closed(e)) builder.add_edge(graph.edge_source(e), graph.edge_target(e), solver.edge_weight(e));
+				}
+				ChinesePostman::CompactGraph modified;
+				builder.build(modified);
+				ChinesePostman::IncrementalSolver fresh(modified, matching_options);
+				return fresh.doubled_distance();
+			};
+			
+			std::mt19937 generator(synthetic_options.seed);
+			for(size_t u = 0; u < num_updates; ++u){
+				ChinesePostman::EdgeId e = static_cast<ChinesePostman::EdgeId>(generator() % graph.num_edges());
+				switch(generator() % 3){
+				case 0:
+					solver.set_edge_weight(e, solver.edge_weight(e) * 2 + 1);
+					break;
+				case 1:
+					solver.set_edge_weight(e, std::max<ChinesePostman::EdgeWeightType>(1, solver.edge_weight(e) / 2));
+					break;
+				default:
+					if(solver.closed(e)) solver.open_edge(e); else solver.close_edge(e);
+					break;
+				}
+				timer.start("incremental_update");
+				resolved_components += solver.resolve();
+				timer.stop();
+				
+				if(failed_update == 0 && solve_from_scratch() != solver.doubled_distance()) failed_update = u + 1;
+			}
+		}
+	}
+	
+	// カットの組み合わせは、グラフとは別に合成した問題で計測する
+	typedef ChinesePostman::BasicCutCombiner<boost::uint64_t> CutCombiner;
+	std::vector<CutCombiner::CostTable> cut_costs;
+	std::vector<CutCombiner::CutEdge> cut_problem_edges;
+	make_cut_problem(cut_parts, cut_edges, 12, synthetic_options.seed, cut_costs, cut_problem_edges);
+	size_t max_states = 0;
+	for(size_t r = 0; r < repeat; ++r){
+		CutCombiner combiner(cut_costs, cut_problem_edges);
+		timer.start("cut_combining");
+		combiner.solve();
+		timer.stop();
+		max_states = combiner.max_states();
+	}
+	
+	std::cout << "# doubled_distance = " << doubled_distance << std::endl;
+	std::cout << "# cut_max_states = " << max_states << std::endl;
+	std::cout << "# resolved_components = " << resolved_components << std::endl;
+	timer.write(std::cout);
+	if(failed_update != 0){
+		std::cerr << "Error: IncrementalSolver gave a different result from solving the updated network from scratch (update " << failed_update << ")" << std::endl;
+		return 1;
+	}
+	
+	if(!keep_files){
+		if(input_filename == NULL) std::remove(text_filename.c_str());
+		std::remove(binary_filename.c_str());
+	}
+	return 0;
+}
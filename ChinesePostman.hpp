@@ -1,509 +1,1200 @@
-#ifndef CHINESE_POSTMAN_HPP_
-#define CHINESE_POSTMAN_HPP_
-
-#include "ChinesePostmanUtil.hpp"
-#include "masked_vector.hpp"
-#include <glpk.h>
-#include <boost/graph/undirected_graph.hpp>
-#include <boost/graph/connected_components.hpp>
-#include <boost/graph/filtered_graph.hpp>
-#include <boost/graph/floyd_warshall_shortest.hpp>
-#include <map>
-#include <set>
-#include <deque>
-#include <vector>
-
-//#define CHINESE_POSTMAN_DEBUG_DUMP // řvZʂ̏ڍׂ\ꍇ
-//#define CHINESE_POSTMAN_DEBUG_PROGRESS // řvZǂ̒xił邩\ꍇ
-
-namespace ChinesePostman{
-	// HԂ`NXB
-	class RouteNetwork : public Graph{
-	public:
-		RouteNetwork() : Graph(){
-			// Do nothing
-			
-			// t@C̓ǂݍ݂ ChinesePostmanUtil.hpp
-			// read_fromQ
-		}
-		
-		// ------------------------------------------------------------
-		// [eBeB
-		// ------------------------------------------------------------
-		
-		// _ƕӂ^A_ӂH̒_ԂB
-		// ^ꂽ_ӂ̂ǂ̒[_łȂꍇ́Anull_vertexԂB
-		vertex_descriptor vertex_target(vertex_descriptor vertex, edge_descriptor edge) const{
-			vertex_descriptor n1 = source(edge, *this);
-			vertex_descriptor n2 = target(edge, *this);
-			
-			if(vertex == n1) return n2;
-			if(vertex == n2) return n1;
-			return null_vertex();
-		}
-		
-		// _^A̖OԂB
-		const std::string & vertexname(vertex_descriptor vertex) const{
-			return boost::get(boost::vertex_name, *this, vertex);
-		}
-		
-		// ӂ^A̒_̖OԂB
-		const std::string & vertexname1_fromedge(edge_descriptor edge) const{
-			return boost::get(boost::vertex_name, *this, boost::source(edge, *this));
-		}
-		const std::string & vertexname2_fromedge(edge_descriptor edge) const{
-			return boost::get(boost::vertex_name, *this, boost::target(edge, *this));
-		}
-		
-		// ӂ^A̋ԂB
-		EdgeWeightType edgeweight(edge_descriptor edge) const{
-			return boost::get(boost::edge_weight, *this, edge);
-		}
-		
-		// ioH̏ŕKv̂Ȃj2̒_ȒPB
-		void remove_trivial_vertices(){
-			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
-			edge_descriptor links[2]; // 2̒_oĂ
-			vertex_descriptor sides[2]; // L̕ӂ̍sł钸_
-			std::vector<vertex_descriptor> removed_vertices;
-			size_t i;
-			EdgeWeightType distance;
-			
-			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
-				if(out_degree(*itv, *this) == 2){
-					std::pair<out_edge_iterator, out_edge_iterator> edge_range = boost::out_edges(*itv, *this);
-					i = 0;
-					distance = 0;
-					for(out_edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite, ++i){
-						sides[i] = vertex_target(*itv, *ite);
-						distance += edgeweight(*ite);
-						links[i] = *ite;
-					}
-					if(links[0] == links[1]) continue; // _1Eӂ1̗
-					boost::add_edge(sides[0], sides[1], distance, *this);
-					boost::remove_edge(links[0], *this);
-					boost::remove_edge(links[1], *this);
-					removed_vertices.push_back(*itv);
-				}
-			}
-			
-			for(std::vector<vertex_descriptor>::iterator itv = removed_vertices.begin(); itv != removed_vertices.end(); ++itv){
-				boost::remove_vertex(*itv, *this);
-			}
-		}
-		
-		// AɕʂԂB
-		// ʂ͑1Ɋi[B
-		// ܂2ɂ́AũOtɂ钸_VKɐ_vƂ
-		// lAzz񂪊i[B
-		void connectedcomponents(RouteNetworkList & division_result, VertexMapping & vertex_mapping) const{
-			size_t i;
-			vertex_mapping.clear();
-			
-			// ʂi[邽߂map
-			ComponentMap compomap;
-			boost::associative_property_map<ComponentMap> prop_compomap(compomap);
-			
-			// _ɔԍt邽߂map
-			// http://stackoverflow.com/questions/15432104/how-to-create-a-propertymap-for-a-boost-graph-using-lists-as-vertex-container
-			ComponentMap indexmap;
-			boost::associative_property_map<ComponentMap> prop_indexmap(indexmap);
-			i = 0;
-			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
-			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
-				put(prop_indexmap, *itv, i);
-				++i;
-			}
-			size_t componum = boost::connected_components(*this, prop_compomap, boost::vertex_index_map(prop_indexmap));
-			
-			// O[vꂽʂpāAۂɕꂽOt
-			division_result.clear();
-			division_result.resize(componum, RouteNetwork());
-			
-			for(size_t gr = 0; gr < componum; ++gr){
-				// w肳ꂽ̃O[vԍ̒_A
-				// Ȃтɐڂ钸_w肳ꂽO[vԍłӂ
-				// oOt𓾂
-				GraphDivision part_graph(*this, EdgeInGroup(*this, compomap, gr), VertexInGroup(compomap, gr));
-				
-				// GraphDivisioniboost::filtered_graphĵ܂܂
-				// [VtCh@gȂۂ̂
-				// RouteNetworkiboost::adjacency_listjɕϊB
-				// vertex_mapping vertex_mapping[part_graph̒_] = division_result[gr]̒_ ̑ΉtB
-				division_result[gr] = RouteNetwork();
-				
-				std::pair<GraphDivision::vertex_iterator, GraphDivision::vertex_iterator> vertex_range_part = boost::vertices(part_graph);
-				for(GraphDivision::vertex_iterator itv = vertex_range_part.first; itv != vertex_range_part.second; ++itv){
-					vertex_mapping[*itv] = boost::add_vertex(vertexname(*itv), division_result[gr]);
-				}
-				std::pair<GraphDivision::edge_iterator, GraphDivision::edge_iterator> edge_range_part = boost::edges(part_graph);
-				for(GraphDivision::edge_iterator ite = edge_range_part.first; ite != edge_range_part.second; ++ite){
-					boost::add_edge(vertex_mapping[boost::source(*ite, *this)], vertex_mapping[boost::target(*ite, *this)], edgeweight(*ite), division_result[gr]);
-				}
-			}
-		}
-		
-		inline void connectedcomponents(RouteNetworkList & division_result) const{
-			VertexMapping vertex_mapping;
-			connectedcomponents(division_result, vertex_mapping);
-		}
-		
-		// ̕ӂ2̑gݍ킹ŁAŏɂȂ悤
-		// ̂߂B
-		// ʂ͈ɏpush_backB
-		// 
-		// 
-		// TODO: ꂽOẗꕔΏۂƂꍇA
-		//       _̎̔肪uɎgӂ1ʂ邩
-		//       2ʂ邩vɈˑ邽߁A
-		//       n悤ɂ
-		struct unexpected_graph_exception{};
-		
-		bool find_doubled_edges(const DistanceMatrix & distance_table, std::deque<SubRoute> & result, const masked_vector<ChinesePostman::Graph::vertex_descriptor> & border_vertices, const std::map<ChinesePostman::Graph::vertex_descriptor, size_t> & border_vertices_count) const{
-			size_t temp_id, i, j;
-			
-			// ̒_W߂
-			std::set<Graph::vertex_descriptor> odd_vertices;
-			std::pair<Graph::vertex_iterator, Graph::vertex_iterator> vertex_range = boost::vertices(*this);
-			for(Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
-				bool appearing_as_mask;
-				size_t pos = border_vertices.index_orig(*itv, appearing_as_mask);
-				if((boost::out_degree(*itv, *this) + (pos != border_vertices.size() ? border_vertices_count.at(*itv) : 0) + (appearing_as_mask ? 1 : 0)) % 2 == 1){
-					odd_vertices.insert(*itv);
-				}
-			}
-			if(odd_vertices.size() % 2 == 1){
-				// ̒_Ȃ
-				// ͏󋵂ɂBborder_verticesłȂȂOA
-				// łȂΒPɉɏIB
-				if(border_vertices.size() == 0){
-					std::cerr << "Unexpected Error: odd_vertices.size() == " << odd_vertices.size() << " (Expected an even number)" << std::endl;
-					throw unexpected_graph_exception();
-				}else{
-					return false;
-				}
-			}
-			// ̒_ȂiOt͂łɃIC[Otj
-			// Ȃ΁A2ʂӂ͂Ȃ
-			if(odd_vertices.size() == 0) return true;
-			
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			std::cerr << "[DEBUG]   Size: #vertices = " << boost::num_vertices(*this) << " (#odd_vertices = " << odd_vertices.size() << "), #edges = " << boost::num_edges(*this) << ", vertex[0] = " << rn.vertexname(*(boost::vertices(*this).first)) << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-			
-			// ---------- v@ŉ ----------
-			glp_prob *mip = glp_create_prob();
-			glp_set_obj_dir(mip, GLP_MIN);
-			
-			glp_add_rows(mip, odd_vertices.size());
-			
-			// _injɊւ鐧uŏ}b`OɂĕK1񂸂gv
-			temp_id = 1;
-			for(std::set<Graph::vertex_descriptor>::iterator itv = odd_vertices.begin(); itv != odd_vertices.end(); ++itv){
-				glp_set_row_bnds(mip, temp_id, GLP_FX, 1.0, 1.0);
-				++temp_id;
-			}
-			
-			// _̑gin_C_2jɊւ鐧uŏ}b`OɂčX1gv
-			size_t combinations = odd_vertices.size() * (odd_vertices.size() - 1) / 2;
-			glp_add_cols(mip, combinations);
-			std::vector<int> ia(combinations*2 + 1), ja(combinations*2 + 1);
-			std::vector<double> ar(combinations*2 + 1);
-			
-			temp_id = 1;
-			i = 1;
-			double val_coef;
-			
-			for(std::set<Graph::vertex_descriptor>::iterator itv1 = odd_vertices.begin(); itv1 != odd_vertices.end(); ++itv1){
-				std::set<Graph::vertex_descriptor>::iterator itv2 = itv1;
-				++itv2;
-				j = i + 1;
-				for(; itv2 != odd_vertices.cend(); ++itv2){
-					glp_set_col_kind(mip, temp_id, GLP_BV);
-					
-					val_coef = (double)(distance_table.at(*itv1).at(*itv2));
-					glp_set_obj_coef(mip, temp_id, val_coef);
-					
-					ia[temp_id] = i; ja[temp_id] = temp_id; ar[temp_id] = 1.0;
-					ia[temp_id+combinations] = j; ja[temp_id+combinations] = temp_id; ar[temp_id+combinations] = 1.0;
-					
-					// TODO:uitv1`itv2̍ŒZoH̓_r2ȏʂȂ΁A̔Cӂ2̑gݍ킹͌ʂɏoĂ͂ȂȂvŕ\
-					
-					++temp_id;
-					++j;
-				}
-				++i;
-			}
-			glp_load_matrix(mip, combinations*2, &(ia[0]), &(ja[0]), &(ar[0]));
-			
-			glp_iocp parm;
-			glp_init_iocp(&parm);
-			parm.presolve = GLP_ON;
-			
-			// GLPKɉ
-			int err = glp_intopt(mip, &parm);
-			if(err != 0){
-				std::cerr << "GLPK Error (Reason: " << err << ")" << std::endl;
-				glp_delete_prob(mip); // TODO: RAIIɂ邽߂Ƀbp[
-				return false;
-			}
-			
-			// GLPKɉʂ𓾂
-#if defined(CHINESE_POSTMAN_DEBUG_DUMP) || defined(CHINESE_POSTMAN_DEBUG_PROGRESS)
-			double opt_result = 
-#endif
-			glp_mip_obj_val(mip);
-			
-#if defined(CHINESE_POSTMAN_DEBUG_DUMP) || defined(CHINESE_POSTMAN_DEBUG_PROGRESS)
-			std::cout << "Z: " << opt_result << std::endl;
-#endif
-			
-			double varpos;
-			
-			temp_id = 1;
-			for(std::set<Graph::vertex_descriptor>::iterator itv1 = odd_vertices.begin(); itv1 != odd_vertices.end(); ++itv1){
-				std::set<Graph::vertex_descriptor>::iterator itv2 = itv1;
-				++itv2;
-				for(; itv2 != odd_vertices.end(); ++itv2){
-					varpos = glp_mip_col_val(mip, temp_id);
-					// varpos͖{01A_ŏo邱Ƃl
-					if(varpos > 0.5){
-						result.push_back(
-							SubRoute(
-								vertexname(*itv1), vertexname(*itv2),
-								distance_table.at(*itv1).at(*itv2)));
-					}
-					
-					++temp_id;
-				}
-			}
-			glp_delete_prob(mip);
-			return true;
-		}
-		
-		inline void find_doubled_edges(const DistanceMatrix & distance_table, std::deque<SubRoute> & result) const{
-			masked_vector<ChinesePostman::Graph::vertex_descriptor> border_vertices;
-			std::map<ChinesePostman::Graph::vertex_descriptor, size_t> border_vertices_count;
-			find_doubled_edges(distance_table, result, border_vertices, border_vertices_count);
-		}
-		
-		// Ot̓eo͂B
-		void print(std::ostream & os) const{
-			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
-			
-			os << "Vertices:";
-			if(vertex_range.first == vertex_range.second){
-				os << " (None)" << std::endl;
-			}else{
-				for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
-					os << " " << vertexname(*itv);
-				}
-				os << std::endl;
-			}
-			
-			std::pair<edge_iterator, edge_iterator> edge_range = boost::edges(*this);
-			
-			if(edge_range.first == edge_range.second){
-				os << "  (No edge contained)" << std::endl;
-			}else{
-				for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
-					os << "  Edge: "  << vertexname(boost::source(*ite, *this)) << " - " << vertexname(boost::target(*ite, *this)) << " (Distance = " << edgeweight(*ite) << ")" << std::endl;
-				}
-			}
-		}
-		
-		void print() const{
-			print(std::cout);
-		}
-		
-		void print_bridge_list(std::ostream & os) const{
-			std::pair<edge_iterator, edge_iterator> edge_range = boost::edges(*this);
-			
-			for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
-				os << edgeweight(*ite) << " " << vertexname(boost::source(*ite, *this)) << " " << vertexname(boost::target(*ite, *this)) << std::endl;
-			}
-		}
-		
-		void print_bridge_list() const{
-			print_bridge_list(std::cout);
-		}
-	};
-	
-	// i̕1{ȂȂƘAłȂȂ悤ȕӁjoB
-	// http://nupioca.hatenadiary.jp/entry/2013/11/03/200006
-	class BridgeDetector{
-		std::map<Graph::vertex_descriptor, size_t> pre_, low_;
-		size_t count_;
-		std::set<Graph::edge_descriptor> result_;
-		const RouteNetwork & rn_;
-		
-		void detect_bridges_main(Graph::vertex_descriptor vertex, boost::optional<Graph::out_edge_iterator> ite_from_parent){
-			// łprevertex܂܂Ăꍇ͉Ȃ
-			if(pre_.find(vertex) != pre_.end()) return;
-			
-			// Vԍ蓖Ă
-			pre_[vertex] = count_;
-			low_[vertex] = count_;
-			++count_;
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			//if(count_ % 10 == 0) std::cerr << "[DEBUG]   Processing " << count_ << " vertices" << std::endl;
-			std::cerr << "[DEBUG]   Processing station " << rn_.vertexname(vertex) << " (" << count_ << ")" << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-			Graph::vertex_descriptor target;
-			std::pair<Graph::out_edge_iterator, Graph::out_edge_iterator> edge_range = boost::out_edges(vertex, rn_);
-			for(Graph::out_edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
-				if(ite_from_parent && *ite == *(ite_from_parent.get())) continue;
-				
-				target = rn_.vertex_target(vertex, *ite);
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-				std::cerr << "[DEBUG]     Searching: " << rn_.vertexname(vertex) << " -> " << rn_.vertexname(target) << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-				detect_bridges_main(target, boost::make_optional(ite));
-				low_[vertex] = std::min(low_[vertex], low_[target]);
-			}
-			
-			if(ite_from_parent && low_[vertex] == pre_[vertex]){
-				result_.insert(*(ite_from_parent.get()));
-			}
-		}
-		
-	public:
-		BridgeDetector(const RouteNetwork & rn) : count_(0), rn_(rn) {
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			std::cerr << "[DEBUG] Detecting Bridges ..." << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-			detect_bridges_main(*(boost::vertices(rn_).first), boost::optional<Graph::out_edge_iterator>());
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			std::cerr << "[DEBUG] Completed Detecting Bridges!" << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-		}
-		
-		const std::set<Graph::edge_descriptor> & result() const{
-			return result_;
-		}
-	};
-	
-	class Solver{
-	private:
-		// ̌opB
-		// ił邽߂2ʂKv̂Ӂj p_bd->result() œ
-		std::unique_ptr<BridgeDetector> p_bd;
-		
-		// ̈ꗗ
-		std::deque<SubRoute> brigdes_;
-		// ȊO2ʂKv̂ӂ̈ꗗ
-		std::deque<SubRoute> doubled_edges_;
-		
-	public:
-		int run(RouteNetwork & rn){
-			brigdes_.clear();
-			doubled_edges_.clear();
-			
-			// o
-			p_bd = std::unique_ptr<BridgeDetector>(new BridgeDetector(rn));
-			
-			// 񋓂ʂƂĊi[ǍOt\\
-			for(std::set<Graph::edge_descriptor>::iterator ite = p_bd->result().begin(); ite != p_bd->result().end(); ++ite){
-				brigdes_.push_back(
-					SubRoute(
-						rn.vertexname(boost::source(*ite, rn)),
-						rn.vertexname(boost::target(*ite, rn)),
-						rn.edgeweight(*ite)));
-				boost::remove_edge(*ite, rn);
-			}
-			
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-			std::cout << std::endl;
-			std::cout << "[Graph Structure Without Bridges]" << std::endl;
-			rn.print();
-			std::cout << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			
-			// 2̒_ĂOt\\
-			rn.remove_trivial_vertices();
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-			std::cout << std::endl;
-			std::cout << "[Graph Structure Without Trivial Nodes]" << std::endl;
-			rn.print();
-			std::cout << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			
-			// Ot𕪊ĂOt\\
-			RouteNetworkList graph_divisions;
-			VertexMapping vmap;
-			rn.connectedcomponents(graph_divisions, vmap);
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-			std::cout << "[Graph Structure After Divided into Connected Components]" << std::endl;
-			for(RouteNetworkList::iterator itg = graph_divisions.begin(); itg != graph_divisions.end(); ++itg){
-				itg->print();
-			}
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			
-			// eOtɃ[VtCh@KpǍʂ\
-			std::map<RouteNetworkList::iterator, DistanceMatrix> floyd_warshall_table;
-			
-#if defined(CHINESE_POSTMAN_DEBUG_PROGRESS)
-			std::cerr << "[DEBUG] Calculating Shortest Paths..." << std::endl;
-#elif defined(CHINESE_POSTMAN_DEBUG_DUMP)
-			std::cout << "[Shortest Paths]" << std::endl;
-#endif
-			for(RouteNetworkList::iterator itg = graph_divisions.begin(); itg != graph_divisions.end(); ++itg){
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-				std::cerr << "[DEBUG]   Size: #vertices = " << boost::num_vertices(*itg) << ", #edges = " << boost::num_edges(*itg) << ", vertex[0] = " << rn.vertexname(*(boost::vertices(*itg).first)) << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-				boost::floyd_warshall_all_pairs_shortest_paths(*itg, floyd_warshall_table[itg]);
-
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-				std::cout << "Graph (number of vertex(vertices): " << num_vertices(*itg) << "):" << std::endl;
-				for(std::map<RouteNetworkList::iterator, DistanceMatrix>::iterator itr1 = floyd_warshall_table[itg].begin(); itr1 != floyd_warshall_table[itg].end(); ++itr1){
-					std::cout << "Shortest paths from " << itg->vertexname(itr1->first) << ":" << std::endl;
-					for(std::map<RouteNetworkList::iterator, DistanceMatrix>::iterator itr2 = itr1->second.begin(); itr2 != itr1->second.end(); ++itr2){
-						std::cout << "    " << itg->vertexname(itr2->first) << ": " << itr2->second << std::endl;
-					}
-				}
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			}
-#if defined(CHINESE_POSTMAN_DEBUG_PROGRESS)
-			std::cerr << "[DEBUG] Completed Calculating Shortest Paths!" << std::endl;
-#elif defined(CHINESE_POSTMAN_DEBUG_DUMP)
-			std::cout << std::endl;
-#endif
-			
-			// ̒_W߂āAŏ}b`O߂
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			glp_term_out(GLP_ON);
-#else
-			glp_term_out(GLP_OFF);
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-			
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			std::cerr << "[DEBUG] Calculating Minimum Matching..." << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-			for(RouteNetworkList::iterator itg = graph_divisions.begin(); itg != graph_divisions.end(); ++itg){
-				itg->find_doubled_edges(floyd_warshall_table[itg], doubled_edges_);
-			}
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-			std::cerr << "[DEBUG] Completed Calculating Minimum Matching!" << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-			
-			return 0;
-		}
-		
-		Solver(){
-			// Do nothing
-		}
-		
-		Solver(RouteNetwork & rn){
-			run(rn);
-		}
-		
-		const std::deque<SubRoute> & bridges() const{
-			return brigdes_;
-		}
-		const std::deque<SubRoute> & doubled_edges() const{
-			return doubled_edges_;
-		}
-	};
-} // namespace ChinesePostman
-
-#endif // CHINESE_POSTMAN_HPP_
+#ifndef CHINESE_POSTMAN_HPP_
+#define CHINESE_POSTMAN_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include "masked_vector.hpp"
+#include "PerfectMatching.hpp"
+#include "ShortestPaths.hpp"
+#include "ThreadPool.hpp"
+#include "PostmanTour.hpp"
+#ifdef CHINESE_POSTMAN_USE_GLPK
+#include <glpk.h>
+#endif // CHINESE_POSTMAN_USE_GLPK
+#include <boost/graph/undirected_graph.hpp>
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+
+namespace ChinesePostman{
+	// 路線網を定義するクラス。
+	// 頂点の名前（駅名の表での番号）に対応する駅名の表と、縮約した辺の表を共有して持つ。
+	class RouteNetwork : public Graph{
+	private:
+		std::shared_ptr<const NameTable> names_;
+		std::shared_ptr<const EdgeChainTable> chains_;
+		
+	public:
+		RouteNetwork() : Graph(), names_(std::make_shared<NameTable>()), chains_(std::make_shared<EdgeChainTable>()){
+			// Do nothing
+			
+			// ファイルの読み込みは read_from(const char *, RouteNetwork &) を参照
+		}
+		
+		// 駅名の表（頂点の名前はこの表での番号）
+		inline const NameTable & names() const{ return *names_; }
+		inline std::shared_ptr<const NameTable> shared_names() const{ return names_; }
+		inline void set_names(std::shared_ptr<const NameTable> names){ names_ = names; }
+		
+		// 縮約した辺の表（辺の縮約はremove_trivial_verticesを参照）
+		inline const EdgeChainTable & chains() const{ return *chains_; }
+		inline void set_chains(std::shared_ptr<const EdgeChainTable> chains){ chains_ = chains; }
+		
+		// ------------------------------------------------------------
+		// ユーティリティ
+		// ------------------------------------------------------------
+		
+		// 頂点と辺を与え、頂点から辺を辿った先の頂点を返す。
+		// 与えられた頂点が辺のどちらの端点でもなかった場合は、null_vertexを返す。
+		vertex_descriptor vertex_target(vertex_descriptor vertex, edge_descriptor edge) const{
+			vertex_descriptor n1 = source(edge, *this);
+			vertex_descriptor n2 = target(edge, *this);
+			
+			if(vertex == n1) return n2;
+			if(vertex == n2) return n1;
+			return null_vertex();
+		}
+		
+		// 頂点を与え、その駅名の表での番号を返す。
+		inline VertexId vertexid(vertex_descriptor vertex) const{
+			return boost::get(boost::vertex_name, *this, vertex);
+		}
+		
+		// 頂点を与え、その名前を返す。
+		inline boost::string_ref vertexname(vertex_descriptor vertex) const{
+			return names_->name(vertexid(vertex));
+		}
+		
+		// 辺を与え、その頂点の名前を返す。
+		inline boost::string_ref vertexname1_fromedge(edge_descriptor edge) const{
+			return vertexname(boost::source(edge, *this));
+		}
+		inline boost::string_ref vertexname2_fromedge(edge_descriptor edge) const{
+			return vertexname(boost::target(edge, *this));
+		}
+		
+		// 辺を与え、その距離を返す。
+		EdgeWeightType edgeweight(edge_descriptor edge) const{
+			return boost::get(boost::edge_weight, *this, edge);
+		}
+		
+		// 辺を与え、縮約した辺の表での番号を返す（縮約していない元の辺なら0）。
+		inline EdgeId edgechain(edge_descriptor edge) const{
+			return boost::get(boost::edge_chain, *this, edge);
+		}
+		
+		// 辺を、その端の頂点fromの側から元の駅の区間に展開し、
+		// 順に visitor(出発する駅, 距離, 到着する駅) に渡す（駅は駅名の表での番号）。
+		template <class SectionVisitor>
+		void expand_edge(edge_descriptor edge, vertex_descriptor from, SectionVisitor visitor) const{
+			EdgeId chain = edgechain(edge);
+			if(chain == 0){
+				visitor(vertexid(from), edgeweight(edge), vertexid(vertex_target(from, edge)));
+			}else{
+				chains_->for_each_section(chain, vertexid(from), visitor);
+			}
+		}
+		
+		// CompactGraphに変換する。頂点の番号は駅名の表での番号と同じで、駅名の表も共有する
+		// （表にあってこのグラフにない駅は、辺を持たない頂点になる）。
+		void to_compact_graph(CompactGraph & result) const{
+			CompactGraph::Builder builder;
+			std::pair<edge_iterator, edge_iterator> edge_range = boost::edges(*this);
+			for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+				builder.add_edge(vertexid(boost::source(*ite, *this)), vertexid(boost::target(*ite, *this)), edgeweight(*ite));
+			}
+			builder.build(result, names_);
+		}
+		
+		// （経路決定の上で必要のない）次数2の頂点を除去し簡単化する。
+		// 次数2の頂点が続く道（両端は次数2でない頂点）をそれぞれ一度だけ辿って1本の辺に縮約する。
+		// 縮約した辺が通る元の駅の列は縮約した辺の表に格納する（expand_edgeを参照）。
+		// すでに縮約した辺をさらに縮約する場合は、元の駅の列をつなげる。
+		// すべての頂点が次数2の輪は、1つの頂点（番号が最小のもの）とその自己ループにする。
+		// 残る頂点（のvertex_descriptor）は変わらない。
+		// 頂点は番号の順に辿るので、縮約した辺の向きと順は頂点のアドレスによらない
+		// （同じ路線網ならテキスト形式とバイナリ形式のどちらから読んでも同じ結果になる）。
+		void remove_trivial_vertices(){
+			enum { VERTEX_KEPT, VERTEX_TRIVIAL, VERTEX_PASSED };
+			
+			// 頂点の名前（駅名の表での番号）を添字として、頂点の状態を持つ
+			VertexId id_limit = 0;
+			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				id_limit = std::max(id_limit, vertexid(*itv) + 1);
+			}
+			std::vector<unsigned char> state(id_limit, VERTEX_KEPT);
+			std::vector<vertex_descriptor> id_vertex(id_limit, null_vertex()); // 番号→頂点
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				id_vertex[vertexid(*itv)] = *itv;
+			}
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				if(out_degree(*itv, *this) != 2) continue;
+				std::pair<out_edge_iterator, out_edge_iterator> edge_range = boost::out_edges(*itv, *this);
+				if(*(edge_range.first) == *(boost::next(edge_range.first))) continue; // 頂点が1つ・辺が1つの輪
+				state[vertexid(*itv)] = VERTEX_TRIVIAL;
+			}
+			
+			// 縮約した辺の表は作り直す（縮約しないまま残る辺の番号も振り直す）
+			std::shared_ptr<EdgeChainTable> new_chains = std::make_shared<EdgeChainTable>();
+			std::vector<vertex_descriptor> removed_vertices;
+			std::vector< std::pair< std::pair<vertex_descriptor, vertex_descriptor>, EdgeProperty> > new_edges;
+			
+			// 頂点startから辺first_edgeを通り、次数2の頂点を辿って残す頂点まで進み、縮約した辺を作る
+			std::vector< std::pair<vertex_descriptor, edge_descriptor> > path; // 辿った（出発した頂点, 辺）
+			auto contract = [&](vertex_descriptor start, edge_descriptor first_edge){
+				path.clear();
+				vertex_descriptor v = start;
+				edge_descriptor e = first_edge;
+				for(;;){
+					path.push_back(std::make_pair(v, e));
+					v = vertex_target(v, e);
+					if(state[vertexid(v)] != VERTEX_TRIVIAL) break;
+					state[vertexid(v)] = VERTEX_PASSED;
+					removed_vertices.push_back(v);
+					std::pair<out_edge_iterator, out_edge_iterator> edge_range = boost::out_edges(v, *this);
+					e = (*(edge_range.first) == e ? *(boost::next(edge_range.first)) : *(edge_range.first));
+				}
+				
+				if(path.size() == 1 && edgechain(first_edge) == 0) return; // 縮約しない辺はそのまま残す
+				EdgeWeightType distance = 0;
+				new_chains->begin_chain(vertexid(start));
+				for(size_t k = 0; k < path.size(); ++k){
+					EdgeId chain = edgechain(path[k].second);
+					if(chain == 0){
+						new_chains->append(edgeweight(path[k].second), vertexid(vertex_target(path[k].first, path[k].second)));
+					}else{
+						new_chains->append_chain(*chains_, chain, vertexid(path[k].first));
+					}
+					distance += edgeweight(path[k].second);
+				}
+				EdgeId chain = new_chains->end_chain();
+				if(path.size() == 1){
+					boost::put(boost::edge_chain, *this, first_edge, chain);
+				}else{
+					new_edges.push_back(std::make_pair(std::make_pair(start, v), EdgeProperty(distance, EdgeChainProperty(chain))));
+				}
+			};
+			
+			// 残す頂点から出ている道を辿る。
+			// 両端が残す頂点の辺は番号の小さい端から辿ったときだけ、次数2の頂点を含む道は最初に辿ったときだけ扱う。
+			std::vector<edge_descriptor> loops; // 扱った自己ループ（隣接リストに2回現れる）
+			for(VertexId id = 0; id < id_limit; ++id){
+				if(id_vertex[id] == null_vertex() || state[id] != VERTEX_KEPT) continue;
+				vertex_descriptor v = id_vertex[id];
+				loops.clear();
+				std::pair<out_edge_iterator, out_edge_iterator> edge_range = boost::out_edges(v, *this);
+				for(out_edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+					vertex_descriptor next = vertex_target(v, *ite);
+					if(state[vertexid(next)] == VERTEX_PASSED) continue;
+					if(state[vertexid(next)] == VERTEX_KEPT){
+						if(id > vertexid(next)) continue;
+						if(next == v){
+							if(std::find(loops.begin(), loops.end(), *ite) != loops.end()) continue;
+							loops.push_back(*ite);
+						}
+					}
+					contract(v, *ite);
+				}
+			}
+			
+			// 残りは、すべての頂点が次数2の輪。番号が最小の頂点だけ残し、輪を一周する自己ループにする
+			for(VertexId id = 0; id < id_limit; ++id){
+				if(id_vertex[id] == null_vertex() || state[id] != VERTEX_TRIVIAL) continue;
+				state[id] = VERTEX_KEPT;
+				contract(id_vertex[id], *(boost::out_edges(id_vertex[id], *this).first));
+			}
+			
+			// 辿った次数2の頂点を（接する辺とともに）除去し、縮約した辺を加える
+			for(std::vector<vertex_descriptor>::iterator itv = removed_vertices.begin(); itv != removed_vertices.end(); ++itv){
+				boost::clear_vertex(*itv, *this);
+				boost::remove_vertex(*itv, *this);
+			}
+			for(size_t k = 0; k < new_edges.size(); ++k){
+				boost::add_edge(new_edges[k].first.first, new_edges[k].first.second, new_edges[k].second, *this);
+			}
+			chains_ = new_chains;
+		}
+		
+		// 連結成分に分割した結果を返す。
+		// 結果は第1引数に格納される。分割したグラフは駅名の表と縮約した辺の表を共有し、頂点の名前（番号）も元のグラフと同じになる。
+		// また第2引数には、元のグラフの各頂点がどの連結成分の、どの頂点になったかが格納される。
+		// 頂点に一度だけ連結成分の番号を付け、その番号で頂点と辺を振り分けるので、計算量は頂点数と辺数に対して線形。
+		void connectedcomponents(RouteNetworkList & division_result, ComponentMapping & mapping) const{
+			const size_t unvisited = ComponentMapping::no_component();
+			
+			// 頂点の名前（駅名の表での番号）を添字として、連結成分の番号を付ける
+			VertexId id_limit = 0;
+			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				id_limit = std::max(id_limit, vertexid(*itv) + 1);
+			}
+			mapping.component.assign(id_limit, unvisited);
+			mapping.vertex.assign(id_limit, null_vertex());
+			
+			size_t componum = 0;
+			std::vector<vertex_descriptor> stack;
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				if(mapping.component[vertexid(*itv)] != unvisited) continue;
+				mapping.component[vertexid(*itv)] = componum;
+				stack.push_back(*itv);
+				while(!stack.empty()){
+					vertex_descriptor v = stack.back();
+					stack.pop_back();
+					std::pair<out_edge_iterator, out_edge_iterator> edge_range = boost::out_edges(v, *this);
+					for(out_edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+						vertex_descriptor w = vertex_target(v, *ite);
+						if(mapping.component[vertexid(w)] == unvisited){
+							mapping.component[vertexid(w)] = componum;
+							stack.push_back(w);
+						}
+					}
+				}
+				++componum;
+			}
+			
+			// 番号を用いて頂点と辺を連結成分ごとに並べ（計数ソート）、連結成分ごとにグラフを作る。
+			// 頂点の集合はアドレス順に並ぶ（setS）ので、連結成分ごとにまとめて頂点を追加し、
+			// 分割したグラフでも元のグラフと同じ順に頂点が並ぶようにする。
+			std::vector<size_t> vertex_begin(componum + 1, 0), edge_begin(componum + 1, 0);
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				++vertex_begin[mapping.component[vertexid(*itv)] + 1];
+			}
+			std::pair<edge_iterator, edge_iterator> edge_range = boost::edges(*this);
+			for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+				++edge_begin[mapping.component[vertexid(boost::source(*ite, *this))] + 1];
+			}
+			for(size_t gr = 0; gr < componum; ++gr){
+				vertex_begin[gr + 1] += vertex_begin[gr];
+				edge_begin[gr + 1] += edge_begin[gr];
+			}
+			std::vector<vertex_descriptor> sorted_vertices(vertex_begin[componum]);
+			std::vector<edge_descriptor> sorted_edges(edge_begin[componum]);
+			{
+				std::vector<size_t> vertex_pos(vertex_begin.begin(), vertex_begin.end() - 1), edge_pos(edge_begin.begin(), edge_begin.end() - 1);
+				for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+					sorted_vertices[vertex_pos[mapping.component[vertexid(*itv)]]++] = *itv;
+				}
+				for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+					sorted_edges[edge_pos[mapping.component[vertexid(boost::source(*ite, *this))]]++] = *ite;
+				}
+			}
+			
+			division_result.clear();
+			RouteNetwork empty;
+			empty.set_names(names_);
+			empty.chains_ = chains_;
+			division_result.resize(componum, empty);
+			
+			for(size_t gr = 0; gr < componum; ++gr){
+				for(size_t k = vertex_begin[gr]; k < vertex_begin[gr + 1]; ++k){
+					VertexId id = vertexid(sorted_vertices[k]);
+					mapping.vertex[id] = boost::add_vertex(id, division_result[gr]);
+				}
+				for(size_t k = edge_begin[gr]; k < edge_begin[gr + 1]; ++k){
+					boost::add_edge(
+						mapping.vertex[vertexid(boost::source(sorted_edges[k], *this))],
+						mapping.vertex[vertexid(boost::target(sorted_edges[k], *this))],
+						EdgeProperty(edgeweight(sorted_edges[k]), EdgeChainProperty(edgechain(sorted_edges[k]))), division_result[gr]);
+				}
+			}
+		}
+		
+		inline void connectedcomponents(RouteNetworkList & division_result) const{
+			ComponentMapping mapping;
+			connectedcomponents(division_result, mapping);
+		}
+		
+		// 奇数次になりうる頂点（find_doubled_edgesで距離を参照する頂点）を列挙する。
+		// border_verticesの頂点は、マスクによって次数の偶奇が変わるので常に含める。
+		template <class MaskType>
+		void odd_vertex_candidates(std::vector<vertex_descriptor> & result, const masked_vector<vertex_descriptor, MaskType> & border_vertices) const{
+			result.clear();
+			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
+			for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				if(border_vertices.index_orig(*itv) != border_vertices.size()){
+					result.push_back(*itv);
+				}else if(boost::out_degree(*itv, *this) % 2 == 1){
+					result.push_back(*itv);
+				}
+			}
+		}
+		
+		inline void odd_vertex_candidates(std::vector<vertex_descriptor> & result) const{
+			odd_vertex_candidates(result, masked_vector<vertex_descriptor, boost::uint64_t>());
+		}
+		
+		// 奇数次の辺の2つずつの組み合わせで、距離が最小になるような
+		// ものを求める。
+		// 結果は引数に順次push_backされる。
+		// 最小マッチングの求め方はoptionsで指定する（既定はblossomアルゴリズム）。
+		// 
+		// TODO: 分割されたグラフの一部を対象とする場合、
+		//       頂点の次数の判定が「分割に使った辺を1回通るか
+		//       2回通るか」に依存するため、それを引数で
+		//       渡せるようにする
+		struct unexpected_graph_exception{};
+		struct unsupported_backend_exception{};
+		
+		// memoが与えられた場合、同じ奇数次の頂点の集合について以前に求めた結果があればそれを使う。
+		template <class MaskType>
+		bool find_doubled_edges(const DistanceMatrix & distance_table, std::deque<SubRoute> & result, const masked_vector<ChinesePostman::Graph::vertex_descriptor, MaskType> & border_vertices, const std::map<ChinesePostman::Graph::vertex_descriptor, size_t> & border_vertices_count, const MatchingOptions & options = MatchingOptions(), MatchingMemo * memo = NULL) const{
+			// 奇数次数の頂点を集める
+			std::set<Graph::vertex_descriptor> odd_vertices;
+			std::pair<Graph::vertex_iterator, Graph::vertex_iterator> vertex_range = boost::vertices(*this);
+			for(Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				bool appearing_as_mask;
+				size_t pos = border_vertices.index_orig(*itv, appearing_as_mask);
+				if((boost::out_degree(*itv, *this) + (pos != border_vertices.size() ? border_vertices_count.at(*itv) : 0) + (appearing_as_mask ? 1 : 0)) % 2 == 1){
+					odd_vertices.insert(*itv);
+				}
+			}
+			if(odd_vertices.size() % 2 == 1){
+				// 奇数次の頂点が奇数個しかない
+				// これは状況による。border_verticesが空でないなら例外、
+				// そうでなければ単に何もせずに終了。
+				if(border_vertices.size() == 0){
+					std::cerr << "Unexpected Error: odd_vertices.size() == " << odd_vertices.size() << " (Expected an even number)" << std::endl;
+					throw unexpected_graph_exception();
+				}else{
+					return false;
+				}
+			}
+			// 奇数次の頂点がない（グラフはすでにオイラーグラフ）
+			// ならば、2回通る辺はない
+			if(odd_vertices.size() == 0) return true;
+			
+			if(dumping(options.instrumentation)){
+				std::ostringstream text;
+				text << "Matching: #vertices = " << boost::num_vertices(*this) << " (#odd_vertices = " << odd_vertices.size() << "), #edges = " << boost::num_edges(*this) << ", vertex[0] = " << vertexname(*(boost::vertices(*this).first)) << std::endl;
+				options.instrumentation->dump(text.str());
+			}
+			
+			// 以前に同じ奇数次の頂点の集合について求めていれば、その結果を使う
+			MatchingMemo::Key key;
+			if(memo != NULL){
+				for(std::set<Graph::vertex_descriptor>::iterator itv = odd_vertices.begin(); itv != odd_vertices.end(); ++itv){
+					key.push_back(distance_table.index(*itv));
+				}
+				std::sort(key.begin(), key.end());
+				std::map< MatchingMemo::Key, std::deque<SubRoute> >::iterator itm = memo->results.find(key);
+				if(itm != memo->results.end()){
+					++(memo->hits);
+					count(options.instrumentation, "matching_memo_hits");
+					result.insert(result.end(), itm->second.begin(), itm->second.end());
+					return true;
+				}
+			}
+			
+			count(options.instrumentation, "matchings");
+			count(options.instrumentation, "matching_odd_vertices", static_cast<long long>(odd_vertices.size()));
+			std::deque<SubRoute> new_result;
+			if(options.backend == MATCHING_GLPK){
+#ifdef CHINESE_POSTMAN_USE_GLPK
+				if(!find_doubled_edges_glpk(distance_table, odd_vertices, new_result, options.instrumentation)) return false;
+#else
+				std::cerr << "ERROR: GLPK backend is not available (compile with -DCHINESE_POSTMAN_USE_GLPK)" << std::endl;
+				throw unsupported_backend_exception();
+#endif // CHINESE_POSTMAN_USE_GLPK
+			}else{
+				find_doubled_edges_blossom(distance_table, odd_vertices, new_result, options.candidate_neighbors, memo, options.instrumentation);
+			}
+			
+			result.insert(result.end(), new_result.begin(), new_result.end());
+			if(memo != NULL) memo->results[key].swap(new_result);
+			return true;
+		}
+		
+		// 奇数次の頂点の最小完全マッチングを、blossomアルゴリズムで求める。
+		// candidate_neighborsについてはMatchingOptionsを参照。
+		// memoが与えられた場合、直前に求めたマッチングのうち今回も奇数次である頂点同士の組を
+		// 最初から候補に加え（境界の頂点のマスクが少し変わっただけなら、ほとんどの組はそのまま使える）、
+		// 今回求めたマッチングをmemoに記録する。
+		// instrumentationが与えられた場合、かかった時間と候補の組の数を記録する。
+		bool find_doubled_edges_blossom(const DistanceMatrix & distance_table, const std::set<Graph::vertex_descriptor> & odd_vertices, std::deque<SubRoute> & result, size_t candidate_neighbors, MatchingMemo * memo = NULL, Instrumentation * instrumentation = NULL) const{
+			ScopedPhase phase(instrumentation, "matching_blossom", false);
+			std::vector<Graph::vertex_descriptor> odd_list(odd_vertices.begin(), odd_vertices.end());
+			std::vector<size_t> odd_index; // odd_list[i]のdistance_table上での番号
+			size_t i, j;
+			
+			for(i = 0; i < odd_list.size(); ++i){
+				odd_index.push_back(distance_table.index(odd_list[i]));
+			}
+			
+			std::vector< std::pair<size_t, size_t> > initial_candidates;
+			if(memo != NULL && !memo->last_matching.empty()){
+				std::vector<size_t> position(distance_table.size(), odd_list.size()); // distance_table上の番号→odd_list上の番号
+				for(i = 0; i < odd_list.size(); ++i) position[odd_index[i]] = i;
+				for(std::vector< std::pair<size_t, size_t> >::iterator itp = memo->last_matching.begin(); itp != memo->last_matching.end(); ++itp){
+					if(position[itp->first] != odd_list.size() && position[itp->second] != odd_list.size()){
+						initial_candidates.push_back(std::make_pair(position[itp->first], position[itp->second]));
+					}
+				}
+			}
+			
+			std::vector<size_t> mate;
+			CompleteMatchingStatistics statistics;
+			bool solved = solve_complete_matching(
+				odd_list.size(),
+				[&](size_t v1, size_t v2){ return distance_table(odd_index[v1], odd_index[v2]); },
+				candidate_neighbors, mate, &initial_candidates, (instrumentation != NULL ? &statistics : NULL));
+			count(instrumentation, "matching_rounds", static_cast<long long>(statistics.rounds));
+			count(instrumentation, "matching_columns", static_cast<long long>(statistics.columns));
+			if(!solved) return false;
+			
+			if(memo != NULL){
+				memo->last_matching.clear();
+				for(i = 0; i < odd_list.size(); ++i){
+					if(mate[i] > i) memo->last_matching.push_back(std::make_pair(odd_index[i], odd_index[mate[i]]));
+				}
+			}
+			
+			// GLPK版と同じ順序で結果を並べる
+			for(i = 0; i < odd_list.size(); ++i){
+				j = mate[i];
+				if(j > i){
+					result.push_back(
+						SubRoute(
+							vertexid(odd_list[i]), vertexid(odd_list[j]),
+							distance_table(odd_index[i], odd_index[j])));
+				}
+			}
+			return true;
+		}
+		
+#ifdef CHINESE_POSTMAN_USE_GLPK
+		// 奇数次の頂点の最小完全マッチングを、GLPKを用いて整数計画法で求める。
+		// 結果の検算用。instrumentationが与えられた場合、かかった時間と変数（列）の数を記録する。
+		bool find_doubled_edges_glpk(const DistanceMatrix & distance_table, const std::set<Graph::vertex_descriptor> & odd_vertices, std::deque<SubRoute> & result, Instrumentation * instrumentation = NULL) const{
+			ScopedPhase phase(instrumentation, "matching_glpk", false);
+			size_t temp_id, i, j;
+			
+			// ---------- 整数計画法で解く ----------
+			glp_prob *mip = glp_create_prob();
+			glp_set_obj_dir(mip, GLP_MIN);
+			
+			glp_add_rows(mip, odd_vertices.size());
+			
+			// 頂点（n個）に関する制約「最小マッチングにおいて必ず1回ずつ使う」
+			temp_id = 1;
+			for(std::set<Graph::vertex_descriptor>::iterator itv = odd_vertices.begin(); itv != odd_vertices.end(); ++itv){
+				glp_set_row_bnds(mip, temp_id, GLP_FX, 1.0, 1.0);
+				++temp_id;
+			}
+			
+			// 頂点の組（n_C_2個）に関する制約「最小マッチングにおいて高々1回使う」
+			size_t combinations = odd_vertices.size() * (odd_vertices.size() - 1) / 2;
+			glp_add_cols(mip, combinations);
+			count(instrumentation, "matching_rounds");
+			count(instrumentation, "matching_columns", static_cast<long long>(combinations));
+			std::vector<int> ia(combinations*2 + 1), ja(combinations*2 + 1);
+			std::vector<double> ar(combinations*2 + 1);
+			
+			temp_id = 1;
+			i = 1;
+			double val_coef;
+			
+			for(std::set<Graph::vertex_descriptor>::iterator itv1 = odd_vertices.begin(); itv1 != odd_vertices.end(); ++itv1){
+				std::set<Graph::vertex_descriptor>::iterator itv2 = itv1;
+				++itv2;
+				j = i + 1;
+				for(; itv2 != odd_vertices.cend(); ++itv2){
+					glp_set_col_kind(mip, temp_id, GLP_BV);
+					
+					val_coef = (double)(distance_table.at(*itv1, *itv2));
+					glp_set_obj_coef(mip, temp_id, val_coef);
+					
+					ia[temp_id] = i; ja[temp_id] = temp_id; ar[temp_id] = 1.0;
+					ia[temp_id+combinations] = j; ja[temp_id+combinations] = temp_id; ar[temp_id+combinations] = 1.0;
+					
+					// TODO:「itv1～itv2の最短経路が奇数次の点を途中で2つ以上通るならば、それらの任意の2つの組み合わせは結果に出てはならない」を式で表す
+					
+					++temp_id;
+					++j;
+				}
+				++i;
+			}
+			glp_load_matrix(mip, combinations*2, &(ia[0]), &(ja[0]), &(ar[0]));
+			
+			glp_iocp parm;
+			glp_init_iocp(&parm);
+			parm.presolve = GLP_ON;
+			
+			// GLPKに解かせる
+			int err = glp_intopt(mip, &parm);
+			if(err != 0){
+				std::cerr << "GLPK Error (Reason: " << err << ")" << std::endl;
+				glp_delete_prob(mip); // TODO: RAIIにするためにラッパーを書く
+				return false;
+			}
+			
+			// GLPKに解かせた結果を得る
+			if(dumping(instrumentation)){
+				std::ostringstream text;
+				text << "GLPK objective value: " << glp_mip_obj_val(mip) << std::endl;
+				instrumentation->dump(text.str());
+			}
+			
+			double varpos;
+			
+			temp_id = 1;
+			for(std::set<Graph::vertex_descriptor>::iterator itv1 = odd_vertices.begin(); itv1 != odd_vertices.end(); ++itv1){
+				std::set<Graph::vertex_descriptor>::iterator itv2 = itv1;
+				++itv2;
+				for(; itv2 != odd_vertices.end(); ++itv2){
+					varpos = glp_mip_col_val(mip, temp_id);
+					// varposは本来は0か1だけだが、小数点で出ることを考慮して
+					if(varpos > 0.5){
+						result.push_back(
+							SubRoute(
+								vertexid(*itv1), vertexid(*itv2),
+								distance_table.at(*itv1, *itv2)));
+					}
+					
+					++temp_id;
+				}
+			}
+			glp_delete_prob(mip);
+			return true;
+		}
+#endif // CHINESE_POSTMAN_USE_GLPK
+		
+		inline void find_doubled_edges(const DistanceMatrix & distance_table, std::deque<SubRoute> & result, const MatchingOptions & options = MatchingOptions()) const{
+			masked_vector<ChinesePostman::Graph::vertex_descriptor, boost::uint64_t> border_vertices;
+			std::map<ChinesePostman::Graph::vertex_descriptor, size_t> border_vertices_count;
+			find_doubled_edges(distance_table, result, border_vertices, border_vertices_count, options);
+		}
+		
+		// グラフの内容を出力する。
+		void print(std::ostream & os) const{
+			std::pair<vertex_iterator, vertex_iterator> vertex_range = boost::vertices(*this);
+			
+			os << "Vertices:";
+			if(vertex_range.first == vertex_range.second){
+				os << " (None)" << std::endl;
+			}else{
+				for(vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+					os << " " << vertexname(*itv);
+				}
+				os << std::endl;
+			}
+			
+			std::pair<edge_iterator, edge_iterator> edge_range = boost::edges(*this);
+			
+			if(edge_range.first == edge_range.second){
+				os << "  (No edge contained)" << std::endl;
+			}else{
+				for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+					os << "  Edge: "  << vertexname(boost::source(*ite, *this)) << " - " << vertexname(boost::target(*ite, *this)) << " (Distance = " << edgeweight(*ite) << ")" << std::endl;
+				}
+			}
+		}
+		
+		void print() const{
+			print(std::cout);
+		}
+		
+		void print_bridge_list(std::ostream & os) const{
+			std::pair<edge_iterator, edge_iterator> edge_range = boost::edges(*this);
+			
+			for(edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+				os << edgeweight(*ite) << " " << vertexname(boost::source(*ite, *this)) << " " << vertexname(boost::target(*ite, *this)) << std::endl;
+			}
+		}
+		
+		void print_bridge_list() const{
+			print_bridge_list(std::cout);
+		}
+	};
+	
+	// RouteNetworkにファイルの内容を読み込む。ファイルの形式と返り値はread_edges_fromを参照。
+	// namesが与えられた場合はその駅名の表に駅名を登録して共有する
+	// （複数のファイルを同じ表で読み込めば、同じ駅は同じ番号になる）。
+	// バイナリ形式のファイルは駅名と辺を解釈し直さずに、配列から頂点と辺を加える。
+	// このときnamesが空なら、ファイルの駅名を（コピーせずに）参照する表をそのままnamesにする。
+	// compactが与えられた場合は、同じ路線網をCompactGraphとしても格納する（頂点の番号はrnと同じ）。
+	// バイナリ形式のファイルでnamesが空だった場合は、マップした配列と記録された橋・連結成分をそのまま使う。
+	EdgeWeightType read_from(const char * fname, RouteNetwork & rn, std::shared_ptr<NameTable> names = std::shared_ptr<NameTable>(), CompactGraph * compact = NULL){
+		if(!names) names = std::make_shared<NameTable>();
+		rn.set_names(names);
+		
+		std::shared_ptr<boost::interprocess::mapped_region> region;
+		if(!map_file(fname, region)) return 0;
+		if(!GraphFile::is_graph_file(region->get_address(), region->get_size())){
+			region.reset();
+			EdgeWeightType total_distance = read_from(fname, static_cast<Graph &>(rn), *names);
+			if(compact != NULL && total_distance != 0) rn.to_compact_graph(*compact);
+			return total_distance;
+		}
+		
+		GraphFile file;
+		if(!file.attach(region, fname)) return 0;
+		if(!file.has_names()){
+			std::cerr << "ERROR: Given file \"" << fname << "\" has no station names" << std::endl;
+			return 0;
+		}
+		
+		// ファイルでの頂点の番号→namesでの番号
+		std::vector<VertexId> ids(file.num_vertices());
+		bool same_ids = (names->size() == 0);
+		if(same_ids){
+			*names = NameTable(file.name_chars(), file.name_offsets(), file.num_vertices(), file.owner());
+			for(VertexId v = 0; v < file.num_vertices(); ++v) ids[v] = v;
+		}else{
+			for(VertexId v = 0; v < file.num_vertices(); ++v) ids[v] = names->intern(file.name(v));
+		}
+		
+		// テキスト形式と同じく、辺の順に、初めて現れた駅を頂点として加える。
+		// 頂点はアドレス順に並ぶので、頂点の並びは形式によって変わりうる。
+		// 出力の順や向きは頂点の番号で決めること（remove_trivial_vertices・DivideByBridge.cppを参照）
+		rn.clear();
+		std::vector<Graph::vertex_descriptor> vertices(file.num_vertices(), Graph::null_vertex());
+		auto vertex = [&](VertexId v){
+			if(vertices[v] == Graph::null_vertex()) vertices[v] = boost::add_vertex(ids[v], rn);
+			return vertices[v];
+		};
+		const VertexId * sources = file.edge_sources();
+		const VertexId * targets = file.edge_targets();
+		const EdgeWeightType * weights = file.edge_weights();
+		EdgeWeightType total_distance = 0;
+		for(EdgeId e = 0; e < file.num_edges(); ++e){
+			Graph::vertex_descriptor v1 = vertex(sources[e]);
+			Graph::vertex_descriptor v2 = vertex(targets[e]);
+			boost::add_edge(v1, v2, EdgeProperty(weights[e]), rn);
+			total_distance += weights[e];
+		}
+		
+		if(compact != NULL){
+			if(same_ids){
+				attach_graph_file(file, *compact, names);
+			}else{
+				rn.to_compact_graph(*compact);
+			}
+		}
+		return total_distance;
+	}
+	
+	// CompactGraphのうち、excluded_edgesで真の辺を除いた部分を連結成分ごとのRouteNetworkにし、次数2の頂点を縮約する。
+	// RouteNetworkから辺を除去してremove_trivial_verticesとconnectedcomponentsを呼んだのと同じグラフになるが、
+	// 元のグラフは変更も複製もしない（次数と縮約する道をCompactGraph上で求め、縮約後の頂点と辺だけを加える）。
+	// 結果のグラフの頂点の名前はgraphでの番号で、駅名の表と縮約した辺の表を共有する。辺を持たない頂点は含まない。
+	// 連結成分は、含む頂点の番号の最小値の順に並ぶ。
+	// component_verticesが与えられた場合、(*component_vertices)[k]にresult[k]の縮約前の頂点（次数2の頂点も含む）を格納する。
+	void contracted_components(const CompactGraph & graph, const std::vector<bool> * excluded_edges, RouteNetworkList & result, std::vector< std::vector<VertexId> > * component_vertices = NULL){
+		enum { VERTEX_ISOLATED, VERTEX_KEPT, VERTEX_TRIVIAL, VERTEX_PASSED };
+		const EdgeId no_edge = static_cast<EdgeId>(graph.num_edges());
+		auto excluded = [&](EdgeId e){ return excluded_edges != NULL && (*excluded_edges)[e]; };
+		
+		// 除いた辺を数えずに次数を求める。自己ループ1本だけの頂点は縮約しない
+		std::vector<unsigned char> state(graph.num_vertices(), VERTEX_ISOLATED);
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			size_t degree = 0;
+			EdgeId first = no_edge, second = no_edge;
+			for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+				EdgeId e = graph.adjacent_edge(pos);
+				if(excluded(e)) continue;
+				if(degree == 0) first = e; else if(degree == 1) second = e;
+				++degree;
+			}
+			if(degree > 0) state[v] = (degree == 2 && first != second ? VERTEX_TRIVIAL : VERTEX_KEPT);
+		}
+		
+		// 辺を持つ連結成分だけに、番号の小さい頂点から順に結果の番号を振る
+		std::vector<size_t> component;
+		std::vector<size_t> index(connected_components(graph, component, excluded_edges), ComponentMapping::no_component());
+		size_t num_results = 0;
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			if(state[v] != VERTEX_ISOLATED && index[component[v]] == ComponentMapping::no_component()) index[component[v]] = num_results++;
+		}
+		
+		std::shared_ptr<EdgeChainTable> chains = std::make_shared<EdgeChainTable>();
+		result.clear();
+		RouteNetwork empty;
+		empty.set_names(graph.shared_names());
+		empty.set_chains(chains);
+		result.resize(num_results, empty);
+		if(component_vertices != NULL){
+			component_vertices->assign(num_results, std::vector<VertexId>());
+			for(VertexId v = 0; v < graph.num_vertices(); ++v){
+				if(state[v] != VERTEX_ISOLATED) (*component_vertices)[index[component[v]]].push_back(v);
+			}
+		}
+		
+		std::vector<Graph::vertex_descriptor> descriptor(graph.num_vertices(), Graph::null_vertex());
+		auto add_vertex = [&](VertexId v){
+			descriptor[v] = boost::add_vertex(v, result[index[component[v]]]);
+		};
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			if(state[v] == VERTEX_KEPT) add_vertex(v);
+		}
+		
+		// 次数2の頂点vに辺eから入ったときに、出ていく辺
+		auto next_edge = [&](VertexId v, EdgeId e){
+			for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+				EdgeId f = graph.adjacent_edge(pos);
+				if(f != e && !excluded(f)) return f;
+			}
+			return no_edge;
+		};
+		
+		// 頂点startから辺first_edgeを通り、次数2の頂点を辿って残す頂点まで進み、縮約した辺を加える
+		auto contract = [&](VertexId start, EdgeId first_edge){
+			EdgeId e = first_edge;
+			VertexId v = graph.opposite(e, start);
+			EdgeWeightType distance = graph.edge_weight(e);
+			EdgeId chain = 0; // 縮約しない辺はそのまま加える
+			if(state[v] == VERTEX_TRIVIAL){
+				chains->begin_chain(start);
+				chains->append(graph.edge_weight(e), v);
+				while(state[v] == VERTEX_TRIVIAL){
+					state[v] = VERTEX_PASSED;
+					e = next_edge(v, e);
+					v = graph.opposite(e, v);
+					chains->append(graph.edge_weight(e), v);
+					distance += graph.edge_weight(e);
+				}
+				chain = chains->end_chain();
+			}
+			boost::add_edge(descriptor[start], descriptor[v], EdgeProperty(distance, EdgeChainProperty(chain)), result[index[component[start]]]);
+		};
+		
+		// 残す頂点から出ている道を辿る（扱い方はRouteNetwork::remove_trivial_verticesと同じ）。
+		// 自己ループは隣接リストに続けて2回現れるので、1回目だけ扱う
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			if(state[v] != VERTEX_KEPT) continue;
+			for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+				EdgeId e = graph.adjacent_edge(pos);
+				if(excluded(e)) continue;
+				VertexId next = graph.adjacent_vertex(pos);
+				if(state[next] == VERTEX_PASSED) continue;
+				if(state[next] == VERTEX_KEPT){
+					if(v > next) continue;
+					if(next == v && pos > graph.adjacency_begin(v) && graph.adjacent_edge(pos - 1) == e) continue;
+				}
+				contract(v, e);
+			}
+		}
+		
+		// 残りは、すべての頂点が次数2の輪。最初に見つけた頂点だけ残し、輪を一周する自己ループにする
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			if(state[v] != VERTEX_TRIVIAL) continue;
+			state[v] = VERTEX_KEPT;
+			add_vertex(v);
+			contract(v, next_edge(v, no_edge));
+		}
+	}
+	
+	// 分割後の連結要素について、境界の頂点のマスク（RouteNetwork::find_doubled_edgesを参照）ごとに、
+	// 最小マッチングを求める前に分かること（実現可能か、2回通る辺の距離の下限）を求める。
+	//
+	// 境界の頂点以外の奇数次の頂点はマスクによらないので、マスクごとには境界の頂点だけを調べればよい。
+	// 奇数次の頂点の数が奇数になるマスクは実現できない（find_doubled_edgesがfalseを返す）。
+	// 下限には、次の2つの大きい方を用いる。
+	// ・奇数次の各頂点から最も近い別の奇数次の頂点までの距離の和の半分
+	// 　（マッチングで組になる2頂点の距離は、それぞれの最も近い奇数次の頂点までの距離の平均以上）
+	// ・既に求めたマスクm'での距離（add_referenceで与えたもの）から、マスクmとm'でビットが異なる境界の頂点同士の
+	// 　最小マッチングの距離を引いたものの最大値（マスクmの解とその最小マッチングの経路を重ねると、マスクm'の解になるため）。
+	// 　この最小マッチングは、境界の頂点がmax_join_table_vertices()個以下の場合に、全ての部分集合について先に求めておく
+	// distance_tableは、奇数次になりうる頂点（RouteNetwork::odd_vertex_candidatesを参照）の間の距離を含むこと。
+	template <class MaskType>
+	class BorderMaskBound{
+	private:
+		typedef masked_vector<Graph::vertex_descriptor, MaskType> BorderVector;
+		
+		const DistanceMatrix & distance_table_;
+		std::vector<size_t> fixed_odd_; // 境界の頂点以外の奇数次の頂点（distance_table上の番号）
+		std::vector<size_t> border_index_; // 境界の頂点（distance_table上の番号）
+		std::vector<unsigned char> border_odd_; // マスクのビットが立っていない場合に、境界の頂点が奇数次か
+		std::vector<EdgeWeightType> fixed_nearest_; // fixed_odd_の頂点から、最も近い別のfixed_odd_の頂点までの距離
+		std::vector<EdgeWeightType> border_nearest_; // 境界の頂点から、最も近いfixed_odd_の頂点までの距離
+		size_t parity_; // マスクのビットが立っていない場合の、奇数次の頂点の数の偶奇
+		std::vector<EdgeWeightType> border_join_; // 境界の頂点の部分集合（ビットで表す）ごとの最小マッチングの距離
+		std::vector< std::pair<size_t, EdgeWeightType> > references_; // 既に求めたマスク（ビットで表す）と距離
+		
+		static EdgeWeightType infinite_distance(){
+			return std::numeric_limits<EdgeWeightType>::max();
+		}
+		
+		// border_join_を求める境界の頂点の数の上限（表の大きさは2^(境界の頂点の数)）
+		static size_t max_join_table_vertices(){ return 20; }
+		
+		// マスクのビットが立つ境界の頂点の集合をビットで表す（境界の頂点がmax_join_table_vertices()個以下の場合のみ使う）
+		size_t border_subset(const BorderVector & border_vertices) const{
+			size_t result = 0;
+			for(size_t b = 0; b < border_index_.size(); ++b){
+				if(border_vertices.has(b)) result |= static_cast<size_t>(1) << b;
+			}
+			return result;
+		}
+		
+		// 最も番号の小さい頂点の相手を決めながら、部分集合の小さい順に求める（頂点が奇数個の部分集合は無限大）
+		void make_border_join(){
+			size_t n = border_index_.size();
+			border_join_.assign(static_cast<size_t>(1) << n, infinite_distance());
+			border_join_[0] = 0;
+			for(size_t subset = 1; subset < border_join_.size(); ++subset){
+				size_t i = 0;
+				while(((subset >> i) & 1) == 0) ++i;
+				for(size_t j = i + 1; j < n; ++j){
+					if(((subset >> j) & 1) == 0) continue;
+					EdgeWeightType rest = border_join_[subset & ~(static_cast<size_t>(1) << i) & ~(static_cast<size_t>(1) << j)];
+					if(rest == infinite_distance()) continue;
+					border_join_[subset] = std::min(border_join_[subset], rest + distance_table_(border_index_[i], border_index_[j]));
+				}
+			}
+		}
+	
+	public:
+		BorderMaskBound(const RouteNetwork & component, const DistanceMatrix & distance_table, const BorderVector & border_vertices, const std::map<Graph::vertex_descriptor, size_t> & border_vertices_count)
+		: distance_table_(distance_table), border_index_(border_vertices.size()), border_odd_(border_vertices.size()), parity_(0){
+			std::pair<Graph::vertex_iterator, Graph::vertex_iterator> vertex_range = boost::vertices(component);
+			for(Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+				size_t pos = border_vertices.index_orig(*itv);
+				if(pos != border_vertices.size()){
+					border_index_[pos] = distance_table_.index(*itv);
+					border_odd_[pos] = static_cast<unsigned char>((boost::out_degree(*itv, component) + border_vertices_count.at(*itv)) % 2);
+					parity_ += border_odd_[pos];
+				}else if(boost::out_degree(*itv, component) % 2 == 1){
+					fixed_odd_.push_back(distance_table_.index(*itv));
+					++parity_;
+				}
+			}
+			parity_ %= 2;
+			
+			fixed_nearest_.assign(fixed_odd_.size(), infinite_distance());
+			border_nearest_.assign(border_index_.size(), infinite_distance());
+			for(size_t i = 0; i < fixed_odd_.size(); ++i){
+				for(size_t j = 0; j < fixed_odd_.size(); ++j){
+					if(i != j) fixed_nearest_[i] = std::min(fixed_nearest_[i], distance_table_(fixed_odd_[i], fixed_odd_[j]));
+				}
+				for(size_t b = 0; b < border_index_.size(); ++b){
+					border_nearest_[b] = std::min(border_nearest_[b], distance_table_(border_index_[b], fixed_odd_[i]));
+				}
+			}
+			if(border_index_.size() <= max_join_table_vertices()) make_border_join();
+		}
+		
+		// border_verticesに設定されたマスクで求めた2回通る辺の距離を与え、ほかのマスクの下限に用いる。
+		// lower_boundと同時に呼んではならない
+		void add_reference(const BorderVector & border_vertices, EdgeWeightType distance){
+			if(border_join_.empty()) return;
+			references_.push_back(std::make_pair(border_subset(border_vertices), distance));
+		}
+		
+		// border_verticesに設定されたマスクで、奇数次の頂点が偶数個になるか
+		bool feasible(const BorderVector & border_vertices) const{
+			size_t parity = parity_;
+			for(size_t b = 0; b < border_index_.size(); ++b){
+				if(border_vertices.has(b)) ++parity;
+			}
+			return parity % 2 == 0;
+		}
+		
+		// border_verticesに設定されたマスクでの、2回通る辺の距離の下限
+		EdgeWeightType lower_bound(const BorderVector & border_vertices) const{
+			std::vector<size_t> odd_border;
+			for(size_t b = 0; b < border_index_.size(); ++b){
+				if((border_odd_[b] != 0) != border_vertices.has(b)) odd_border.push_back(b);
+			}
+			
+			EdgeWeightType sum = 0;
+			for(size_t i = 0; i < fixed_odd_.size(); ++i){
+				EdgeWeightType nearest = fixed_nearest_[i];
+				for(std::vector<size_t>::const_iterator itb = odd_border.begin(); itb != odd_border.end(); ++itb){
+					nearest = std::min(nearest, distance_table_(fixed_odd_[i], border_index_[*itb]));
+				}
+				if(nearest != infinite_distance()) sum += nearest;
+			}
+			for(std::vector<size_t>::const_iterator itb = odd_border.begin(); itb != odd_border.end(); ++itb){
+				EdgeWeightType nearest = border_nearest_[*itb];
+				for(std::vector<size_t>::const_iterator itc = odd_border.begin(); itc != odd_border.end(); ++itc){
+					if(itc != itb) nearest = std::min(nearest, distance_table_(border_index_[*itb], border_index_[*itc]));
+				}
+				if(nearest != infinite_distance()) sum += nearest;
+			}
+			EdgeWeightType result = (sum + 1) / 2;
+			
+			if(!references_.empty()){
+				size_t subset = border_subset(border_vertices);
+				for(std::vector< std::pair<size_t, EdgeWeightType> >::const_iterator itr = references_.begin(); itr != references_.end(); ++itr){
+					EdgeWeightType join = border_join_[subset ^ itr->first];
+					if(join < itr->second) result = std::max(result, itr->second - join);
+				}
+			}
+			return result;
+		}
+	};
+	
+	// 橋（その辺1本がなくなると連結でなくなるような辺）を検出する。
+	// http://nupioca.hatenadiary.jp/entry/2013/11/03/200006
+	// 実際の計算はCompactGraphに変換してbridge_edgesで行う。
+	// 結果の橋はグラフの辺の列挙順に並ぶ。
+	class BridgeDetector{
+		std::vector<Graph::edge_descriptor> result_;
+		
+		void detect(const RouteNetwork & rn){
+			CompactGraph compact;
+			std::vector<Graph::edge_descriptor> edges;
+			make_compact_graph(rn, compact, NULL, &edges);
+			
+			std::vector<EdgeId> bridges;
+			bridge_edges(compact, bridges);
+			result_.reserve(bridges.size());
+			for(std::vector<EdgeId>::iterator ite = bridges.begin(); ite != bridges.end(); ++ite){
+				result_.push_back(edges[*ite]);
+			}
+		}
+		
+	public:
+		BridgeDetector(const RouteNetwork & rn){
+			detect(rn);
+		}
+		
+		// originalは、rnの次数2の頂点を除去する前の路線網（頂点の番号はrnと同じ。read_fromを参照）。
+		// originalにファイルに記録された橋があれば、橋を求め直さずにそれを用いてrnの橋を決める。
+		// 次数2の頂点が続く道の辺は、すべてが橋かすべてが橋でないかのどちらかなので、
+		// 縮約した辺は元の最初の区間で判定できる（多重辺はどれも橋ではないので、区間の両端を結ぶどの辺で判定してもよい）。
+		BridgeDetector(const RouteNetwork & rn, const CompactGraph & original){
+			if(!original.has_stored_bridges()){
+				detect(rn);
+				return;
+			}
+			std::vector<bool> is_bridge(original.num_edges(), false);
+			for(size_t k = 0; k < original.num_stored_bridges(); ++k){
+				is_bridge[original.stored_bridges()[k]] = true;
+			}
+			
+			std::pair<Graph::edge_iterator, Graph::edge_iterator> edge_range = boost::edges(rn);
+			for(Graph::edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+				VertexId v1 = rn.vertexid(boost::source(*ite, rn)), v2 = rn.vertexid(boost::target(*ite, rn));
+				EdgeId chain = rn.edgechain(*ite);
+				if(chain != 0){
+					v1 = rn.chains().front(chain);
+					v2 = rn.chains().second(chain);
+				}
+				EdgeId e = original.find_edge(v1, v2);
+				if(e != original.num_edges() && is_bridge[e]) result_.push_back(*ite);
+			}
+		}
+		
+		const std::vector<Graph::edge_descriptor> & result() const{
+			return result_;
+		}
+	};
+	
+	class Solver{
+	private:
+		// 橋の一覧
+		std::deque<SubRoute> brigdes_;
+		// 橋以外で2回通る必要のある辺の一覧
+		std::deque<SubRoute> doubled_edges_;
+		
+		// 最小マッチングの求め方（instrumentationが与えられていれば、runの各段階の時間なども記録する）
+		MatchingOptions matching_options_;
+		
+		// runに与えた路線網。経路の作成に使う
+		CompactGraph network_;
+		
+		// runで最短経路木を記録するか（doubled_route_edgesを参照）と、直前のrunで記録したか
+		bool record_paths_;
+		bool paths_recorded_;
+		// 連結成分ごとの、奇数次の頂点を始点とする最短経路木（成分ごとに頂点と辺の番号を振り直したグラフの上で記録する）
+		std::vector<SubgraphPathTrees> path_trees_;
+		// network_の頂点→その頂点を含む連結成分のpath_trees_での頂点の番号
+		std::vector<VertexId> path_vertex_index_;
+		// doubled_edges_[k]が属する連結成分の番号
+		std::vector<size_t> doubled_edge_components_;
+		// network_での橋の辺の番号
+		std::vector<EdgeId> bridge_edge_ids_;
+		
+	public:
+		// 路線網rnについて解く。rnは変更しない。
+		// 橋の除去・次数2の頂点の縮約・連結成分への分割は、rnから作ったnetwork_の上で
+		// 橋を除く辺の表とcontracted_componentsを用いて行い、rn全体を複製することはない。
+		int run(const RouteNetwork & rn){
+			Instrumentation * instrumentation = matching_options_.instrumentation;
+			brigdes_.clear();
+			doubled_edges_.clear();
+			path_trees_.clear();
+			path_vertex_index_.clear();
+			doubled_edge_components_.clear();
+			bridge_edge_ids_.clear();
+			paths_recorded_ = record_paths_;
+			rn.to_compact_graph(network_);
+			
+			// 橋を検出し、結果として格納する（network_からは除かず、橋の辺の表で除いたものとして扱う）
+			std::vector<bool> is_bridge(network_.num_edges(), false);
+			{
+				ScopedPhase phase(instrumentation, "bridges");
+				bridge_edges(network_, bridge_edge_ids_);
+				for(std::vector<EdgeId>::const_iterator ite = bridge_edge_ids_.begin(); ite != bridge_edge_ids_.end(); ++ite){
+					brigdes_.push_back(SubRoute(network_.edge_source(*ite), network_.edge_target(*ite), network_.edge_weight(*ite)));
+					is_bridge[*ite] = true;
+				}
+			}
+			count(instrumentation, "bridges", static_cast<long long>(brigdes_.size()));
+			
+			// 橋を除いて連結成分に分割し、次数2の頂点を除去
+			RouteNetworkList graph_divisions;
+			std::vector< std::vector<VertexId> > tree_vertices;
+			{
+				ScopedPhase phase(instrumentation, "components");
+				contracted_components(network_, &is_bridge, graph_divisions, (record_paths_ ? &tree_vertices : NULL));
+			}
+			count(instrumentation, "components", static_cast<long long>(graph_divisions.size()));
+			if(dumping(instrumentation)){
+				std::ostringstream text;
+				text << "[Graph Structure After Divided into Connected Components]" << std::endl;
+				for(RouteNetworkList::iterator itg = graph_divisions.begin(); itg != graph_divisions.end(); ++itg){
+					itg->print(text);
+				}
+				instrumentation->dump(text.str());
+			}
+			
+			// 各グラフについて奇数次の頂点同士の最短距離を求める
+			// （連結成分ごとに独立なので、matching_options_.num_threadsのスレッドで並行して求める）
+			std::vector<DistanceMatrix> distance_tables(graph_divisions.size());
+			{
+				ScopedPhase phase(instrumentation, "shortest_paths");
+				
+				// 最短経路木を記録する場合は、奇数次の頂点からの最短距離を（次数2の頂点も含めた）縮約前の連結成分の上で求める。
+				// 橋を渡ると同じ橋を渡らなければ戻れないので、同じ連結成分の頂点の間の最短経路は成分の外に出ない。
+				// 成分ごとにnetwork_から頂点と辺の番号を振り直したグラフを作っておき、Dijkstra法が成分の大きさの分だけで済むようにする。
+				if(record_paths_){
+					path_trees_.resize(graph_divisions.size());
+					path_vertex_index_.assign(network_.num_vertices(), static_cast<VertexId>(network_.num_vertices()));
+					for(size_t id = 0; id < graph_divisions.size(); ++id){
+						path_trees_[id].vertices.swap(tree_vertices[id]);
+						induced_subgraph(network_, path_trees_[id].vertices, &is_bridge, path_vertex_index_, path_trees_[id].graph, path_trees_[id].edges);
+					}
+					for(size_t id = 0; id < graph_divisions.size(); ++id){
+						for(size_t k = 0; k < path_trees_[id].vertices.size(); ++k){
+							path_vertex_index_[path_trees_[id].vertices[k]] = static_cast<VertexId>(k);
+						}
+					}
+				}
+				
+				parallel_for(graph_divisions.size(), matching_options_.num_threads, [&](size_t id){
+					std::vector<Graph::vertex_descriptor> odd_vertices;
+					graph_divisions[id].odd_vertex_candidates(odd_vertices);
+					count(instrumentation, "odd_vertices", static_cast<long long>(odd_vertices.size()));
+					if(record_paths_){
+						std::vector<VertexId> odd_vertex_ids(odd_vertices.size());
+						for(size_t i = 0; i < odd_vertices.size(); ++i){
+							odd_vertex_ids[i] = path_vertex_index_[graph_divisions[id].vertexid(odd_vertices[i])];
+						}
+						distance_tables[id].assign(odd_vertices);
+						path_trees_[id].trees.assign(path_trees_[id].graph.num_vertices(), odd_vertex_ids);
+						terminal_shortest_distances_main(path_trees_[id].graph, odd_vertex_ids, distance_tables[id], &path_trees_[id].trees);
+					}else{
+						terminal_shortest_distances(graph_divisions[id], odd_vertices, distance_tables[id]);
+					}
+				});
+			}
+			if(dumping(instrumentation)){
+				std::ostringstream text;
+				text << "[Shortest Paths]" << std::endl;
+				for(size_t id = 0; id < graph_divisions.size(); ++id){
+					text << "Graph (number of vertex(vertices): " << num_vertices(graph_divisions[id]) << "):" << std::endl;
+					for(size_t i = 0; i < distance_tables[id].size(); ++i){
+						text << "Shortest paths from " << graph_divisions[id].vertexname(distance_tables[id].vertex(i)) << ":" << std::endl;
+						for(size_t j = 0; j < distance_tables[id].size(); ++j){
+							text << "    " << graph_divisions[id].vertexname(distance_tables[id].vertex(j)) << ": " << distance_tables[id](i, j) << std::endl;
+						}
+					}
+				}
+				text << std::endl;
+				instrumentation->dump(text.str());
+			}
+			
+			// 奇数次数の頂点だけ集めて、最小マッチングを求める
+#ifdef CHINESE_POSTMAN_USE_GLPK
+			glp_term_out(instrumentation != NULL && instrumentation->showing_progress() ? GLP_ON : GLP_OFF);
+#endif // CHINESE_POSTMAN_USE_GLPK
+			
+			// 連結成分ごとに別々に求め、連結成分の順に結果をまとめる
+			{
+				ScopedPhase phase(instrumentation, "matching");
+				std::vector< std::deque<SubRoute> > component_doubled_edges(graph_divisions.size());
+				parallel_for(graph_divisions.size(), matching_options_.effective_num_threads(), [&](size_t id){
+					graph_divisions[id].find_doubled_edges(distance_tables[id], component_doubled_edges[id], matching_options_);
+				});
+				for(size_t id = 0; id < graph_divisions.size(); ++id){
+					doubled_edges_.insert(doubled_edges_.end(), component_doubled_edges[id].begin(), component_doubled_edges[id].end());
+					doubled_edge_components_.insert(doubled_edge_components_.end(), component_doubled_edges[id].size(), id);
+				}
+			}
+			
+			return 0;
+		}
+		
+		Solver() : matching_options_(), record_paths_(false), paths_recorded_(false){
+			// Do nothing
+		}
+		
+		Solver(const RouteNetwork & rn, const MatchingOptions & matching_options = MatchingOptions(), bool record_paths = false) : matching_options_(matching_options), record_paths_(record_paths), paths_recorded_(false){
+			run(rn);
+		}
+		
+		void set_matching_options(const MatchingOptions & matching_options){
+			matching_options_ = matching_options;
+		}
+		
+		// 真にすると、runで奇数次の頂点同士の最短経路木も記録する（次のrunから有効）。
+		// 木の大きさは、連結成分ごとの（奇数次の頂点の数）×（頂点の数）。
+		void set_record_paths(bool record_paths){
+			record_paths_ = record_paths;
+		}
+		// 直前のrunで最短経路木を記録したか
+		bool paths_recorded() const{
+			return paths_recorded_;
+		}
+		
+		const std::deque<SubRoute> & bridges() const{
+			return brigdes_;
+		}
+		const std::deque<SubRoute> & doubled_edges() const{
+			return doubled_edges_;
+		}
+		
+		// runに与えた路線網（頂点の番号は駅名の表での番号）
+		const CompactGraph & network() const{
+			return network_;
+		}
+		
+		// 駅startから出発してstartに戻る郵便配達の経路を求め、通る順に1本ずつ
+		// sink(出発する駅, 辺, 到着する駅) に渡す（駅と辺はnetwork()での番号）。
+		// 橋と、橋以外で2回通る区間は、network()上の最短経路に展開してから辿る。
+		// 経路を作れなかった場合はfalseを返す。stepsについてはPostmanTour::writeを参照。
+		// 最短経路木を記録していれば、それを辿る（最短経路を求め直さない）。
+		template <class TourSink>
+		bool tour(VertexId start, TourSink sink, size_t * steps = NULL) const{
+			PostmanTour postman_tour(network_);
+			if(paths_recorded()){
+				for(std::vector<EdgeId>::const_iterator ite = bridge_edge_ids_.begin(); ite != bridge_edge_ids_.end(); ++ite){
+					postman_tour.add_doubled_edge(*ite);
+				}
+				for(size_t k = 0; k < doubled_edges_.size(); ++k){
+					if(!doubled_route_edges(k, [&](VertexId, EdgeId e, VertexId){ postman_tour.add_doubled_edge(e); })) return false;
+				}
+			}else{
+				if(!postman_tour.add_doubled_routes(brigdes_)) return false;
+				if(!postman_tour.add_doubled_routes(doubled_edges_)) return false;
+			}
+			return postman_tour.write(start, sink, steps);
+		}
+		
+		// 橋以外で2回通るk番目の区間（doubled_edges()[k]）を、network()上の辺に展開して
+		// 区間の一方の端から他方の端まで順に visitor(出発する駅, 辺, 到着する駅) に渡す。
+		// runで記録した最短経路木を辿るだけで、最短経路を求め直したり経路を配列に取り出したりはしない。
+		// 最短経路木を記録していない場合（set_record_pathsを参照）はfalseを返す。
+		template <class EdgeVisitor>
+		bool doubled_route_edges(size_t k, EdgeVisitor visitor) const{
+			if(!paths_recorded_ || k >= doubled_edge_components_.size()) return false;
+			const SubRoute & route = doubled_edges_[k];
+			return path_trees_[doubled_edge_components_[k]].for_each_path_edge(path_vertex_index_[route.v1], path_vertex_index_[route.v2], visitor);
+		}
+	};
+} // namespace ChinesePostman
+
+#endif // CHINESE_POSTMAN_HPP_
@@ -1,142 +1,644 @@
-#ifndef CHINESE_POSTMAN_UTIL_HPP_
-#define CHINESE_POSTMAN_UTIL_HPP_
-
-#include <boost/graph/undirected_graph.hpp>
-#include <boost/graph/filtered_graph.hpp>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <map>
-
-namespace ChinesePostman{
-	typedef int EdgeWeightType;
-	typedef boost::adjacency_list<boost::vecS, boost::setS, boost::undirectedS, boost::property<boost::vertex_name_t, std::string>, boost::property<boost::edge_weight_t, EdgeWeightType> > Graph;
-	
-	typedef std::map<Graph::vertex_descriptor, Graph::vertices_size_type> ComponentMap;
-	typedef std::map<Graph::vertex_descriptor, std::map<Graph::vertex_descriptor, EdgeWeightType> > DistanceMatrix;
-	
-	// Ot̘Âo߂̒`B
-	// boost::filtered_graphĩOt̍\Ȃ܂܁AOt
-	// 擾邽߂̃NXjpĂB
-	// http://www.boost.org/doc/libs/1_55_0/libs/graph/doc/filtered_graph.html
-	// 
-	// connectedcomponents\bhŁAComponentMap̃CX^XɁu_L[A
-	// ̒_Ԗڂ̘AɓĂ邩lƂAzzvi[̂ŁA
-	// ^Â̔ԍ݂̂ɑӁE_oB
-	class EdgeInGroup{
-	private:
-		const Graph & source_graph_;
-		const ComponentMap & map_;
-		Graph::vertices_size_type group_id_;
-	public:
-		EdgeInGroup(const Graph & source_graph, const ComponentMap & map, Graph::vertices_size_type group_id) : source_graph_(source_graph), map_(map), group_id_(group_id) {}
-		bool operator()(Graph::edge_descriptor e) const {
-			ComponentMap::const_iterator it = map_.find(boost::source(e, source_graph_));
-			return it != map_.end() && it->second == group_id_;
-		}
-	};
-	
-	class VertexInGroup{
-	private:
-		const ComponentMap & map_;
-		Graph::vertices_size_type group_id_;
-	public:
-		VertexInGroup(const ComponentMap & map, Graph::vertices_size_type group_id) : map_(map), group_id_(group_id) {}
-		bool operator()(Graph::vertex_descriptor v) const {
-			ComponentMap::const_iterator it = map_.find(v);
-			return it != map_.end() && it->second == group_id_;
-		}
-	};
-	
-	class RouteNetwork;
-	typedef boost::filtered_graph<RouteNetwork, EdgeInGroup, VertexInGroup> GraphDivision;
-	typedef std::vector<RouteNetwork> RouteNetworkList;
-	typedef RouteNetworkList::iterator RouteNetworkListIterator;
-	typedef RouteNetworkList::const_iterator RouteNetworkListConstIterator;
-	
-	// Otɕʂ̃OtƂiOt̒oȂǁjA
-	// ̒_Ԃ̑Ή֌W\Azz
-	typedef std::map<Graph::vertex_descriptor, Graph::vertex_descriptor> VertexMapping;
-	
-	// u2_Ƃ̍ŒZoHvi[邽߂̃NX
-	// i_͖OŎwj
-	struct SubRoute{
-		std::string v1, v2;
-		EdgeWeightType weight;
-		
-		SubRoute(std::string vv1, std::string vv2, EdgeWeightType wweight) : v1(vv1), v2(vv2), weight(wweight) {}
-	};
-	
-	// u2_̑gvi[邽߂̃NX
-	// i_vertex_descriptorŎwj
-	struct VirtualEdge{
-		Graph::vertex_descriptor v1, v2;
-		EdgeWeightType weight;
-		
-		VirtualEdge(Graph::vertex_descriptor vv1, Graph::vertex_descriptor vv2, EdgeWeightType wweight)
-		: v1(vv1), v2(vv2), weight(wweight) {}
-		
-		inline bool operator==(const VirtualEdge & other) const{ return(v1 == other.v1 && v2 == other.v2 && weight == other.weight); }
-		inline bool operator<(const VirtualEdge & other) const{ return(v1 < other.v1 || (v1 == other.v1 && (v2 < other.v2 || (v2 == other.v2 && weight < other.weight)))); }
-	};
-	
-	// GraphNX̃CX^XgraphɃt@C̓eǂݍށB
-	// eśu(Ɍ) n_1 n_2vƎw肷B
-	// Ԃl̓Ot̋̑aBG[ꍇ0ԂB
-	EdgeWeightType read_from(const char * fname, Graph & graph){
-		graph.clear();
-		
-		std::ifstream ifs(fname, std::ios::in | std::ios::binary);
-		if(!ifs){
-			std::cerr << "ERROR: Given file \"" << fname << "\" cannot be opened" << std::endl;
-			return 0;
-		}
-		
-		EdgeWeightType distance, total_distance = 0;
-		std::map<std::string, Graph::vertex_descriptor> names2vertices;
-		std::string line, s[2];
-		Graph::vertex_descriptor vd[2];
-		std::map<std::string, Graph::vertex_descriptor>::iterator it;
-		
-		while(!(ifs.eof())){
-			// sǂݍ
-			std::getline(ifs, line);
-			if(line.length() == 0 || line[0] == '#' || line[0] == '\r') continue;
-			
-			std::stringstream sst(line);
-			sst.seekg(0, std::ios_base::beg);
-			sst >> distance;
-			if(distance <= 0){
-				std::cerr << "ERROR: Distance less than zero or invalid distance found" << std::endl;
-				return 0;
-			}
-			sst >> s[0];
-			sst >> s[1];
-			if(s[0].empty() || s[1].empty()){
-				std::cerr << "ERROR: Station name invalid" << std::endl;
-				return 0;
-			}
-			
-			// _ǉi܂݂ĂȂȂj
-			// names2verticeśuwL[A_lƂAzzv
-			for(size_t i = 0; i <= 1; ++i){
-				it = names2vertices.find(s[i]);
-				
-				if(it == names2vertices.end()){
-					vd[i] = boost::add_vertex(s[i], graph);
-					names2vertices.insert(std::make_pair(s[i], vd[i]));
-				}else{
-					vd[i] = it->second;
-				}
-			}
-			
-			// ӂǉ
-			boost::add_edge(vd[0], vd[1], distance, graph);
-			total_distance += distance;
-		}
-		
-		return total_distance;
-	}
-} // namespace ChinesePostman
-
-#endif // CHINESE_POSTMAN_UTIL_HPP_
+#ifndef CHINESE_POSTMAN_UTIL_HPP_
+#define CHINESE_POSTMAN_UTIL_HPP_
+
+#include "Instrumentation.hpp"
+#include <boost/graph/undirected_graph.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <boost/cstdint.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <memory>
+#include <map>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+// 辺のプロパティとして、次数2の頂点を除去して縮約した辺の番号（EdgeChainTableを参照）を持たせる
+namespace boost{
+	enum edge_chain_t { edge_chain };
+	BOOST_INSTALL_PROPERTY(edge, chain);
+}
+
+namespace ChinesePostman{
+	typedef int EdgeWeightType;
+	typedef unsigned int VertexId;
+	typedef unsigned int EdgeId;
+	
+	// 辺の距離と、縮約した辺の番号（縮約していない元の辺は0）
+	typedef boost::property<boost::edge_chain_t, EdgeId> EdgeChainProperty;
+	typedef boost::property<boost::edge_weight_t, EdgeWeightType, EdgeChainProperty> EdgeProperty;
+	
+	// 頂点の名前（vertex_name）は、駅名そのものではなく駅名の表（NameTable）での番号とする。
+	// 駅名の文字列は表に一度だけ格納され、部分グラフを作っても複製されない。
+	typedef boost::adjacency_list<boost::vecS, boost::setS, boost::undirectedS, boost::property<boost::vertex_name_t, VertexId>, EdgeProperty> Graph;
+	
+	// 頂点間の最短距離の表。
+	// 対象の頂点に0から順に番号を振り、距離を連続した配列に格納する
+	// （行優先。symmetricを指定した場合は上三角部分のみを持ち、メモリを約半分にする）。
+	// 頂点から番号への変換は頂点ごとに一度だけ行い、
+	// 距離の参照は番号で行う（operator()）ことを想定している。
+	// VertexTypeは頂点を表す型（Graph::vertex_descriptor、CompactGraphの頂点番号など）。
+	template <class VertexType> class BasicDistanceMatrix{
+	private:
+		std::vector<VertexType> vertices_;
+		std::unordered_map<VertexType, size_t> index_; // 頂点→番号
+		std::vector<EdgeWeightType> values_;
+		bool symmetric_;
+		
+		inline size_t position(size_t i, size_t j) const{
+			if(symmetric_){
+				if(i > j) std::swap(i, j);
+				return j * (j + 1) / 2 + i;
+			}
+			return i * vertices_.size() + j;
+		}
+		
+	public:
+		BasicDistanceMatrix() : symmetric_(true) {}
+		
+		// 対象の頂点を指定して、表を初期化する
+		void assign(const std::vector<VertexType> & vertices, bool symmetric = true, EdgeWeightType initial_value = 0){
+			vertices_ = vertices;
+			symmetric_ = symmetric;
+			index_.clear();
+			for(size_t i = 0; i < vertices_.size(); ++i){
+				index_.insert(std::make_pair(vertices_[i], i));
+			}
+			size_t n = vertices_.size();
+			values_.assign(symmetric_ ? n * (n + 1) / 2 : n * n, initial_value);
+		}
+		
+		void clear(){
+			vertices_.clear();
+			index_.clear();
+			values_.clear();
+		}
+		
+		// 頂点を1つ末尾に加える（対称な表のみ）。既にある頂点間の距離はそのまま残る
+		void add_vertex(VertexType vertex, EdgeWeightType initial_value = 0){
+			index_.insert(std::make_pair(vertex, vertices_.size()));
+			vertices_.push_back(vertex);
+			size_t n = vertices_.size();
+			values_.resize(n * (n + 1) / 2, initial_value);
+		}
+		
+		inline size_t size() const{ return vertices_.size(); }
+		inline bool symmetric() const{ return symmetric_; }
+		inline bool contains(VertexType vertex) const{ return index_.find(vertex) != index_.end(); }
+		inline size_t index(VertexType vertex) const{ return index_.at(vertex); }
+		inline VertexType vertex(size_t i) const{ return vertices_[i]; }
+		
+		// 番号i, jの頂点間の距離
+		inline EdgeWeightType & operator()(size_t i, size_t j){ return values_[position(i, j)]; }
+		inline const EdgeWeightType & operator()(size_t i, size_t j) const{ return values_[position(i, j)]; }
+		
+		// 頂点v1, v2間の距離
+		inline EdgeWeightType at(VertexType v1, VertexType v2) const{
+			return (*this)(index_.at(v1), index_.at(v2));
+		}
+	};
+	typedef BasicDistanceMatrix<Graph::vertex_descriptor> DistanceMatrix;
+	
+	// 奇数次の頂点の最小マッチングを求める方法
+	enum MatchingBackend{
+		MATCHING_BLOSSOM, // blossomアルゴリズム（PerfectMatching.hpp）
+		MATCHING_GLPK     // GLPKによる整数計画法（CHINESE_POSTMAN_USE_GLPKを定義した場合のみ）
+	};
+	
+	// 最小マッチングの求め方の指定
+	struct MatchingOptions{
+		MatchingBackend backend;
+		
+		// blossomアルゴリズムで、各頂点から近い順にいくつの頂点との組を
+		// 候補とするか（0なら全ての組を候補とする）。
+		// 候補を絞っても、最適性を確認できなければ候補を追加して解き直す。
+		size_t candidate_neighbors;
+		
+		// 連結成分や境界の頂点のマスクごとの最小マッチングを、いくつのスレッドで
+		// 並行して求めるか（0ならCPUのコア数）。GLPKを用いる場合は常に1スレッドとする。
+		size_t num_threads;
+		
+		// 段階ごとの時間やカウンタを記録する先（NULLなら記録しない）。Instrumentation.hppを参照
+		Instrumentation * instrumentation;
+		
+		MatchingOptions(MatchingBackend bbackend = MATCHING_BLOSSOM, size_t ccandidate_neighbors = 10, size_t nnum_threads = 1, Instrumentation * iinstrumentation = NULL)
+		: backend(bbackend), candidate_neighbors(ccandidate_neighbors), num_threads(nnum_threads), instrumentation(iinstrumentation) {}
+		
+		// 実際に使うスレッド数
+		size_t effective_num_threads() const{
+			return(backend == MATCHING_GLPK ? 1 : num_threads);
+		}
+	};
+	
+	class RouteNetwork;
+	typedef std::vector<RouteNetwork> RouteNetworkList;
+	typedef RouteNetworkList::iterator RouteNetworkListIterator;
+	typedef RouteNetworkList::const_iterator RouteNetworkListConstIterator;
+	
+	// あるグラフを連結成分に分割したときの、元のグラフの頂点と分割したグラフの頂点との対応。
+	// 元のグラフの頂点の名前（駅名の表での番号）を添字とする配列で持つ。
+	struct ComponentMapping{
+		// 元のグラフになかった頂点の番号に対するcomponentの値
+		static size_t no_component(){ return static_cast<size_t>(-1); }
+		
+		std::vector<size_t> component; // 頂点が何番目の連結成分に入っているか
+		std::vector<Graph::vertex_descriptor> vertex; // 分割したグラフ（component番目）での頂点
+		
+		inline bool contains(VertexId v) const{ return v < component.size() && component[v] != no_component(); }
+	};
+	
+	// 「2頂点とその最短経路」を格納するためのクラス
+	// （頂点は駅名の表での番号で指定し、名前は出力するときに表から引く）
+	struct SubRoute{
+		VertexId v1, v2;
+		EdgeWeightType weight;
+		
+		SubRoute(VertexId vv1, VertexId vv2, EdgeWeightType wweight) : v1(vv1), v2(vv2), weight(wweight) {}
+	};
+	
+	// find_doubled_edgesの結果を、奇数次の頂点の集合ごとに覚えておくためのもの。
+	// 境界の頂点のマスクが異なっても、奇数次の頂点の集合が同じなら結果は同じになる。
+	// また直前に求めたマッチングを覚えておき、次に解くときの候補に加える。
+	// 連結成分（距離の表）ごとに一つ用意する。
+	struct MatchingMemo{
+		// 奇数次の頂点の、距離の表上での番号（昇順）
+		typedef std::vector<size_t> Key;
+		
+		std::map< Key, std::deque<SubRoute> > results;
+		std::vector< std::pair<size_t, size_t> > last_matching; // 距離の表上での番号の組
+		size_t hits; // resultsから結果を得た回数
+		
+		MatchingMemo() : hits(0) {}
+	};
+	
+	// 「2頂点の組」を格納するためのクラス
+	// （頂点は駅名の表での番号で指定）
+	struct VirtualEdge{
+		VertexId v1, v2;
+		EdgeWeightType weight;
+		
+		VirtualEdge(VertexId vv1, VertexId vv2, EdgeWeightType wweight)
+		: v1(vv1), v2(vv2), weight(wweight) {}
+		
+		inline bool operator==(const VirtualEdge & other) const{ return(v1 == other.v1 && v2 == other.v2 && weight == other.weight); }
+		inline bool operator<(const VirtualEdge & other) const{ return(v1 < other.v1 || (v1 == other.v1 && (v2 < other.v2 || (v2 == other.v2 && weight < other.weight)))); }
+	};
+	
+	// 駅名の表。同じ名前は一度だけ格納し、0から順に番号を振る。
+	// 名前はboost::string_refで引けるので、ファイルを読み込むときに
+	// 行ごとにstd::stringを作らなくてよい（新しい名前を登録するときだけ作る）。
+	// バイナリ形式のファイル（GraphFile）から作った表は、名前をコピーせずにファイルの領域を参照する。
+	class NameTable{
+	private:
+		struct NameHash{
+			// FNV-1a
+			inline size_t operator()(const boost::string_ref & name) const{
+				boost::uint64_t hash = 14695981039346656037ULL;
+				for(boost::string_ref::const_iterator it = name.begin(); it != name.end(); ++it){
+					hash = (hash ^ static_cast<unsigned char>(*it)) * 1099511628211ULL;
+				}
+				return static_cast<size_t>(hash);
+			}
+		};
+		
+		std::deque<std::string> storage_; // internで登録した名前の実体（要素のアドレスは変わらない）
+		std::shared_ptr<const void> external_; // 名前が外部の領域にある場合、その領域の持ち主
+		std::vector<boost::string_ref> names_; // storage_または外部の領域を指す
+		std::unordered_map<boost::string_ref, VertexId, NameHash> ids_;
+		
+		inline VertexId add(const boost::string_ref & name){
+			VertexId id = static_cast<VertexId>(names_.size());
+			names_.push_back(name);
+			ids_.insert(std::make_pair(name, id));
+			return id;
+		}
+	
+	public:
+		NameTable(){}
+		
+		// chars[offsets[i]]～chars[offsets[i+1]-1] をi番目の名前とする表を作る。
+		// 名前はコピーせずにその領域を参照し続ける。ownerはその領域の持ち主で、表とともに保持される。
+		NameTable(const char * chars, const boost::uint64_t * offsets, size_t count, std::shared_ptr<const void> owner)
+		: external_(owner){
+			names_.reserve(count);
+			ids_.reserve(count);
+			for(size_t i = 0; i < count; ++i){
+				add(boost::string_ref(chars + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i])));
+			}
+		}
+		
+		// 名前に対応する番号を返す。まだ登録されていなければ新たに登録する。
+		VertexId intern(const boost::string_ref & name){
+			std::unordered_map<boost::string_ref, VertexId, NameHash>::iterator it = ids_.find(name);
+			if(it != ids_.end()) return it->second;
+			
+			storage_.push_back(name.to_string());
+			return add(boost::string_ref(storage_.back()));
+		}
+		
+		// 名前に対応する番号をidに格納する。登録されていなければfalseを返す。
+		bool find(const boost::string_ref & name, VertexId & id) const{
+			std::unordered_map<boost::string_ref, VertexId, NameHash>::const_iterator it = ids_.find(name);
+			if(it == ids_.end()) return false;
+			id = it->second;
+			return true;
+		}
+		
+		inline boost::string_ref name(VertexId id) const{ return names_[id]; }
+		inline size_t size() const{ return names_.size(); }
+	};
+	
+	// 次数2の頂点を除去して縮約した辺（RouteNetwork::remove_trivial_vertices）の表。
+	// 縮約した辺ごとに、元の駅の列（両端を含む）と、隣り合う駅の間の距離を持つ。
+	// すべての列をつなげて1つの配列に格納し、列の番号は1から振る（0は縮約していない元の辺）。
+	class EdgeChainTable{
+	private:
+		std::vector<VertexId> vertices_; // 各列の駅
+		std::vector<EdgeWeightType> weights_; // weights_[k]は vertices_[k-1] から vertices_[k] までの距離（列の先頭では0）
+		std::vector<size_t> begin_; // 列cの駅は vertices_[begin_[c-1]] から vertices_[begin_[c]-1] まで
+	
+	public:
+		EdgeChainTable() : begin_(1, 0) {}
+		
+		inline size_t size() const{ return begin_.size() - 1; }
+		inline size_t length(EdgeId chain) const{ return begin_[chain] - begin_[chain - 1] - 1; } // 区間の数
+		inline VertexId front(EdgeId chain) const{ return vertices_[begin_[chain - 1]]; }
+		inline VertexId back(EdgeId chain) const{ return vertices_[begin_[chain] - 1]; }
+		inline VertexId second(EdgeId chain) const{ return vertices_[begin_[chain - 1] + 1]; } // frontの次の駅
+		
+		// 駅vから列を始める
+		void begin_chain(VertexId v){
+			vertices_.push_back(v);
+			weights_.push_back(0);
+		}
+		// 距離weightの区間を通って駅vへ進む
+		void append(EdgeWeightType weight, VertexId v){
+			vertices_.push_back(v);
+			weights_.push_back(weight);
+		}
+		// 表tableの列chainを、その端の駅fromから反対の端まで進む（from以外の駅を加える）
+		void append_chain(const EdgeChainTable & table, EdgeId chain, VertexId from){
+			table.for_each_section(chain, from, [&](VertexId, EdgeWeightType weight, VertexId to){ append(weight, to); });
+		}
+		// 列を閉じ、その番号を返す
+		EdgeId end_chain(){
+			begin_.push_back(vertices_.size());
+			return static_cast<EdgeId>(begin_.size() - 1);
+		}
+		
+		// 列chainの区間を、端の駅fromから順に visitor(出発する駅, 距離, 到着する駅) に渡す
+		// （両端が同じ駅の輪の場合は、格納した順に渡す）。
+		template <class SectionVisitor>
+		void for_each_section(EdgeId chain, VertexId from, SectionVisitor visitor) const{
+			size_t first = begin_[chain - 1], last = begin_[chain] - 1;
+			if(vertices_[first] == from){
+				for(size_t k = first + 1; k <= last; ++k) visitor(vertices_[k - 1], weights_[k], vertices_[k]);
+			}else{
+				for(size_t k = last; k > first; --k) visitor(vertices_[k], weights_[k], vertices_[k - 1]);
+			}
+		}
+	};
+	
+	// ファイルを読み込み専用でメモリにマップする。
+	// 開けない場合と空の場合（空のファイルはマップできない）は、エラーを表示してfalseを返す。
+	bool map_file(const char * fname, std::shared_ptr<boost::interprocess::mapped_region> & region){
+		namespace bip = boost::interprocess;
+		try{
+			bip::file_mapping file(fname, bip::read_only);
+			region = std::make_shared<bip::mapped_region>(file, bip::read_only);
+		}catch(const bip::interprocess_exception &){
+			std::cerr << "ERROR: Given file \"" << fname << "\" cannot be opened or is empty" << std::endl;
+			return false;
+		}
+		return true;
+	}
+	
+	// バイナリ形式のグラフのファイルの先頭に置くヘッダ。
+	// ファイルはこれに続いて、以下の配列を順に並べたもの（GraphFileLayoutを参照）。
+	//   辺の端点1[E]、辺の端点2[E]、辺の距離[E]
+	//   隣接リストの開始位置[V+1]、隣接する頂点[2E]、隣接する辺[2E]（CompactGraphと同じ）
+	//   駅名の開始位置[V+1]（64ビット）、駅名をつなげた文字列[name_bytes]
+	//   橋の辺の番号[num_bridges]（GRAPH_FILE_HAS_BRIDGESの場合）
+	//   頂点ごとの連結成分の番号[V]（GRAPH_FILE_HAS_COMPONENTSの場合）
+	// 整数は書き込んだ計算機のバイト順で格納する（byte_orderで確かめる）。
+	// 形式を変えた場合はcurrent_versionを増やす。
+	struct GraphFileHeader{
+		char magic[8]; // "CPGRAPH"
+		boost::uint32_t version;
+		boost::uint32_t byte_order; // 0x01020304
+		boost::uint32_t id_size; // sizeof(VertexId)
+		boost::uint32_t weight_size; // sizeof(EdgeWeightType)
+		boost::uint32_t flags; // GraphFileFlagsの組み合わせ
+		boost::uint32_t reserved;
+		boost::uint64_t num_vertices, num_edges, name_bytes, num_bridges, num_components;
+		
+		static const boost::uint32_t current_version = 1;
+		static const boost::uint32_t native_byte_order = 0x01020304;
+		static inline const char * expected_magic(){ return "CPGRAPH"; }
+	};
+	
+	enum GraphFileFlags{
+		GRAPH_FILE_HAS_NAMES = 1,
+		GRAPH_FILE_HAS_BRIDGES = 2,
+		GRAPH_FILE_HAS_COMPONENTS = 4
+	};
+	
+	// バイナリ形式のグラフのファイルにおける、各配列のファイル先頭からの位置（バイト単位）。
+	// 各配列の先頭は8バイト境界に揃える。
+	struct GraphFileLayout{
+		boost::uint64_t edge_sources, edge_targets, edge_weights;
+		boost::uint64_t offsets, adjacent_vertices, adjacent_edges;
+		boost::uint64_t name_offsets, name_chars, bridges, components;
+		boost::uint64_t total_size;
+		
+		GraphFileLayout()
+		: edge_sources(0), edge_targets(0), edge_weights(0), offsets(0), adjacent_vertices(0), adjacent_edges(0),
+		  name_offsets(0), name_chars(0), bridges(0), components(0), total_size(0) {}
+		
+		explicit GraphFileLayout(const GraphFileHeader & header){
+			boost::uint64_t position = sizeof(GraphFileHeader);
+			auto next = [&](boost::uint64_t bytes){
+				boost::uint64_t begin = position;
+				position = (position + bytes + 7) / 8 * 8;
+				return begin;
+			};
+			bool has_names = (header.flags & GRAPH_FILE_HAS_NAMES) != 0;
+			edge_sources = next(header.num_edges * sizeof(VertexId));
+			edge_targets = next(header.num_edges * sizeof(VertexId));
+			edge_weights = next(header.num_edges * sizeof(EdgeWeightType));
+			offsets = next((header.num_vertices + 1) * sizeof(EdgeId));
+			adjacent_vertices = next(header.num_edges * 2 * sizeof(VertexId));
+			adjacent_edges = next(header.num_edges * 2 * sizeof(EdgeId));
+			name_offsets = next(has_names ? (header.num_vertices + 1) * sizeof(boost::uint64_t) : 0);
+			name_chars = next(has_names ? header.name_bytes : 0);
+			bridges = next(header.flags & GRAPH_FILE_HAS_BRIDGES ? header.num_bridges * sizeof(EdgeId) : 0);
+			components = next(header.flags & GRAPH_FILE_HAS_COMPONENTS ? header.num_vertices * sizeof(boost::uint32_t) : 0);
+			total_size = position;
+		}
+	};
+	
+	// メモリにマップしたバイナリ形式のグラフのファイル。
+	// 配列はファイルの領域をそのまま指す（解釈もコピーもしない）。
+	// ファイルの作り方はCompactGraph.hppのwrite_graph_fileを参照。
+	class GraphFile{
+	private:
+		std::shared_ptr<const boost::interprocess::mapped_region> region_;
+		const GraphFileHeader * header_;
+		GraphFileLayout layout_;
+		
+		template <class T> inline const T * section(boost::uint64_t position) const{
+			return reinterpret_cast<const T *>(static_cast<const char *>(region_->get_address()) + position);
+		}
+		
+		// 各配列の中身が範囲内にあるかを調べる。計算量は O(V + E)
+		bool check_contents(const char * & reason) const{
+			boost::uint64_t V = header_->num_vertices, E = header_->num_edges;
+			const VertexId * sources = section<VertexId>(layout_.edge_sources);
+			const VertexId * targets = section<VertexId>(layout_.edge_targets);
+			const EdgeWeightType * weights = section<EdgeWeightType>(layout_.edge_weights);
+			for(boost::uint64_t e = 0; e < E; ++e){
+				if(sources[e] >= V || targets[e] >= V){ reason = "edge endpoint out of range"; return false; }
+				if(weights[e] <= 0){ reason = "non-positive distance"; return false; }
+			}
+			
+			const EdgeId * offsets = section<EdgeId>(layout_.offsets);
+			if(offsets[0] != 0 || offsets[V] != 2 * E){ reason = "broken adjacency offsets"; return false; }
+			for(boost::uint64_t v = 0; v < V; ++v){
+				if(offsets[v] > offsets[v + 1]){ reason = "broken adjacency offsets"; return false; }
+			}
+			const VertexId * adjacent_vertices = section<VertexId>(layout_.adjacent_vertices);
+			const EdgeId * adjacent_edges = section<EdgeId>(layout_.adjacent_edges);
+			for(boost::uint64_t pos = 0; pos < 2 * E; ++pos){
+				if(adjacent_vertices[pos] >= V || adjacent_edges[pos] >= E){ reason = "adjacency out of range"; return false; }
+			}
+			
+			if(has_names()){
+				const boost::uint64_t * name_offsets = section<boost::uint64_t>(layout_.name_offsets);
+				if(name_offsets[0] != 0 || name_offsets[V] != header_->name_bytes){ reason = "broken name offsets"; return false; }
+				for(boost::uint64_t v = 0; v < V; ++v){
+					if(name_offsets[v] > name_offsets[v + 1]){ reason = "broken name offsets"; return false; }
+				}
+			}
+			if(has_bridges()){
+				const EdgeId * bridges = section<EdgeId>(layout_.bridges);
+				for(boost::uint64_t i = 0; i < header_->num_bridges; ++i){
+					if(bridges[i] >= E){ reason = "bridge out of range"; return false; }
+				}
+			}
+			if(has_components()){
+				const boost::uint32_t * components = section<boost::uint32_t>(layout_.components);
+				for(boost::uint64_t v = 0; v < V; ++v){
+					if(components[v] >= header_->num_components){ reason = "component out of range"; return false; }
+				}
+			}
+			return true;
+		}
+	
+	public:
+		GraphFile() : header_(NULL) {}
+		
+		// バイナリ形式のファイルの内容であるか（先頭がヘッダのmagicと一致するか）
+		static bool is_graph_file(const void * data, size_t size){
+			return size >= sizeof(GraphFileHeader) && std::memcmp(data, GraphFileHeader::expected_magic(), sizeof(GraphFileHeader().magic)) == 0;
+		}
+		
+		// マップしたファイルregionを使う。
+		// 形式が異なるか壊れている場合は、エラーを表示してfalseを返す。
+		bool attach(std::shared_ptr<const boost::interprocess::mapped_region> region, const char * fname){
+			region_ = region;
+			header_ = NULL;
+			const char * reason = NULL;
+			size_t size = region->get_size();
+			const GraphFileHeader * header = static_cast<const GraphFileHeader *>(region->get_address());
+			
+			if(!is_graph_file(header, size)){
+				reason = "not a graph file";
+			}else if(header->version != GraphFileHeader::current_version){
+				reason = "unsupported version";
+			}else if(header->byte_order != GraphFileHeader::native_byte_order || header->id_size != sizeof(VertexId) || header->weight_size != sizeof(EdgeWeightType)){
+				reason = "written on an incompatible machine";
+			}else if(header->num_vertices >= std::numeric_limits<VertexId>::max() || header->num_edges >= std::numeric_limits<EdgeId>::max() / 2
+				|| header->name_bytes > size || header->num_bridges > header->num_edges || header->num_components > header->num_vertices){
+				reason = "broken header";
+			}else if(GraphFileLayout(*header).total_size > size){
+				reason = "file too short";
+			}else{
+				header_ = header;
+				layout_ = GraphFileLayout(*header);
+				if(!check_contents(reason)) header_ = NULL;
+			}
+			
+			if(header_ == NULL){
+				std::cerr << "ERROR: Given file \"" << fname << "\" is not a valid graph file (" << reason << ")" << std::endl;
+				region_.reset();
+				return false;
+			}
+			return true;
+		}
+		
+		// ファイルを開いてマップする
+		bool open(const char * fname){
+			std::shared_ptr<boost::interprocess::mapped_region> region;
+			return map_file(fname, region) && attach(region, fname);
+		}
+		
+		inline const GraphFileHeader & header() const{ return *header_; }
+		inline size_t num_vertices() const{ return static_cast<size_t>(header_->num_vertices); }
+		inline size_t num_edges() const{ return static_cast<size_t>(header_->num_edges); }
+		inline bool has_names() const{ return (header_->flags & GRAPH_FILE_HAS_NAMES) != 0; }
+		inline bool has_bridges() const{ return (header_->flags & GRAPH_FILE_HAS_BRIDGES) != 0; }
+		inline bool has_components() const{ return (header_->flags & GRAPH_FILE_HAS_COMPONENTS) != 0; }
+		
+		inline const VertexId * edge_sources() const{ return section<VertexId>(layout_.edge_sources); }
+		inline const VertexId * edge_targets() const{ return section<VertexId>(layout_.edge_targets); }
+		inline const EdgeWeightType * edge_weights() const{ return section<EdgeWeightType>(layout_.edge_weights); }
+		inline const EdgeId * offsets() const{ return section<EdgeId>(layout_.offsets); }
+		inline const VertexId * adjacent_vertices() const{ return section<VertexId>(layout_.adjacent_vertices); }
+		inline const EdgeId * adjacent_edges() const{ return section<EdgeId>(layout_.adjacent_edges); }
+		inline const boost::uint64_t * name_offsets() const{ return section<boost::uint64_t>(layout_.name_offsets); }
+		inline const char * name_chars() const{ return section<char>(layout_.name_chars); }
+		inline size_t num_bridges() const{ return static_cast<size_t>(header_->num_bridges); }
+		inline const EdgeId * bridges() const{ return section<EdgeId>(layout_.bridges); }
+		inline size_t num_components() const{ return static_cast<size_t>(header_->num_components); }
+		inline const boost::uint32_t * components() const{ return section<boost::uint32_t>(layout_.components); }
+		
+		inline boost::string_ref name(VertexId v) const{
+			const boost::uint64_t * offsets = name_offsets();
+			return boost::string_ref(name_chars() + offsets[v], static_cast<size_t>(offsets[v + 1] - offsets[v]));
+		}
+		
+		// マップした領域の持ち主。配列を使い続ける間はこれを保持しておく
+		inline std::shared_ptr<const void> owner() const{ return region_; }
+	};
+	
+	// ファイルから辺を読み込み、1本ごとに handler(距離, 地点名1, 地点名2) を呼ぶ。
+	// 地点名はboost::string_refで渡され、handlerの呼び出し中のみ有効。
+	// 各行は「距離(正整数に限る) 地点名1 地点名2」と指定する。
+	// 空行と、#で始まる行は無視する。地点名2より後ろの内容も無視する。
+	// 返り値はグラフの距離の総和。エラーが発生した場合は、その行と桁を表示して0を返す。
+	// 
+	// ファイルはメモリにマップし、1行ごとの確保やコピーをせずにその場で解釈する。
+	// バイナリ形式のファイル（GraphFile）が与えられた場合は、その辺の一覧を順に渡す。
+	template <class EdgeHandler>
+	EdgeWeightType read_edges_from(const char * fname, EdgeHandler handler){
+		std::shared_ptr<boost::interprocess::mapped_region> region;
+		if(!map_file(fname, region)) return 0;
+		const char * const begin = static_cast<const char *>(region->get_address());
+		const char * const end = begin + region->get_size();
+		
+		// バイナリ形式のファイルなら、辺の一覧をそのまま渡す
+		if(GraphFile::is_graph_file(begin, end - begin)){
+			GraphFile graph_file;
+			if(!graph_file.attach(region, fname)) return 0;
+			if(!graph_file.has_names()){
+				std::cerr << "ERROR: Given file \"" << fname << "\" has no station names" << std::endl;
+				return 0;
+			}
+			const VertexId * sources = graph_file.edge_sources();
+			const VertexId * targets = graph_file.edge_targets();
+			const EdgeWeightType * weights = graph_file.edge_weights();
+			EdgeWeightType total_distance = 0;
+			for(size_t e = 0; e < graph_file.num_edges(); ++e){
+				handler(weights[e], graph_file.name(sources[e]), graph_file.name(targets[e]));
+				total_distance += weights[e];
+			}
+			return total_distance;
+		}
+		
+		EdgeWeightType total_distance = 0;
+		size_t line_number = 0;
+		
+		for(const char * line = begin; line < end; ){
+			const char * line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+			if(line_end == NULL) line_end = end;
+			++line_number;
+			
+			const char * p = line;
+			// 位置pでのエラーを表示する
+			auto error = [&](const char * message){
+				std::cerr << "ERROR: " << fname << ":" << line_number << ":" << (p - line + 1) << ": " << message << std::endl;
+			};
+			auto is_space = [](char c){ return c == ' ' || c == '\t' || c == '\r'; };
+			
+			if(line == line_end || *line == '#' || *line == '\r'){
+				line = line_end + 1;
+				continue;
+			}
+			
+			// 距離
+			while(p < line_end && is_space(*p)) ++p;
+			const char * number_begin = p;
+			long long distance = 0;
+			for(; p < line_end && *p >= '0' && *p <= '9'; ++p){
+				distance = distance * 10 + (*p - '0');
+				if(distance > std::numeric_limits<EdgeWeightType>::max()){
+					p = number_begin;
+					error("Distance too large");
+					return 0;
+				}
+			}
+			if(p == number_begin || (p < line_end && !is_space(*p)) || distance <= 0){
+				p = number_begin;
+				error("Distance less than zero or invalid distance found");
+				return 0;
+			}
+			
+			// 地点名
+			boost::string_ref names[2];
+			for(size_t i = 0; i < 2; ++i){
+				while(p < line_end && is_space(*p)) ++p;
+				const char * name_begin = p;
+				while(p < line_end && !is_space(*p)) ++p;
+				if(p == name_begin){
+					error("Station name invalid");
+					return 0;
+				}
+				names[i] = boost::string_ref(name_begin, p - name_begin);
+			}
+			
+			handler(static_cast<EdgeWeightType>(distance), names[0], names[1]);
+			total_distance += static_cast<EdgeWeightType>(distance);
+			line = line_end + 1;
+		}
+		
+		return total_distance;
+	}
+	
+	// Graphクラスのインスタンスgraphにファイルの内容を読み込む。
+	// 駅名はnamesに登録し、頂点の名前（vertex_name）にはその番号を格納する。
+	// namesに既に登録されている駅名は同じ番号になる（複数のファイルで表を共有できる）。
+	// ファイルの形式と返り値はread_edges_fromを参照。
+	EdgeWeightType read_from(const char * fname, Graph & graph, NameTable & names){
+		graph.clear();
+		
+		// 番号→頂点の対応
+		std::vector<Graph::vertex_descriptor> vertices;
+		
+		return read_edges_from(fname, [&](EdgeWeightType distance, const boost::string_ref & name1, const boost::string_ref & name2){
+			const boost::string_ref * s[2] = { &name1, &name2 };
+			Graph::vertex_descriptor vd[2];
+			
+			// 頂点を追加（まだ存在していないなら）
+			for(size_t i = 0; i <= 1; ++i){
+				VertexId id = names.intern(*(s[i]));
+				if(id >= vertices.size()) vertices.resize(id + 1, Graph::null_vertex());
+				if(vertices[id] == Graph::null_vertex()){
+					vertices[id] = boost::add_vertex(id, graph);
+				}
+				vd[i] = vertices[id];
+			}
+			
+			// 辺を追加
+			boost::add_edge(vd[0], vd[1], EdgeProperty(distance), graph);
+		});
+	}
+} // namespace ChinesePostman
+
+#endif // CHINESE_POSTMAN_UTIL_HPP_
@@ -0,0 +1,535 @@
+#ifndef COMPACT_GRAPH_HPP_
+#define COMPACT_GRAPH_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace ChinesePostman{
+	// 隣接関係を連続した配列に詰めた（CSR: compressed sparse row）無向グラフ。
+	// 作成後は変更しない。頂点・辺には0から順に番号が振られている。
+	// 頂点vに接する辺は adjacency_begin(v)～adjacency_end(v)-1 の位置に並び、
+	// 位置posの辺の番号は adjacent_edge(pos)、行き先の頂点は adjacent_vertex(pos) で得られる。
+	// 自己ループはその頂点の隣接リストに2回現れる（次数に2を加える）。
+	// 頂点の名前は別のNameTableに持たせる（頂点の番号はそのまま名前の番号になる）。
+	// 
+	// 配列の実体はBuilderが作ったものか、メモリにマップしたバイナリ形式のファイル（GraphFile）で、
+	// コピーしたCompactGraph同士はそれを共有する（変更しないので問題ない）。
+	class CompactGraph{
+	private:
+		// Builderが作る配列の実体
+		struct Storage{
+			std::vector<VertexId> edge_sources, edge_targets;
+			std::vector<EdgeWeightType> edge_weights;
+			std::vector<EdgeId> offsets; // 頂点数+1個
+			std::vector<VertexId> adjacent_vertices; // 辺数の2倍
+			std::vector<EdgeId> adjacent_edges; // 辺数の2倍
+			
+			// 辺の一覧から、計数ソートで隣接リストを作る
+			void build_adjacency(size_t num_vertices){
+				offsets.assign(num_vertices + 1, 0);
+				for(size_t e = 0; e < edge_sources.size(); ++e){
+					++offsets[edge_sources[e] + 1];
+					++offsets[edge_targets[e] + 1];
+				}
+				for(size_t v = 0; v < num_vertices; ++v){
+					offsets[v + 1] += offsets[v];
+				}
+				
+				adjacent_vertices.resize(edge_sources.size() * 2);
+				adjacent_edges.resize(edge_sources.size() * 2);
+				std::vector<EdgeId> fill(offsets.begin(), offsets.end() - 1);
+				for(size_t e = 0; e < edge_sources.size(); ++e){
+					VertexId v1 = edge_sources[e], v2 = edge_targets[e];
+					adjacent_vertices[fill[v1]] = v2;
+					adjacent_edges[fill[v1]++] = static_cast<EdgeId>(e);
+					adjacent_vertices[fill[v2]] = v1;
+					adjacent_edges[fill[v2]++] = static_cast<EdgeId>(e);
+				}
+			}
+		};
+	
+	public:
+		// 辺を順に追加してから、build()でCompactGraphを作る
+		class Builder{
+		private:
+			std::vector<VertexId> sources_, targets_;
+			std::vector<EdgeWeightType> weights_;
+			size_t num_vertices_;
+		
+		public:
+			Builder() : num_vertices_(0) {}
+			
+			inline void add_edge(VertexId v1, VertexId v2, EdgeWeightType weight){
+				sources_.push_back(v1);
+				targets_.push_back(v2);
+				weights_.push_back(weight);
+				num_vertices_ = std::max<size_t>(num_vertices_, std::max(v1, v2) + 1);
+			}
+			
+			// 辺を持たない頂点も含めて、頂点数を指定する
+			inline void reserve_vertices(size_t num_vertices){
+				num_vertices_ = std::max(num_vertices_, num_vertices);
+			}
+			
+			void build(CompactGraph & graph, std::shared_ptr<const NameTable> names = std::shared_ptr<const NameTable>()){
+				if(names) reserve_vertices(names->size());
+				std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+				storage->edge_sources.swap(sources_);
+				storage->edge_targets.swap(targets_);
+				storage->edge_weights.swap(weights_);
+				storage->build_adjacency(num_vertices_);
+				graph.assign(num_vertices_, storage->edge_sources.size(),
+					storage->edge_sources.data(), storage->edge_targets.data(), storage->edge_weights.data(),
+					storage->offsets.data(), storage->adjacent_vertices.data(), storage->adjacent_edges.data(),
+					storage, names);
+				sources_.clear();
+				targets_.clear();
+				weights_.clear();
+				num_vertices_ = 0;
+			}
+		};
+	
+	private:
+		std::shared_ptr<const void> storage_; // 配列の実体の持ち主（Storage、またはマップしたファイル）
+		std::shared_ptr<const NameTable> names_;
+		size_t num_vertices_, num_edges_;
+		const VertexId * edge_sources_;
+		const VertexId * edge_targets_;
+		const EdgeWeightType * edge_weights_;
+		const EdgeId * offsets_;
+		const VertexId * adjacent_vertices_;
+		const EdgeId * adjacent_edges_;
+		// バイナリ形式のファイルに記録されていた橋と連結成分（記録がなければNULL）
+		const EdgeId * stored_bridges_;
+		size_t num_stored_bridges_;
+		const boost::uint32_t * stored_components_;
+		size_t num_stored_components_;
+		
+		static inline const EdgeId * empty_offsets(){
+			static const EdgeId zero = 0;
+			return &zero;
+		}
+	
+	public:
+		CompactGraph()
+		: num_vertices_(0), num_edges_(0), edge_sources_(NULL), edge_targets_(NULL), edge_weights_(NULL),
+		  offsets_(empty_offsets()), adjacent_vertices_(NULL), adjacent_edges_(NULL),
+		  stored_bridges_(NULL), num_stored_bridges_(0), stored_components_(NULL), num_stored_components_(0) {}
+		
+		// 既にある配列をそのまま使う（コピーしない）。配列の形式はStorageと同じ。
+		// storageは配列の実体の持ち主で、このグラフ（とそのコピー）が使われている間保持される。
+		void assign(size_t num_vertices, size_t num_edges,
+			const VertexId * edge_sources, const VertexId * edge_targets, const EdgeWeightType * edge_weights,
+			const EdgeId * offsets, const VertexId * adjacent_vertices, const EdgeId * adjacent_edges,
+			std::shared_ptr<const void> storage, std::shared_ptr<const NameTable> names = std::shared_ptr<const NameTable>()){
+			storage_ = storage;
+			names_ = names;
+			num_vertices_ = num_vertices;
+			num_edges_ = num_edges;
+			edge_sources_ = edge_sources;
+			edge_targets_ = edge_targets;
+			edge_weights_ = edge_weights;
+			offsets_ = offsets;
+			adjacent_vertices_ = adjacent_vertices;
+			adjacent_edges_ = adjacent_edges;
+			set_stored_structure(NULL, 0, NULL, 0);
+		}
+		
+		// ファイルに記録されていた橋の辺の番号（昇順）と、頂点ごとの連結成分の番号を与える。
+		// 与えた場合、bridge_edgesとconnected_componentsは（除く辺がなければ）求め直さずにこれを返す。
+		// 配列はassignで与えたstorageが持っていること。
+		void set_stored_structure(const EdgeId * bridges, size_t num_bridges, const boost::uint32_t * components, size_t num_components){
+			stored_bridges_ = bridges;
+			num_stored_bridges_ = num_bridges;
+			stored_components_ = components;
+			num_stored_components_ = num_components;
+		}
+		
+		inline size_t num_vertices() const{ return num_vertices_; }
+		inline size_t num_edges() const{ return num_edges_; }
+		
+		inline size_t degree(VertexId v) const{ return offsets_[v + 1] - offsets_[v]; }
+		inline size_t adjacency_begin(VertexId v) const{ return offsets_[v]; }
+		inline size_t adjacency_end(VertexId v) const{ return offsets_[v + 1]; }
+		inline VertexId adjacent_vertex(size_t pos) const{ return adjacent_vertices_[pos]; }
+		inline EdgeId adjacent_edge(size_t pos) const{ return adjacent_edges_[pos]; }
+		
+		inline VertexId edge_source(EdgeId e) const{ return edge_sources_[e]; }
+		inline VertexId edge_target(EdgeId e) const{ return edge_targets_[e]; }
+		inline EdgeWeightType edge_weight(EdgeId e) const{ return edge_weights_[e]; }
+		
+		// 辺eを頂点vから辿った先の頂点
+		inline VertexId opposite(EdgeId e, VertexId v) const{
+			return edge_sources_[e] == v ? edge_targets_[e] : edge_sources_[e];
+		}
+		
+		// 頂点v1とv2を結ぶ辺（複数あれば隣接リストで最初のもの）の番号。なければnum_edges()を返す
+		EdgeId find_edge(VertexId v1, VertexId v2) const{
+			for(size_t pos = adjacency_begin(v1); pos < adjacency_end(v1); ++pos){
+				if(adjacent_vertex(pos) == v2) return adjacent_edge(pos);
+			}
+			return static_cast<EdgeId>(num_edges_);
+		}
+		
+		// 頂点v1とv2を結ぶ、距離weightの辺（複数あれば隣接リストで最初のもの）の番号。なければnum_edges()を返す
+		EdgeId find_edge(VertexId v1, VertexId v2, EdgeWeightType weight) const{
+			for(size_t pos = adjacency_begin(v1); pos < adjacency_end(v1); ++pos){
+				if(adjacent_vertex(pos) == v2 && edge_weight(adjacent_edge(pos)) == weight) return adjacent_edge(pos);
+			}
+			return static_cast<EdgeId>(num_edges_);
+		}
+		
+		inline bool has_stored_bridges() const{ return stored_bridges_ != NULL; }
+		inline const EdgeId * stored_bridges() const{ return stored_bridges_; }
+		inline size_t num_stored_bridges() const{ return num_stored_bridges_; }
+		inline bool has_stored_components() const{ return stored_components_ != NULL; }
+		inline const boost::uint32_t * stored_components() const{ return stored_components_; }
+		inline size_t num_stored_components() const{ return num_stored_components_; }
+		
+		inline bool has_names() const{ return static_cast<bool>(names_); }
+		inline const NameTable & names() const{ return *names_; }
+		inline std::shared_ptr<const NameTable> shared_names() const{ return names_; }
+		inline boost::string_ref vertexname(VertexId v) const{ return names_->name(v); }
+		
+		EdgeWeightType total_weight() const{
+			EdgeWeightType result = 0;
+			for(size_t e = 0; e < num_edges_; ++e){
+				result += edge_weights_[e];
+			}
+			return result;
+		}
+	};
+	
+	// 最短距離の表（頂点はCompactGraphでの番号）
+	typedef BasicDistanceMatrix<VertexId> CompactDistanceMatrix;
+	
+	// CompactGraph（作成後は変更しない）を作り直さずに、辺の距離と有無を変えて扱うための表の組。
+	// 表そのものは呼び出す側で持ち（辺の番号を添字とする）、ここでは参照するだけ。
+	struct EdgeOverlay{
+		const std::vector<EdgeWeightType> * weights; // 辺ごとの距離（NULLなら元の距離）
+		const std::vector<bool> * excluded_edges; // 真の辺はないものとする（NULLならすべての辺がある）
+		// 辺の番号→表の添字（NULLなら辺の番号そのもの）。induced_subgraphで作った部分グラフに、元のグラフの表を使う場合など
+		const std::vector<EdgeId> * edge_ids;
+		
+		EdgeOverlay(const std::vector<EdgeWeightType> * wweights = NULL, const std::vector<bool> * eexcluded_edges = NULL, const std::vector<EdgeId> * eedge_ids = NULL)
+		: weights(wweights), excluded_edges(eexcluded_edges), edge_ids(eedge_ids) {}
+		
+		inline EdgeWeightType weight(const CompactGraph & graph, EdgeId e) const{
+			return weights != NULL ? (*weights)[edge_ids != NULL ? (*edge_ids)[e] : e] : graph.edge_weight(e);
+		}
+		inline bool excluded(EdgeId e) const{
+			return excluded_edges != NULL && (*excluded_edges)[edge_ids != NULL ? (*edge_ids)[e] : e];
+		}
+	};
+	
+	// boost::adjacency_listのグラフからCompactGraphを作る。
+	// verticesが与えられた場合、(*vertices)[i]に番号iの頂点に対応する元の頂点が、
+	// edgesが与えられた場合、(*edges)[e]に番号eの辺に対応する元の辺が格納される。
+	// graph_namesが与えられた場合（graphの頂点の名前がその表での番号である場合）、CompactGraphの駅名の表も作る。
+	void make_compact_graph(const Graph & graph, CompactGraph & result, std::vector<Graph::vertex_descriptor> * vertices = NULL, std::vector<Graph::edge_descriptor> * edges = NULL, const NameTable * graph_names = NULL){
+		std::map<Graph::vertex_descriptor, VertexId> index;
+		std::shared_ptr<NameTable> names;
+		if(graph_names != NULL) names = std::make_shared<NameTable>();
+		if(vertices != NULL) vertices->clear();
+		if(edges != NULL) edges->clear();
+		
+		std::pair<Graph::vertex_iterator, Graph::vertex_iterator> vertex_range = boost::vertices(graph);
+		for(Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+			VertexId id = static_cast<VertexId>(index.size());
+			index.insert(std::make_pair(*itv, id));
+			if(vertices != NULL) vertices->push_back(*itv);
+			if(names) names->intern(graph_names->name(boost::get(boost::vertex_name, graph, *itv)));
+		}
+		
+		CompactGraph::Builder builder;
+		builder.reserve_vertices(index.size());
+		std::pair<Graph::edge_iterator, Graph::edge_iterator> edge_range = boost::edges(graph);
+		for(Graph::edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+			builder.add_edge(index[boost::source(*ite, graph)], index[boost::target(*ite, graph)], boost::get(boost::edge_weight, graph, *ite));
+			if(edges != NULL) edges->push_back(*ite);
+		}
+		builder.build(result, names);
+	}
+	
+	// graphのうち、頂点verticesと、その頂点同士を結ぶ辺（excluded_edgesで真の辺を除く）からなる部分グラフ（連結成分など）を、
+	// 頂点と辺の番号を0から振り直したCompactGraphにしてresultに格納する。vertices[k]が番号kの頂点になり、
+	// edges[e]に番号eの辺に対応するgraphの辺の番号が格納される。辺の並びはgraphでの番号の順。
+	// local_indexはgraphの頂点数の大きさの作業領域で、すべての要素がgraph.num_vertices()であること（返る前に元に戻す）。
+	// 作業領域を使い回せば、計算量はverticesの頂点の次数の和に比例する（graph全体の大きさによらない）。
+	void induced_subgraph(const CompactGraph & graph, const std::vector<VertexId> & vertices, const std::vector<bool> * excluded_edges, std::vector<VertexId> & local_index, CompactGraph & result, std::vector<EdgeId> & edges){
+		const VertexId none = static_cast<VertexId>(graph.num_vertices());
+		for(size_t k = 0; k < vertices.size(); ++k) local_index[vertices[k]] = static_cast<VertexId>(k);
+		
+		// 辺は番号の小さい端から1回だけ数える（自己ループは隣接リストに2回現れるので、1回目だけ）
+		edges.clear();
+		for(size_t k = 0; k < vertices.size(); ++k){
+			VertexId v = vertices[k];
+			for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+				EdgeId e = graph.adjacent_edge(pos);
+				VertexId w = graph.adjacent_vertex(pos);
+				if(w < v || local_index[w] == none || (excluded_edges != NULL && (*excluded_edges)[e])) continue;
+				if(w == v && pos > graph.adjacency_begin(v) && graph.adjacent_edge(pos - 1) == e) continue;
+				edges.push_back(e);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		
+		CompactGraph::Builder builder;
+		builder.reserve_vertices(vertices.size());
+		for(std::vector<EdgeId>::const_iterator ite = edges.begin(); ite != edges.end(); ++ite){
+			builder.add_edge(local_index[graph.edge_source(*ite)], local_index[graph.edge_target(*ite)], graph.edge_weight(*ite));
+		}
+		builder.build(result);
+		for(size_t k = 0; k < vertices.size(); ++k) local_index[vertices[k]] = none;
+	}
+	
+	// 連結成分ごとに頂点に番号を付け、component[v]に格納する。
+	// excluded_edgesが与えられた場合、(*excluded_edges)[e]が真の辺eはないものとする。
+	// 返り値は連結成分の個数。
+	// excluded_edgesがなく、graphにファイルに記録された連結成分があれば、それをそのまま返す。
+	size_t connected_components(const CompactGraph & graph, std::vector<size_t> & component, const std::vector<bool> * excluded_edges = NULL){
+		if(excluded_edges == NULL && graph.has_stored_components()){
+			component.assign(graph.stored_components(), graph.stored_components() + graph.num_vertices());
+			return graph.num_stored_components();
+		}
+		
+		const size_t unvisited = static_cast<size_t>(-1);
+		component.assign(graph.num_vertices(), unvisited);
+		std::vector<VertexId> stack;
+		size_t count = 0;
+		
+		for(VertexId start = 0; start < graph.num_vertices(); ++start){
+			if(component[start] != unvisited) continue;
+			component[start] = count;
+			stack.push_back(start);
+			while(!stack.empty()){
+				VertexId v = stack.back();
+				stack.pop_back();
+				for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+					if(excluded_edges != NULL && (*excluded_edges)[graph.adjacent_edge(pos)]) continue;
+					VertexId w = graph.adjacent_vertex(pos);
+					if(component[w] == unvisited){
+						component[w] = count;
+						stack.push_back(w);
+					}
+				}
+			}
+			++count;
+		}
+		return count;
+	}
+	
+	// 橋（その辺1本がなくなると連結でなくなるような辺）を検出し、辺の番号を昇順にresultに格納する。
+	// Tarjanの方法を、再帰の代わりに明示的なスタックを用いて行う（長い路線でもスタックが溢れない）。
+	// 親へ戻る辺は頂点ではなく辺の番号で判定するので、多重辺は橋にならない。
+	// すべての連結成分を調べる。計算量は O(V + E)。
+	// excluded_edgesが与えられた場合、(*excluded_edges)[e]が真の辺eはないものとする（橋にもならない）。
+	// excluded_edgesがなく、graphにファイルに記録された橋があれば、それをそのまま返す。
+	void bridge_edges(const CompactGraph & graph, std::vector<EdgeId> & result, const std::vector<bool> * excluded_edges = NULL){
+		if(excluded_edges == NULL && graph.has_stored_bridges()){
+			result.assign(graph.stored_bridges(), graph.stored_bridges() + graph.num_stored_bridges());
+			return;
+		}
+		
+		const size_t unvisited = static_cast<size_t>(-1);
+		const EdgeId no_edge = static_cast<EdgeId>(-1);
+		std::vector<size_t> pre(graph.num_vertices(), unvisited), low(graph.num_vertices());
+		std::vector<bool> is_bridge(graph.num_edges(), false);
+		size_t count = 0;
+		
+		// 探索中の頂点、その頂点に入ってきた辺、次に調べる隣接リストの位置
+		struct Frame{
+			VertexId vertex;
+			EdgeId edge_from_parent;
+			size_t pos;
+		};
+		std::vector<Frame> stack;
+		
+		for(VertexId start = 0; start < graph.num_vertices(); ++start){
+			if(pre[start] != unvisited) continue;
+			pre[start] = low[start] = count++;
+			Frame first = { start, no_edge, graph.adjacency_begin(start) };
+			stack.push_back(first);
+			
+			while(!stack.empty()){
+				Frame & frame = stack.back();
+				VertexId v = frame.vertex;
+				if(frame.pos < graph.adjacency_end(v)){
+					EdgeId e = graph.adjacent_edge(frame.pos);
+					VertexId w = graph.adjacent_vertex(frame.pos);
+					++frame.pos;
+					if(e == frame.edge_from_parent) continue;
+					if(excluded_edges != NULL && (*excluded_edges)[e]) continue;
+					
+					if(pre[w] == unvisited){
+						pre[w] = low[w] = count++;
+						Frame next = { w, e, graph.adjacency_begin(w) };
+						stack.push_back(next); // frameはここで無効になりうる
+					}else{
+						low[v] = std::min(low[v], pre[w]);
+					}
+				}else{
+					// vの探索を終え、親に戻る
+					EdgeId e = frame.edge_from_parent;
+					stack.pop_back();
+					if(e == no_edge) continue;
+					VertexId parent = graph.opposite(e, v);
+					low[parent] = std::min(low[parent], low[v]);
+					if(low[v] == pre[v]) is_bridge[e] = true;
+				}
+			}
+		}
+		
+		result.clear();
+		for(EdgeId e = 0; e < graph.num_edges(); ++e){
+			if(is_bridge[e]) result.push_back(e);
+		}
+	}
+	
+	// メモリにマップしたバイナリ形式のファイルの配列を、コピーせずにそのまま使うCompactGraphにする。
+	// 駅名の表も（名前をコピーせずに）作られる。namesが与えられた場合は、作る代わりにそれを使う
+	// （ファイルの駅名から作った表であること）。記録された橋と連結成分もあわせて使う（set_stored_structureを参照）。
+	void attach_graph_file(const GraphFile & file, CompactGraph & graph, std::shared_ptr<const NameTable> names = std::shared_ptr<const NameTable>()){
+		if(!names && file.has_names()){
+			names = std::make_shared<NameTable>(file.name_chars(), file.name_offsets(), file.num_vertices(), file.owner());
+		}
+		graph.assign(file.num_vertices(), file.num_edges(),
+			file.edge_sources(), file.edge_targets(), file.edge_weights(),
+			file.offsets(), file.adjacent_vertices(), file.adjacent_edges(),
+			file.owner(), names);
+		graph.set_stored_structure(
+			(file.has_bridges() ? file.bridges() : NULL), (file.has_bridges() ? file.num_bridges() : 0),
+			(file.has_components() ? file.components() : NULL), (file.has_components() ? file.num_components() : 0));
+	}
+	
+	// CompactGraphをバイナリ形式のファイルに書き出す（形式はGraphFileHeaderを参照）。
+	// bridgesが与えられた場合は橋の辺の番号を、componentが与えられた場合は
+	// 頂点ごとの連結成分の番号（num_components未満）もあわせて書き出す。
+	// 書き出せなかった場合はエラーを表示してfalseを返す。
+	bool write_graph_file(const char * fname, const CompactGraph & graph, const std::vector<EdgeId> * bridges = NULL, const std::vector<size_t> * component = NULL, size_t num_components = 0){
+		GraphFileHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, GraphFileHeader::expected_magic(), sizeof(header.magic));
+		header.version = GraphFileHeader::current_version;
+		header.byte_order = GraphFileHeader::native_byte_order;
+		header.id_size = sizeof(VertexId);
+		header.weight_size = sizeof(EdgeWeightType);
+		header.num_vertices = graph.num_vertices();
+		header.num_edges = graph.num_edges();
+		
+		// 駅名をつなげた文字列と、各駅名の開始位置
+		std::vector<boost::uint64_t> name_offsets;
+		std::string name_chars;
+		if(graph.has_names()){
+			header.flags |= GRAPH_FILE_HAS_NAMES;
+			name_offsets.push_back(0);
+			for(VertexId v = 0; v < graph.num_vertices(); ++v){
+				boost::string_ref name = graph.vertexname(v);
+				name_chars.append(name.begin(), name.end());
+				name_offsets.push_back(name_chars.size());
+			}
+			header.name_bytes = name_chars.size();
+		}
+		std::vector<boost::uint32_t> components;
+		if(bridges != NULL){
+			header.flags |= GRAPH_FILE_HAS_BRIDGES;
+			header.num_bridges = bridges->size();
+		}
+		if(component != NULL){
+			header.flags |= GRAPH_FILE_HAS_COMPONENTS;
+			header.num_components = num_components;
+			components.assign(component->begin(), component->end());
+		}
+		
+		std::ofstream ofs(fname, std::ios::out | std::ios::binary);
+		if(!ofs){
+			std::cerr << "ERROR: Given file \"" << fname << "\" cannot be opened for writing" << std::endl;
+			return false;
+		}
+		
+		// 配列を順に、GraphFileLayoutの位置に書き出す
+		GraphFileLayout layout(header);
+		boost::uint64_t position = 0;
+		auto write = [&](boost::uint64_t section, const void * data, size_t bytes){
+			static const char padding[8] = { 0 };
+			ofs.write(padding, static_cast<std::streamsize>(section - position));
+			if(bytes > 0) ofs.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+			position = section + bytes;
+		};
+		write(0, &header, sizeof(header));
+		
+		std::vector<VertexId> sources(graph.num_edges()), targets(graph.num_edges());
+		std::vector<EdgeWeightType> weights(graph.num_edges());
+		for(EdgeId e = 0; e < graph.num_edges(); ++e){
+			sources[e] = graph.edge_source(e);
+			targets[e] = graph.edge_target(e);
+			weights[e] = graph.edge_weight(e);
+		}
+		write(layout.edge_sources, sources.data(), sources.size() * sizeof(VertexId));
+		write(layout.edge_targets, targets.data(), targets.size() * sizeof(VertexId));
+		write(layout.edge_weights, weights.data(), weights.size() * sizeof(EdgeWeightType));
+		
+		std::vector<EdgeId> offsets(graph.num_vertices() + 1);
+		std::vector<VertexId> adjacent_vertices(graph.num_edges() * 2);
+		std::vector<EdgeId> adjacent_edges(graph.num_edges() * 2);
+		for(VertexId v = 0; v <= graph.num_vertices(); ++v){
+			offsets[v] = static_cast<EdgeId>(v < graph.num_vertices() ? graph.adjacency_begin(v) : graph.num_edges() * 2);
+		}
+		for(size_t pos = 0; pos < graph.num_edges() * 2; ++pos){
+			adjacent_vertices[pos] = graph.adjacent_vertex(pos);
+			adjacent_edges[pos] = graph.adjacent_edge(pos);
+		}
+		write(layout.offsets, offsets.data(), offsets.size() * sizeof(EdgeId));
+		write(layout.adjacent_vertices, adjacent_vertices.data(), adjacent_vertices.size() * sizeof(VertexId));
+		write(layout.adjacent_edges, adjacent_edges.data(), adjacent_edges.size() * sizeof(EdgeId));
+		
+		if(graph.has_names()){
+			write(layout.name_offsets, name_offsets.data(), name_offsets.size() * sizeof(boost::uint64_t));
+			write(layout.name_chars, name_chars.data(), name_chars.size());
+		}
+		if(bridges != NULL) write(layout.bridges, bridges->data(), bridges->size() * sizeof(EdgeId));
+		if(component != NULL) write(layout.components, components.data(), components.size() * sizeof(boost::uint32_t));
+		write(layout.total_size, NULL, 0);
+		
+		ofs.close();
+		if(!ofs){
+			std::cerr << "ERROR: Failed to write \"" << fname << "\"" << std::endl;
+			return false;
+		}
+		return true;
+	}
+	
+	// CompactGraphにファイルの内容を読み込む。ファイルの形式はread_from(const char *, Graph &)と同じ。
+	// 駅名の表も作られる。返り値はグラフの距離の総和。エラーが発生した場合は0を返す。
+	// バイナリ形式のファイルの場合は、解釈せずにマップした領域をそのまま使う（attach_graph_fileを参照）。
+	EdgeWeightType read_from(const char * fname, CompactGraph & graph){
+		std::shared_ptr<boost::interprocess::mapped_region> region;
+		if(!map_file(fname, region)) return 0;
+		if(GraphFile::is_graph_file(region->get_address(), region->get_size())){
+			GraphFile file;
+			if(!file.attach(region, fname)) return 0;
+			attach_graph_file(file, graph);
+			return graph.total_weight();
+		}
+		region.reset();
+		
+		std::shared_ptr<NameTable> names = std::make_shared<NameTable>();
+		CompactGraph::Builder builder;
+		
+		EdgeWeightType total_distance = read_edges_from(fname, [&](EdgeWeightType distance, const boost::string_ref & name1, const boost::string_ref & name2){
+			VertexId v1 = names->intern(name1);
+			VertexId v2 = names->intern(name2);
+			builder.add_edge(v1, v2, distance);
+		});
+		
+		builder.build(graph, names);
+		return total_distance;
+	}
+} // namespace ChinesePostman
+
+#endif // COMPACT_GRAPH_HPP_
@@ -0,0 +1,55 @@
+#include "CompactGraph.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#define CONVERT_GRAPH_TEXT_EXTENSION ".edges"
+
+// OUTPUTの名前がCONVERT_GRAPH_TEXT_EXTENSIONで終わるならテキスト形式で書き出す
+bool is_text_filename(const std::string & fname){
+	std::string extension(CONVERT_GRAPH_TEXT_EXTENSION);
+	return fname.size() >= extension.size() && fname.compare(fname.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+int main(int argc, char ** argv){
+	if(argc <= 2){
+		std::cerr << "Usage: " << argv[0] << " INPUT OUTPUT" << std::endl;
+		std::cerr << "  INPUT  : graph file (text or binary)" << std::endl;
+		std::cerr << "  OUTPUT : binary graph file, or text if the name ends with \"" << CONVERT_GRAPH_TEXT_EXTENSION << "\"" << std::endl;
+		return 1;
+	}
+	
+	// テキスト形式・バイナリ形式のどちらでも読み込める
+	ChinesePostman::CompactGraph graph;
+	ChinesePostman::EdgeWeightType total_distance = ChinesePostman::read_from(argv[1], graph);
+	if(total_distance == 0){
+		std::cerr << "Error: When reading \"" << argv[1] << "\"" << std::endl;
+		return 1;
+	}
+	std::cerr << "Read " << graph.num_vertices() << " stations and " << graph.num_edges() << " edges (total distance = " << total_distance << ")" << std::endl;
+	
+	if(is_text_filename(argv[2])){
+		std::ofstream ofs(argv[2], std::ios::binary);
+		if(!ofs){
+			std::cerr << "Error: When opening \"" << argv[2] << "\"" << std::endl;
+			return 1;
+		}
+		for(ChinesePostman::EdgeId e = 0; e < graph.num_edges(); ++e){
+			ofs << graph.edge_weight(e) << " " << graph.vertexname(graph.edge_source(e)) << " " << graph.vertexname(graph.edge_target(e)) << std::endl;
+		}
+	}else{
+		// 橋と連結成分もあわせて書き出しておく
+		std::vector<ChinesePostman::EdgeId> bridges;
+		ChinesePostman::bridge_edges(graph, bridges);
+		std::vector<size_t> component;
+		size_t num_components = ChinesePostman::connected_components(graph, component);
+		std::cerr << "Found " << bridges.size() << " bridges and " << num_components << " connected components" << std::endl;
+		
+		if(!ChinesePostman::write_graph_file(argv[2], graph, &bridges, &component, num_components)){
+			return 1;
+		}
+	}
+	std::cerr << "Wrote graph to \"" << argv[2] << "\"" << std::endl;
+	
+	return 0;
+}
@@ -0,0 +1,285 @@
+#ifndef CUT_COMBINER_HPP_
+#define CUT_COMBINER_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include "masked_vector.hpp"
+#include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
+
+namespace ChinesePostman{
+	// グラフをカットして分割し、各部分について境界の頂点のマスクごとに
+	// 2回通る辺の距離を求めたあと、カットに使った辺を2回通るかどうかの
+	// 組み合わせのうち、距離の合計が最小になるものを求める。
+	//
+	// 部分を頂点、カットに使った辺を辺とするグラフ（カットグラフ）の上で、
+	// 辺を1本ずつ「2回通る/通らない」と決めていく動的計画法を行う。
+	// 状態は「まだ辺が残っている部分」の境界の頂点のマスクの組で、
+	// 部分の辺をすべて決め終えた時点でその部分の距離を加える。
+	// 状態の数はカットグラフの切断幅に対して指数的だが、カットに使った辺の
+	// 総数に対しては指数的にならない（2^|カットに使った辺| 通りを列挙しない）。
+	// また、残りの部分の距離の下限を加えても暫定解より長くなる状態は捨てる。
+	// 
+	// MaskTypeは境界の頂点のマスクの型（masked_vector_mask_traitsを参照）。
+	template <class MaskType>
+	class BasicCutCombiner{
+	public:
+		typedef masked_vector_mask_traits<MaskType> MaskTraits;
+		
+		// 部分ごとの「境界の頂点のマスク→2回通る辺の距離の合計」。
+		// 含まれないマスクは実現不可能とみなす。
+		typedef std::map<MaskType, EdgeWeightType> CostTable;
+		
+		// カットに使った辺。両端の頂点が属する部分と、その部分のマスクでのビットの位置
+		struct CutEdge{
+			size_t component1, bit1;
+			size_t component2, bit2;
+			EdgeWeightType weight;
+			
+			CutEdge(size_t ccomponent1, size_t bbit1, size_t ccomponent2, size_t bbit2, EdgeWeightType wweight)
+			: component1(ccomponent1), bit1(bbit1), component2(ccomponent2), bit2(bbit2), weight(wweight) {}
+		};
+	
+	private:
+		typedef std::vector<MaskType> StateKey; // 未完了の部分（activeの順）のマスク
+		
+		// 状態の由来（復元用）
+		struct Node{
+			size_t parent;
+			bool doubled;
+		};
+		
+		struct State{
+			EdgeWeightType distance;
+			size_t node;
+		};
+		
+		const std::vector<CostTable> & costs_;
+		const std::vector<CutEdge> & edges_;
+		
+		EdgeWeightType best_distance_;
+		std::vector<bool> doubled_;
+		std::vector<MaskType> component_masks_;
+		size_t max_states_;
+		
+		static EdgeWeightType infinite_distance(){
+			return std::numeric_limits<EdgeWeightType>::max();
+		}
+		
+		static EdgeWeightType cost_of(const CostTable & table, const MaskType & mask){
+			typename CostTable::const_iterator it = table.find(mask);
+			return(it == table.end() ? infinite_distance() : it->second);
+		}
+		
+		// 状態の数が少なくなるように辺の順序を決める。
+		// カットグラフを幅優先探索した順に部分を並べ、辺はその後ろ側の端点の順に処理する。
+		void order_edges(std::vector<size_t> & order) const{
+			size_t num_components = costs_.size();
+			std::vector< std::vector<size_t> > incident(num_components);
+			for(size_t e = 0; e < edges_.size(); ++e){
+				incident[edges_[e].component1].push_back(e);
+				if(edges_[e].component2 != edges_[e].component1) incident[edges_[e].component2].push_back(e);
+			}
+			
+			const size_t unvisited = static_cast<size_t>(-1);
+			std::vector<size_t> position(num_components, unvisited);
+			std::vector<size_t> queue;
+			for(size_t start = 0; start < num_components; ++start){
+				if(position[start] != unvisited) continue;
+				size_t head = queue.size();
+				position[start] = queue.size();
+				queue.push_back(start);
+				for(; head < queue.size(); ++head){
+					size_t c = queue[head];
+					for(std::vector<size_t>::iterator ite = incident[c].begin(); ite != incident[c].end(); ++ite){
+						size_t other = (edges_[*ite].component1 == c ? edges_[*ite].component2 : edges_[*ite].component1);
+						if(position[other] == unvisited){
+							position[other] = queue.size();
+							queue.push_back(other);
+						}
+					}
+				}
+			}
+			
+			order.resize(edges_.size());
+			for(size_t e = 0; e < edges_.size(); ++e) order[e] = e;
+			std::stable_sort(order.begin(), order.end(), [&](size_t e1, size_t e2){
+				size_t late1 = std::max(position[edges_[e1].component1], position[edges_[e1].component2]);
+				size_t late2 = std::max(position[edges_[e2].component1], position[edges_[e2].component2]);
+				if(late1 != late2) return late1 < late2;
+				return std::min(position[edges_[e1].component1], position[edges_[e1].component2]) < std::min(position[edges_[e2].component1], position[edges_[e2].component2]);
+			});
+		}
+	
+	public:
+		BasicCutCombiner(const std::vector<CostTable> & costs, const std::vector<CutEdge> & edges)
+		: costs_(costs), edges_(edges), best_distance_(infinite_distance()), max_states_(0) {}
+		
+		// 最小の組み合わせを求める。実現可能な組み合わせがなければfalseを返す。
+		bool solve(){
+			size_t num_components = costs_.size();
+			best_distance_ = infinite_distance();
+			doubled_.assign(edges_.size(), false);
+			component_masks_.assign(num_components, MaskType(0));
+			max_states_ = 0;
+			
+			std::vector<size_t> order;
+			order_edges(order);
+			
+			// 各部分について、最後に処理される辺の順番と、距離の下限
+			const size_t no_edge = static_cast<size_t>(-1);
+			std::vector<size_t> last_step(num_components, no_edge);
+			for(size_t k = 0; k < order.size(); ++k){
+				last_step[edges_[order[k]].component1] = k;
+				last_step[edges_[order[k]].component2] = k;
+			}
+			std::vector<EdgeWeightType> lower_bound(num_components, infinite_distance());
+			for(size_t c = 0; c < num_components; ++c){
+				for(typename CostTable::const_iterator it = costs_[c].begin(); it != costs_[c].end(); ++it){
+					lower_bound[c] = std::min(lower_bound[c], it->second);
+				}
+				if(lower_bound[c] == infinite_distance()) return false;
+			}
+			
+			// カットに使った辺を持たない部分はマスク0で確定
+			EdgeWeightType fixed_distance = 0;
+			EdgeWeightType remaining_bound = 0; // 未完了の部分の距離の下限の和
+			for(size_t c = 0; c < num_components; ++c){
+				if(last_step[c] == no_edge){
+					EdgeWeightType d = cost_of(costs_[c], MaskType(0));
+					if(d == infinite_distance()) return false;
+					fixed_distance += d;
+				}else{
+					remaining_bound += lower_bound[c];
+				}
+			}
+			
+			// 暫定解：カットに使った辺をどれも2回通らない場合
+			EdgeWeightType incumbent = fixed_distance;
+			for(size_t c = 0; c < num_components && incumbent != infinite_distance(); ++c){
+				if(last_step[c] == no_edge) continue;
+				EdgeWeightType d = cost_of(costs_[c], MaskType(0));
+				incumbent = (d == infinite_distance() ? infinite_distance() : incumbent + d);
+			}
+			
+			std::vector< std::vector<Node> > nodes(order.size() + 1);
+			std::vector<size_t> active; // 未完了の部分
+			std::map<StateKey, State> states, next_states;
+			Node root = { 0, false };
+			nodes[0].push_back(root);
+			State initial = { fixed_distance, 0 };
+			states[StateKey()] = initial;
+			
+			for(size_t k = 0; k < order.size(); ++k){
+				const CutEdge & edge = edges_[order[k]];
+				
+				// 新たに現れた部分を未完了の部分に加える
+				size_t slot1, slot2;
+				size_t endpoints[2] = { edge.component1, edge.component2 };
+				size_t slots[2];
+				for(size_t i = 0; i < 2; ++i){
+					slots[i] = std::find(active.begin(), active.end(), endpoints[i]) - active.begin();
+					if(slots[i] == active.size()){
+						active.push_back(endpoints[i]);
+						std::map<StateKey, State> extended;
+						for(typename std::map<StateKey, State>::iterator its = states.begin(); its != states.end(); ++its){
+							StateKey key(its->first);
+							key.push_back(MaskType(0));
+							extended.insert(extended.end(), std::make_pair(key, its->second));
+						}
+						states.swap(extended);
+					}
+				}
+				slot1 = slots[0];
+				slot2 = slots[1];
+				
+				// この辺を最後に完了する部分（active上の位置の降順）
+				std::vector<size_t> closing;
+				if(last_step[edge.component1] == k) closing.push_back(slot1);
+				if(last_step[edge.component2] == k && slot2 != slot1) closing.push_back(slot2);
+				std::sort(closing.rbegin(), closing.rend());
+				EdgeWeightType closing_bound = 0;
+				for(std::vector<size_t>::iterator itc = closing.begin(); itc != closing.end(); ++itc){
+					closing_bound += lower_bound[active[*itc]];
+				}
+				
+				next_states.clear();
+				for(typename std::map<StateKey, State>::iterator its = states.begin(); its != states.end(); ++its){
+					for(int doubled = 0; doubled <= 1; ++doubled){
+						StateKey key(its->first);
+						EdgeWeightType distance = its->second.distance;
+						if(doubled){
+							distance += edge.weight;
+							MaskTraits::flip(key[slot1], edge.bit1);
+							MaskTraits::flip(key[slot2], edge.bit2);
+						}
+						
+						bool feasible = true;
+						for(std::vector<size_t>::iterator itc = closing.begin(); itc != closing.end(); ++itc){
+							EdgeWeightType d = cost_of(costs_[active[*itc]], key[*itc]);
+							if(d == infinite_distance()){
+								feasible = false;
+								break;
+							}
+							distance += d;
+							key.erase(key.begin() + *itc);
+						}
+						if(!feasible) continue;
+						
+						// 残りの部分の下限を加えても暫定解より長くなるなら捨てる
+						if(incumbent != infinite_distance() && distance + (remaining_bound - closing_bound) > incumbent) continue;
+						
+						typename std::map<StateKey, State>::iterator itn = next_states.find(key);
+						if(itn != next_states.end() && itn->second.distance <= distance) continue;
+						
+						Node node = { its->second.node, doubled != 0 };
+						nodes[k + 1].push_back(node);
+						State state = { distance, nodes[k + 1].size() - 1 };
+						if(itn != next_states.end()){
+							itn->second = state;
+						}else{
+							next_states.insert(std::make_pair(key, state));
+						}
+					}
+				}
+				
+				for(std::vector<size_t>::iterator itc = closing.begin(); itc != closing.end(); ++itc){
+					active.erase(active.begin() + *itc);
+				}
+				remaining_bound -= closing_bound;
+				states.swap(next_states);
+				max_states_ = std::max(max_states_, states.size());
+				if(states.empty()) return false;
+			}
+			
+			// すべての部分が完了しているので、状態は空のキーただ一つ
+			const State & final_state = states.begin()->second;
+			best_distance_ = final_state.distance;
+			size_t node = final_state.node;
+			for(size_t k = order.size(); k > 0; --k){
+				doubled_[order[k - 1]] = nodes[k][node].doubled;
+				node = nodes[k][node].parent;
+			}
+			for(size_t e = 0; e < edges_.size(); ++e){
+				if(!doubled_[e]) continue;
+				MaskTraits::flip(component_masks_[edges_[e].component1], edges_[e].bit1);
+				MaskTraits::flip(component_masks_[edges_[e].component2], edges_[e].bit2);
+			}
+			return true;
+		}
+		
+		// カットに使った辺と各部分の、2回通る辺の距離の合計
+		inline EdgeWeightType best_distance() const{ return best_distance_; }
+		// doubled()[e]がtrueならedges[e]を2回通る
+		inline const std::vector<bool> & doubled() const{ return doubled_; }
+		// 最小の組み合わせにおける、各部分の境界の頂点のマスク
+		inline const std::vector<MaskType> & component_masks() const{ return component_masks_; }
+		// 同時に保持した状態の数の最大値
+		inline size_t max_states() const{ return max_states_; }
+	};
+	
+	typedef BasicCutCombiner<boost::multiprecision::cpp_int> CutCombiner;
+} // namespace ChinesePostman
+
+#endif // CUT_COMBINER_HPP_
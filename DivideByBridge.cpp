@@ -1,89 +1,167 @@
-#include "ChinesePostman.hpp"
-#include <iostream>
-#include <fstream>
-
-#define DIVIDE_BY_BRIDGE_BRIDGELIST "bridges"
-#define DIVIDE_BY_BRIDGE_COMPONENT "subgraph"
-#define DIVIDE_BY_BRIDGE_EXTENSION ".edges"
-
-int main(int argc, char ** argv){
-	if(argc <= 2){
-		std::cerr << "Usage: " << argv[0] << " FILENAME OUTPUT_DIR" << std::endl;
-		return 1;
-	}
-	
-	ChinesePostman::RouteNetwork rn;
-	ChinesePostman::EdgeWeightType total_distance = ChinesePostman::read_from(argv[1], rn);
-	if(total_distance == 0){
-		std::cerr << "Error: When reading \"" << argv[1] << "\"" << std::endl;
-		return 1;
-	}
-	
-	// Ot\\
-	std::cout << "[Graph Structure]" << std::endl;
-	rn.print();
-	std::cout << std::endl;
-	
-	// 2̒_
-	rn.remove_trivial_vertices();
-	
-	// o
-	ChinesePostman::BridgeDetector bd(rn);
-	
-	// o͂
-	std::string fname_bridges(argv[2]);
-	fname_bridges.append("/");
-	fname_bridges.append(DIVIDE_BY_BRIDGE_BRIDGELIST);
-	fname_bridges.append(DIVIDE_BY_BRIDGE_EXTENSION);
-	std::ofstream ofs(fname_bridges.c_str(), std::ios::binary);
-	if(!ofs){
-		std::cerr << "Error: When opening \"" << fname_bridges << "\"" << std::endl;
-		return 1;
-	}
-	
-	for(std::set<ChinesePostman::Graph::edge_descriptor>::iterator ite = bd.result().begin(); ite != bd.result().end(); ++ite){
-		ofs << boost::get(boost::edge_weight, rn, *ite) << " " << boost::get(boost::vertex_name, rn, boost::source(*ite, rn)) << " " << boost::get(boost::vertex_name, rn, boost::target(*ite, rn)) << std::endl;
-		boost::remove_edge(*ite, rn);
-	}
-	ofs.close();
-	std::cerr << "Wrote bridge list to \"" << fname_bridges << "\"" << std::endl;
-	
-	// 2̒_
-	rn.remove_trivial_vertices();
-	
-	// ꂽeOto͂
-	ChinesePostman::RouteNetworkList graph_divisions;
-	rn.connectedcomponents(graph_divisions);
-	for(ChinesePostman::RouteNetworkList::iterator itg = graph_divisions.begin(); itg != graph_divisions.end(); ++itg){
-		std::pair<ChinesePostman::Graph::vertex_iterator, ChinesePostman::Graph::vertex_iterator> vertex_range = boost::vertices(*itg);
-		if(vertex_range.first == vertex_range.second){
-			// _݂Ȃꍇ
-			continue;
-		}
-		
-		std::pair<ChinesePostman::Graph::edge_iterator, ChinesePostman::Graph::edge_iterator> edge_range = boost::edges(*itg);
-		if(edge_range.first == edge_range.second){
-			// ӂ݂Ȃꍇ
-			continue;
-		}
-		
-		std::string fname_component(argv[2]);
-		fname_component.append("/");
-		fname_component.append(DIVIDE_BY_BRIDGE_COMPONENT);
-		fname_component.append("-");
-		fname_component.append(boost::get(boost::vertex_name, *itg, *(vertex_range.first)));
-		fname_component.append(DIVIDE_BY_BRIDGE_EXTENSION);
-		
-		std::ofstream ofsc(fname_component.c_str(), std::ios::binary);
-		if(!ofsc){
-			std::cerr << "Error: When opening \"" << fname_component << "\"" << std::endl;
-			return 1;
-		}
-		
-		itg->print_bridge_list(ofsc);
-		ofsc.close();
-		std::cerr << "Wrote graph component to \"" << fname_component << "\"" << std::endl;
-	}
-	
-	return 0;
-}
+#include "ChinesePostman.hpp"
+#include "GraphPartition.hpp"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+
+#define DIVIDE_BY_BRIDGE_BRIDGELIST "bridges"
+#define DIVIDE_BY_BRIDGE_COMPONENT "subgraph"
+#define DIVIDE_BY_BRIDGE_DIVISION "division"
+#define DIVIDE_BY_BRIDGE_EXTENSION ".edges"
+
+int main(int argc, char ** argv){
+	// ---------- オプションの解釈
+	// --auto-cut N : 橋で分割した各部分を、さらに頂点（次数2の頂点を除去した後のもの）が
+	//                N個以下の部分に分けるようにカットする辺を選び、division-*.edgesに書き出す
+	std::vector<const char *> filenames;
+	size_t auto_cut_vertices = 0;
+	for(int i = 1; i < argc; ++i){
+		std::string arg(argv[i]);
+		if(arg == "--auto-cut" && i + 1 < argc){
+			auto_cut_vertices = std::strtoul(argv[++i], NULL, 10);
+			if(auto_cut_vertices == 0){
+				std::cerr << "Error: The argument of --auto-cut must be a positive integer" << std::endl;
+				return 1;
+			}
+		}else if(arg.compare(0, 2, "--") == 0){
+			std::cerr << "Error: Unknown option \"" << arg << "\"" << std::endl;
+			return 1;
+		}else{
+			filenames.push_back(argv[i]);
+		}
+	}
+	
+	if(filenames.size() != 2){
+		std::cerr << "Usage: " << argv[0] << " [--auto-cut N] FILENAME OUTPUT_DIR" << std::endl;
+		return 1;
+	}
+	
+	// バイナリ形式のファイルに橋が記録されていれば、それを使う（BridgeDetectorを参照）
+	ChinesePostman::RouteNetwork rn;
+	ChinesePostman::CompactGraph network;
+	ChinesePostman::EdgeWeightType total_distance = ChinesePostman::read_from(filenames[0], rn, std::shared_ptr<ChinesePostman::NameTable>(), &network);
+	if(total_distance == 0){
+		std::cerr << "Error: When reading \"" << filenames[0] << "\"" << std::endl;
+		return 1;
+	}
+	
+	// グラフ構造を表示
+	std::cout << "[Graph Structure]" << std::endl;
+	rn.print();
+	std::cout << std::endl;
+	
+	// 次数2の頂点を除去
+	rn.remove_trivial_vertices();
+	
+	// 橋を検出する
+	ChinesePostman::BridgeDetector bd(rn, network);
+	
+	// 橋を出力する
+	std::string fname_bridges(filenames[1]);
+	fname_bridges.append("/");
+	fname_bridges.append(DIVIDE_BY_BRIDGE_BRIDGELIST);
+	fname_bridges.append(DIVIDE_BY_BRIDGE_EXTENSION);
+	std::ofstream ofs(fname_bridges.c_str(), std::ios::binary);
+	if(!ofs){
+		std::cerr << "Error: When opening \"" << fname_bridges << "\"" << std::endl;
+		return 1;
+	}
+	
+	// 入力の形式（頂点のアドレス順）によらず同じ内容になるよう、
+	// 橋は番号の小さい駅を先にして、駅の番号の順に並べて書き出す
+	std::vector< std::pair< std::pair<ChinesePostman::VertexId, ChinesePostman::VertexId>, ChinesePostman::EdgeWeightType> > bridges;
+	for(std::vector<ChinesePostman::Graph::edge_descriptor>::const_iterator ite = bd.result().begin(); ite != bd.result().end(); ++ite){
+		ChinesePostman::VertexId v1 = rn.vertexid(boost::source(*ite, rn));
+		ChinesePostman::VertexId v2 = rn.vertexid(boost::target(*ite, rn));
+		if(v1 > v2) std::swap(v1, v2);
+		bridges.push_back(std::make_pair(std::make_pair(v1, v2), rn.edgeweight(*ite)));
+		boost::remove_edge(*ite, rn);
+	}
+	std::sort(bridges.begin(), bridges.end());
+	for(size_t k = 0; k < bridges.size(); ++k){
+		ofs << bridges[k].second << " " << rn.names().name(bridges[k].first.first) << " " << rn.names().name(bridges[k].first.second) << std::endl;
+	}
+	ofs.close();
+	std::cerr << "Wrote bridge list to \"" << fname_bridges << "\"" << std::endl;
+	
+	// 次数2の頂点を除去
+	rn.remove_trivial_vertices();
+	
+	// 分割された各グラフを出力する
+	ChinesePostman::RouteNetworkList graph_divisions;
+	rn.connectedcomponents(graph_divisions);
+	for(ChinesePostman::RouteNetworkList::iterator itg = graph_divisions.begin(); itg != graph_divisions.end(); ++itg){
+		std::pair<ChinesePostman::Graph::vertex_iterator, ChinesePostman::Graph::vertex_iterator> vertex_range = boost::vertices(*itg);
+		if(vertex_range.first == vertex_range.second){
+			// 頂点が存在しない場合
+			continue;
+		}
+		
+		std::pair<ChinesePostman::Graph::edge_iterator, ChinesePostman::Graph::edge_iterator> edge_range = boost::edges(*itg);
+		if(edge_range.first == edge_range.second){
+			// 辺が存在しない場合
+			continue;
+		}
+		
+		// 連結成分は番号が最小の駅の名前で呼ぶ（頂点の並びは入力の形式で変わりうるので使わない）
+		ChinesePostman::VertexId name_vertex = itg->vertexid(*(vertex_range.first));
+		for(ChinesePostman::Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+			name_vertex = std::min(name_vertex, itg->vertexid(*itv));
+		}
+		
+		std::string fname_component(filenames[1]);
+		fname_component.append("/");
+		fname_component.append(DIVIDE_BY_BRIDGE_COMPONENT);
+		fname_component.append("-");
+		fname_component.append(itg->names().name(name_vertex).to_string());
+		fname_component.append(DIVIDE_BY_BRIDGE_EXTENSION);
+		
+		std::ofstream ofsc(fname_component.c_str(), std::ios::binary);
+		if(!ofsc){
+			std::cerr << "Error: When opening \"" << fname_component << "\"" << std::endl;
+			return 1;
+		}
+		
+		itg->print_bridge_list(ofsc);
+		ofsc.close();
+		std::cerr << "Wrote graph component to \"" << fname_component << "\"" << std::endl;
+		
+		// カットする辺を選び、「subgraph」を「division」に置き換えた名前のファイルに書き出す
+		if(auto_cut_vertices == 0) continue;
+		ChinesePostman::CompactGraph compact;
+		itg->to_compact_graph(compact);
+		std::vector<size_t> part;
+		size_t num_parts = ChinesePostman::partition_graph(compact, auto_cut_vertices, part);
+		if(num_parts <= 1) continue;
+		
+		std::vector<ChinesePostman::EdgeId> cut_edges;
+		ChinesePostman::partition_cut_edges(compact, part, cut_edges);
+		std::vector<size_t> border_vertices;
+		ChinesePostman::partition_border_vertices(compact, part, num_parts, border_vertices);
+		size_t max_border_vertices = *std::max_element(border_vertices.begin(), border_vertices.end());
+		
+		std::string fname_division(filenames[1]);
+		fname_division.append("/");
+		fname_division.append(DIVIDE_BY_BRIDGE_DIVISION);
+		fname_division.append("-");
+		fname_division.append(itg->names().name(name_vertex).to_string());
+		fname_division.append(DIVIDE_BY_BRIDGE_EXTENSION);
+		
+		std::ofstream ofsd(fname_division.c_str(), std::ios::binary);
+		if(!ofsd){
+			std::cerr << "Error: When opening \"" << fname_division << "\"" << std::endl;
+			return 1;
+		}
+		for(std::vector<ChinesePostman::EdgeId>::const_iterator ite = cut_edges.begin(); ite != cut_edges.end(); ++ite){
+			ofsd << compact.edge_weight(*ite) << " " << itg->names().name(compact.edge_source(*ite)) << " " << itg->names().name(compact.edge_target(*ite)) << std::endl;
+		}
+		ofsd.close();
+		std::cerr << "Wrote " << cut_edges.size() << " cutting edge(s) into " << num_parts << " part(s) to \"" << fname_division << "\" (max border vertices per part: " << max_border_vertices << ")" << std::endl;
+		if(max_border_vertices > ChinesePostman::max_recommended_border_vertices()){
+			std::cerr << "Warning: A part has more than " << ChinesePostman::max_recommended_border_vertices() << " border vertices; solving it may take very long (try a larger --auto-cut)" << std::endl;
+		}
+	}
+	
+	return 0;
+}
@@ -0,0 +1,325 @@
+#ifndef GRAPH_PARTITION_HPP_
+#define GRAPH_PARTITION_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include "CompactGraph.hpp"
+#include <vector>
+#include <set>
+#include <algorithm>
+
+namespace ChinesePostman{
+	// partition_graphで、辺を持たない頂点に対するpartの値
+	inline size_t no_part(){ return static_cast<size_t>(-1); }
+	
+	// 境界の頂点がこの数を超える部分があれば警告する（SolveChinesePostmanでは部分ごとに2^(境界の頂点の数)通りを調べる）
+	inline size_t max_recommended_border_vertices(){ return 20; }
+	
+	// partition_graphの実際の計算。
+	// 頂点の集合を、連結な部分に分けてから、頂点数がmax_part_verticesを超える部分を二分割することを繰り返す。
+	class GraphPartitioner{
+	private:
+		const CompactGraph & graph_;
+		size_t max_part_vertices_;
+		std::vector<size_t> & part_;
+		size_t num_parts_;
+		
+		// 頂点ごとの作業用の値（調べている頂点の集合の外では使わない）
+		std::vector<size_t> group_; // 調べている頂点の集合の番号
+		std::vector<size_t> distance_; // 幅優先探索での距離
+		std::vector<unsigned char> side_; // 二分割したときの側（0か1）
+		std::vector<size_t> cross_; // 反対側の頂点への辺の数
+		std::vector<size_t> inner_degree_; // 調べている集合の中の頂点への辺の数（自己ループを除く）
+		std::vector<unsigned char> external_; // 調べている集合の外への辺を持つか（分けた後も境界の頂点になる）
+		std::vector<long> border_gain_; // 反対側に移したときに、境界の頂点が減る数
+		std::vector<long> gain_; // 反対側に移したときに、切る辺が減る数
+		std::vector<unsigned char> locked_; // このパスで既に移したか
+		std::vector<unsigned char> mark_; // 近傍を重ねて数えないための印
+		size_t next_group_;
+		
+		static size_t unreached(){ return static_cast<size_t>(-1); }
+		
+		// vertices（group_がgroupの頂点）の中でstartから幅優先探索をし、訪れた順にorderへ格納する
+		void breadth_first(VertexId start, size_t group, std::vector<VertexId> & order){
+			order.clear();
+			order.push_back(start);
+			distance_[start] = 0;
+			for(size_t i = 0; i < order.size(); ++i){
+				VertexId v = order[i];
+				for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+					VertexId w = graph_.adjacent_vertex(pos);
+					if(group_[w] != group || distance_[w] != unreached()) continue;
+					distance_[w] = distance_[v] + 1;
+					order.push_back(w);
+				}
+			}
+		}
+		
+		// 頂点の集合verticesを、（verticesの中の辺だけで）連結な部分に分ける
+		void split_connected(const std::vector<VertexId> & vertices, std::vector< std::vector<VertexId> > & pieces){
+			size_t group = next_group_++;
+			for(std::vector<VertexId>::const_iterator itv = vertices.begin(); itv != vertices.end(); ++itv){
+				group_[*itv] = group;
+				distance_[*itv] = unreached();
+			}
+			for(std::vector<VertexId>::const_iterator itv = vertices.begin(); itv != vertices.end(); ++itv){
+				if(distance_[*itv] != unreached()) continue;
+				pieces.push_back(std::vector<VertexId>());
+				breadth_first(*itv, group, pieces.back());
+			}
+		}
+		
+		// vの近傍のうち、同じ側にある辺と反対側にある辺の数の差（反対側に移したときに、切る辺が減る数）
+		long compute_gain(VertexId v, size_t group) const{
+			long result = 0;
+			for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+				VertexId w = graph_.adjacent_vertex(pos);
+				if(w == v || group_[w] != group) continue;
+				result += (side_[w] == side_[v] ? -1 : 1);
+			}
+			return result;
+		}
+		
+		// 頂点が、二分割した後に境界の頂点になるか
+		inline bool is_border(VertexId v) const{
+			return cross_[v] > 0 || external_[v];
+		}
+		
+		// vを反対側に移したときに、境界の頂点（v自身と近傍）が減る数。
+		// 近傍のcross_を仮に書き換えて、移す前と後の境界の頂点を数える
+		long compute_border_gain(VertexId v, size_t group){
+			long before = (is_border(v) ? 1 : 0);
+			long after = (inner_degree_[v] - cross_[v] > 0 || external_[v] ? 1 : 0);
+			for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+				VertexId w = graph_.adjacent_vertex(pos);
+				if(w == v || group_[w] != group || mark_[w]) continue;
+				mark_[w] = 1;
+				if(is_border(w)) ++before;
+			}
+			for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+				VertexId w = graph_.adjacent_vertex(pos);
+				if(w == v || group_[w] != group) continue;
+				if(side_[w] == side_[v]) ++cross_[w]; else --cross_[w];
+			}
+			for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+				VertexId w = graph_.adjacent_vertex(pos);
+				if(w == v || group_[w] != group || !mark_[w]) continue;
+				mark_[w] = 0;
+				if(is_border(w)) ++after;
+			}
+			for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+				VertexId w = graph_.adjacent_vertex(pos);
+				if(w == v || group_[w] != group) continue;
+				if(side_[w] == side_[v]) --cross_[w]; else ++cross_[w];
+			}
+			return before - after;
+		}
+		
+		// 連結な頂点の集合piece（group_はgroup）を二分割する。
+		// 擬似直径の一端から幅優先探索で目標の数の頂点を集めて初期の分割とし、
+		// Fiduccia-Mattheyses法（Kernighan-Lin法の改良）で境界の頂点の数を減らす
+		// （境界の頂点が同じなら、切る辺の数を減らす）。境界の頂点は、反対側への辺か、
+		// pieceの外への辺を持つ頂点で、部分ごとに2^(境界の頂点の数)通りを調べることになるため、これを主に減らす。
+		void bisect(const std::vector<VertexId> & piece, size_t group, std::vector<VertexId> & first, std::vector<VertexId> & second){
+			// 頂点の数がmax_part_vertices_以下の部分がなるべく少なくなるよう、
+			// 最終的な部分の数の半分に相当する頂点を一方に集める
+			size_t num_final_parts = (piece.size() + max_part_vertices_ - 1) / max_part_vertices_;
+			size_t target = piece.size() * (num_final_parts / 2) / num_final_parts;
+			size_t tolerance = std::max<size_t>(1, piece.size() / 20);
+			
+			// 擬似直径の一端（幅優先探索で最も遠い頂点を2回求める）
+			std::vector<VertexId> order;
+			VertexId start = piece.front();
+			for(size_t sweep = 0; sweep < 2; ++sweep){
+				for(std::vector<VertexId>::const_iterator itv = piece.begin(); itv != piece.end(); ++itv) distance_[*itv] = unreached();
+				breadth_first(start, group, order);
+				start = order.back();
+			}
+			for(std::vector<VertexId>::const_iterator itv = piece.begin(); itv != piece.end(); ++itv) distance_[*itv] = unreached();
+			breadth_first(start, group, order);
+			for(size_t i = 0; i < order.size(); ++i) side_[order[i]] = (i < target ? 0 : 1);
+			
+			// Fiduccia-Mattheyses法。1回のパスで各頂点を高々1回ずつ、移せる中で最も境界の頂点（同じなら切る辺）が
+			// 減る頂点から移し、最も少なくなった時点まで戻す。減らなくなるまでパスを繰り返す
+			typedef std::pair< std::pair<long, long>, VertexId > Candidate; // （(-border_gain, -gain), 頂点）
+			std::set<Candidate> candidates[2]; // 側ごと
+			auto candidate = [&](VertexId v){ return Candidate(std::make_pair(-border_gain_[v], -gain_[v]), v); };
+			size_t size[2] = { target, piece.size() - target };
+			for(size_t pass = 0; pass < 8; ++pass){
+				candidates[0].clear();
+				candidates[1].clear();
+				for(std::vector<VertexId>::const_iterator itv = piece.begin(); itv != piece.end(); ++itv){
+					VertexId v = *itv;
+					cross_[v] = 0;
+					inner_degree_[v] = 0;
+					external_[v] = 0;
+					for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+						VertexId w = graph_.adjacent_vertex(pos);
+						if(w == v) continue;
+						if(group_[w] != group){
+							external_[v] = 1;
+							continue;
+						}
+						++inner_degree_[v];
+						if(side_[w] != side_[v]) ++cross_[v];
+					}
+				}
+				for(std::vector<VertexId>::const_iterator itv = piece.begin(); itv != piece.end(); ++itv){
+					gain_[*itv] = compute_gain(*itv, group);
+					border_gain_[*itv] = compute_border_gain(*itv, group);
+					locked_[*itv] = 0;
+					candidates[side_[*itv]].insert(candidate(*itv));
+				}
+				
+				std::vector<VertexId> moved;
+				std::pair<long, long> total_gain(0, 0), best_gain(0, 0); // （境界の頂点, 切る辺）の減った数
+				size_t best_moves = 0;
+				for(;;){
+					// 移した後も、両側の頂点の数が目標から許容範囲内に収まる側から選ぶ
+					int from = -1;
+					for(int s = 0; s < 2; ++s){
+						if(candidates[s].empty()) continue;
+						size_t target_s = (s == 0 ? target : piece.size() - target);
+						if(size[s] <= 1 || size[s] + tolerance <= target_s) continue;
+						if(from == -1 || candidates[s].begin()->first < candidates[from].begin()->first) from = s;
+					}
+					if(from == -1) break;
+					
+					VertexId v = candidates[from].begin()->second;
+					candidates[from].erase(candidates[from].begin());
+					total_gain.first += border_gain_[v];
+					total_gain.second += gain_[v];
+					side_[v] = static_cast<unsigned char>(1 - from);
+					--size[from];
+					++size[1 - from];
+					locked_[v] = 1;
+					moved.push_back(v);
+					if(total_gain > best_gain){
+						best_gain = total_gain;
+						best_moves = moved.size();
+					}
+					
+					// 近傍の値を更新する。境界の頂点が減る数は、近傍のcross_で決まるので、2つ先の頂点まで求め直す
+					cross_[v] = inner_degree_[v] - cross_[v];
+					std::vector<VertexId> affected;
+					for(size_t pos = graph_.adjacency_begin(v); pos < graph_.adjacency_end(v); ++pos){
+						VertexId w = graph_.adjacent_vertex(pos);
+						if(w == v || group_[w] != group) continue;
+						if(side_[w] == side_[v]) --cross_[w]; else ++cross_[w];
+						if(!locked_[w]){
+							candidates[side_[w]].erase(candidate(w));
+							gain_[w] += (side_[w] == side_[v] ? -2 : 2);
+							candidates[side_[w]].insert(candidate(w));
+						}
+						for(size_t pos2 = graph_.adjacency_begin(w); pos2 < graph_.adjacency_end(w); ++pos2){
+							VertexId x = graph_.adjacent_vertex(pos2);
+							if(group_[x] != group || locked_[x] || mark_[x]) continue;
+							mark_[x] = 1;
+							affected.push_back(x);
+						}
+						if(!locked_[w] && !mark_[w]){
+							mark_[w] = 1;
+							affected.push_back(w);
+						}
+					}
+					for(std::vector<VertexId>::const_iterator itx = affected.begin(); itx != affected.end(); ++itx) mark_[*itx] = 0;
+					for(std::vector<VertexId>::const_iterator itx = affected.begin(); itx != affected.end(); ++itx){
+						candidates[side_[*itx]].erase(candidate(*itx));
+						border_gain_[*itx] = compute_border_gain(*itx, group);
+						candidates[side_[*itx]].insert(candidate(*itx));
+					}
+				}
+				
+				// 最も切る辺が少なかった時点まで戻す
+				for(size_t i = moved.size(); i > best_moves; --i){
+					VertexId v = moved[i - 1];
+					--size[side_[v]];
+					side_[v] = static_cast<unsigned char>(1 - side_[v]);
+					++size[side_[v]];
+				}
+				if(best_gain <= std::make_pair(0L, 0L)) break;
+			}
+			
+			for(std::vector<VertexId>::const_iterator itv = piece.begin(); itv != piece.end(); ++itv){
+				(side_[*itv] == 0 ? first : second).push_back(*itv);
+			}
+		}
+	
+	public:
+		GraphPartitioner(const CompactGraph & graph, size_t max_part_vertices, std::vector<size_t> & part)
+		: graph_(graph), max_part_vertices_(std::max<size_t>(1, max_part_vertices)), part_(part), num_parts_(0),
+		  group_(graph.num_vertices(), unreached()), distance_(graph.num_vertices(), unreached()),
+		  side_(graph.num_vertices(), 0), cross_(graph.num_vertices(), 0), inner_degree_(graph.num_vertices(), 0), external_(graph.num_vertices(), 0),
+		  border_gain_(graph.num_vertices(), 0), gain_(graph.num_vertices(), 0), locked_(graph.num_vertices(), 0), mark_(graph.num_vertices(), 0), next_group_(0) {}
+		
+		size_t run(){
+			part_.assign(graph_.num_vertices(), no_part());
+			std::vector<VertexId> vertices;
+			for(VertexId v = 0; v < graph_.num_vertices(); ++v){
+				if(graph_.adjacency_begin(v) != graph_.adjacency_end(v)) vertices.push_back(v);
+			}
+			
+			// 分割する頂点の集合を、再帰の代わりに明示的なスタックで持つ
+			std::vector< std::vector<VertexId> > stack;
+			stack.push_back(std::vector<VertexId>());
+			stack.back().swap(vertices);
+			while(!stack.empty()){
+				std::vector<VertexId> current;
+				current.swap(stack.back());
+				stack.pop_back();
+				
+				std::vector< std::vector<VertexId> > pieces;
+				split_connected(current, pieces);
+				for(std::vector< std::vector<VertexId> >::iterator itp = pieces.begin(); itp != pieces.end(); ++itp){
+					if(itp->size() <= max_part_vertices_){
+						for(std::vector<VertexId>::const_iterator itv = itp->begin(); itv != itp->end(); ++itv) part_[*itv] = num_parts_;
+						++num_parts_;
+						continue;
+					}
+					std::vector<VertexId> first, second;
+					bisect(*itp, group_[itp->front()], first, second);
+					stack.push_back(std::vector<VertexId>());
+					stack.back().swap(second);
+					stack.push_back(std::vector<VertexId>());
+					stack.back().swap(first);
+				}
+			}
+			return num_parts_;
+		}
+	};
+	
+	// 辺で切ってグラフを小さな部分に分ける（カットする辺を自動で選ぶ）。
+	// 辺を持つ頂点を、連結で頂点の数がmax_part_vertices以下の部分に分け、
+	// part[v]に頂点vが属する部分の番号（辺を持たない頂点はno_part()）を格納する。返り値は部分の数。
+	// 大きすぎる部分を二分割することを繰り返す（GraphPartitionerを参照）。
+	// 二分割では、境界の頂点（部分の外への辺を持つ頂点）の数がなるべく少なくなるようにし、同じなら
+	// 部分の間をまたぐ辺（カットする辺）の数を少なくする（部分ごとに2^(境界の頂点の数)通りを調べることになるため）。
+	// 部分ごとの境界の頂点の数に上限は設けないので、partition_border_verticesで確かめること。
+	// 最小であることは保証しない。頂点の番号だけで決まり、同じグラフからは同じ分割が得られる。
+	size_t partition_graph(const CompactGraph & graph, size_t max_part_vertices, std::vector<size_t> & part){
+		GraphPartitioner partitioner(graph, max_part_vertices, part);
+		return partitioner.run();
+	}
+	
+	// partition_graphで分けた部分の間をまたぐ辺の番号を、昇順にresultへ格納する
+	void partition_cut_edges(const CompactGraph & graph, const std::vector<size_t> & part, std::vector<EdgeId> & result){
+		result.clear();
+		for(EdgeId e = 0; e < graph.num_edges(); ++e){
+			if(part[graph.edge_source(e)] != part[graph.edge_target(e)]) result.push_back(e);
+		}
+	}
+	
+	// partition_graphで分けた部分ごとの、境界の頂点（部分の外への辺を持つ頂点）の数
+	void partition_border_vertices(const CompactGraph & graph, const std::vector<size_t> & part, size_t num_parts, std::vector<size_t> & result){
+		result.assign(num_parts, 0);
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+				if(part[graph.adjacent_vertex(pos)] != part[v]){
+					++result[part[v]];
+					break;
+				}
+			}
+		}
+	}
+} // namespace ChinesePostman
+
+#endif // GRAPH_PARTITION_HPP_
@@ -0,0 +1,422 @@
+#ifndef INCREMENTAL_SOLVER_HPP_
+#define INCREMENTAL_SOLVER_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include "CompactGraph.hpp"
+#include "ShortestPaths.hpp"
+#include "PerfectMatching.hpp"
+#include "ThreadPool.hpp"
+#include "PostmanTour.hpp"
+#include "Instrumentation.hpp"
+#include <vector>
+#include <deque>
+#include <memory>
+
+namespace ChinesePostman{
+	// 辺の距離の変更や区間の閉鎖・再開を受け付け、影響のある部分だけを解き直す郵便配達問題のソルバ。
+	//
+	// 路線網（CompactGraph）そのものは変更せず、辺ごとの距離と閉じているかを別に持つ（EdgeOverlayを参照）。
+	// 橋と閉じた辺を除いた連結成分ごとに、奇数次の頂点同士の最短距離・最短経路木と最小マッチングを保持し、
+	// 変更はresolveを呼んだときにまとめて反映する。
+	// ・辺を閉じたり開いたりした場合は、橋と連結成分を（線形時間で）求め直す。頂点の集合が変わらない連結成分は
+	// 　それまでの結果を引き継ぎ、それ以外の連結成分は最初から求める。
+	// ・引き継いだ連結成分では、変えた辺ごとに、その辺で最短距離が変わりうる始点だけを求め直す。
+	// 　辺の距離が増えた（閉じた）場合は、その辺を最短経路木に含む始点。
+	// 　辺の距離が減った（開いた）場合は、木を求めたときの距離で、その辺を通ると端点への距離が縮む始点。
+	// ・辺を閉じたり開いたりして新たに奇数次になった頂点は、始点の末尾に加え、ほかのすべての始点への距離を求める。
+	// 　奇数次でなくなった頂点も始点として残す（以前の木の並びを崩さないため）。
+	// 変更のあった連結成分は記録しておき、resolveではそれだけを調べる（連結成分の数によらない）。
+	// 最短距離が変わった連結成分だけ最小マッチングを解き直す。その際、前回のマッチングで組になった頂点が
+	// 今回も同じ連結成分で奇数次なら、その組を最初から候補に加える（solve_complete_matchingを参照）。
+	// 最小マッチングは常にblossomアルゴリズムで求める（MatchingOptionsのbackendは使わない）。
+	class IncrementalSolver{
+	private:
+		// 連結成分（橋と閉じた辺を除いたもの）ごとの結果。
+		// 最短距離と最短経路木は、連結成分の頂点とその間の辺（閉じた辺も含む）に番号を振り直したgraphの上で
+		// 求める（閉じた辺はEdgeOverlayで除く）。1つの始点を求め直す手間は、路線網全体ではなく連結成分の大きさによる。
+		// 始点ごとの最短距離は、i番目の始点からi+1番目以降covered_end[i]番目未満の始点への距離
+		// （full_row[i]が真なら、ほかのすべての始点への距離）を、最短経路木とともに求める。
+		struct Component{
+			std::vector<VertexId> vertices; // 頂点（昇順）
+			CompactGraph graph;
+			std::vector<EdgeId> edges; // graphの辺に対応するnetwork_の辺
+			std::vector<VertexId> terminals; // 最短距離を求める始点（最短距離の表と最短経路木の始点の順）
+			std::vector<VertexId> local_terminals; // 始点のgraphでの番号
+			std::vector<size_t> terminal_index; // graphの頂点→始点としての番号（始点でなければno_terminal()）
+			std::vector<unsigned char> odd; // 始点が現在奇数次か
+			std::vector<unsigned char> full_row;
+			std::vector<size_t> covered_end;
+			std::vector<EdgeWeightType> radius; // 始点から、距離を求めた最も遠い始点までの距離
+			std::vector<unsigned char> stale_rows; // 最短距離を求め直す始点
+			CompactDistanceMatrix distances;
+			ShortestPathTrees trees;
+			bool matched; // 最小マッチングを求めてから、奇数次の頂点と最短距離が変わっていないか
+			bool dirty; // dirty_に含まれているか
+			std::deque<SubRoute> doubled_edges;
+			
+			static size_t no_terminal(){ return static_cast<size_t>(-1); }
+			
+			void add_terminal(VertexId v, VertexId local, bool full){
+				terminal_index[local] = terminals.size();
+				terminals.push_back(v);
+				local_terminals.push_back(local);
+				odd.push_back(1);
+				full_row.push_back(full ? 1 : 0);
+				covered_end.push_back(0);
+				radius.push_back(0);
+				stale_rows.push_back(1);
+				distances.add_vertex(v);
+				trees.add_source(local);
+			}
+			
+			// 始点i, jの間の最短経路を含む木（の始点の番号）
+			size_t covering_row(size_t i, size_t j) const{
+				if(i > j) std::swap(i, j);
+				return (full_row[i] || j < covered_end[i] ? i : j);
+			}
+		};
+		
+		CompactGraph network_;
+		MatchingOptions matching_options_;
+		std::vector<EdgeWeightType> weights_; // 辺ごとの現在の距離
+		std::vector<bool> closed_; // 閉じた辺
+		
+		std::vector<EdgeId> bridges_; // 閉じた辺を除いたときの橋（昇順）
+		std::vector<bool> removed_; // 橋か閉じた辺（連結成分の中の最短経路には使われない）
+		std::vector<size_t> component_; // 頂点ごとの連結成分の番号
+		std::vector<VertexId> local_index_; // 頂点→その連結成分のgraphでの番号
+		std::vector<EdgeId> local_edge_; // 連結成分の中の辺→その連結成分のgraphでの番号
+		std::vector<VertexId> subgraph_index_; // induced_subgraphの作業領域
+		std::vector< std::unique_ptr<Component> > components_;
+		std::vector<VertexId> partner_; // 前回のマッチングで組になった頂点
+		// 求め直す始点があるか、最小マッチングを求め直す連結成分の番号（resolveで全ての連結成分を調べずに済むように）
+		std::vector<size_t> dirty_;
+		
+		// resolveでまだ反映していない変更
+		bool structure_changed_; // 辺を閉じたか開いた
+		std::vector< std::pair<EdgeId, EdgeWeightType> > changes_; // 変えた辺と、変える前の連結成分の中での距離
+		
+		static size_t no_component(){ return static_cast<size_t>(-1); }
+		
+		// 連結成分の中の最短経路で見た、辺eの距離（橋や閉じた辺は通れない）
+		inline EdgeWeightType effective_weight(EdgeId e) const{
+			return removed_[e] ? unreachable_distance() : weights_[e];
+		}
+		
+		void mark_dirty(size_t id){
+			if(components_[id]->dirty) return;
+			components_[id]->dirty = true;
+			dirty_.push_back(id);
+		}
+		
+		// 橋と連結成分を求め直す。頂点の集合が変わらない連結成分は前回のものを引き継ぐ
+		void rebuild_components(){
+			bridge_edges(network_, bridges_, &closed_);
+			removed_ = closed_;
+			for(std::vector<EdgeId>::const_iterator ite = bridges_.begin(); ite != bridges_.end(); ++ite){
+				removed_[*ite] = true;
+			}
+			size_t num_components = connected_components(network_, component_, &removed_);
+			std::vector< std::vector<VertexId> > vertices(num_components);
+			for(VertexId v = 0; v < network_.num_vertices(); ++v){
+				vertices[component_[v]].push_back(v);
+			}
+			
+			// 前回の連結成分を、最も番号の小さい頂点から引けるようにする
+			std::vector< std::unique_ptr<Component> > old_components;
+			old_components.swap(components_);
+			std::vector<size_t> old_index(network_.num_vertices(), no_component());
+			for(size_t k = 0; k < old_components.size(); ++k){
+				old_index[old_components[k]->vertices.front()] = k;
+			}
+			
+			components_.resize(num_components);
+			dirty_.clear();
+			size_t reused = 0;
+			for(size_t id = 0; id < num_components; ++id){
+				size_t k = old_index[vertices[id].front()];
+				if(k != no_component() && old_components[k]->vertices == vertices[id]){
+					components_[id].swap(old_components[k]);
+					++reused;
+					continue;
+				}
+				
+				components_[id].reset(new Component());
+				Component & component = *components_[id];
+				component.vertices.swap(vertices[id]);
+				induced_subgraph(network_, component.vertices, NULL, subgraph_index_, component.graph, component.edges);
+				component.trees.assign(component.graph.num_vertices(), std::vector<VertexId>(), true);
+				component.terminal_index.assign(component.graph.num_vertices(), Component::no_terminal());
+				component.matched = false;
+				component.dirty = false;
+				mark_dirty(id);
+				for(size_t k = 0; k < component.vertices.size(); ++k){
+					if(degree(component.vertices[k]) % 2 == 1) component.add_terminal(component.vertices[k], static_cast<VertexId>(k), false);
+				}
+			}
+			for(size_t id = 0; id < num_components; ++id){
+				const Component & component = *components_[id];
+				for(size_t k = 0; k < component.vertices.size(); ++k) local_index_[component.vertices[k]] = static_cast<VertexId>(k);
+				for(size_t k = 0; k < component.edges.size(); ++k) local_edge_[component.edges[k]] = static_cast<EdgeId>(k);
+			}
+			count(matching_options_.instrumentation, "components_reused", static_cast<long long>(reused));
+		}
+		
+		// 橋と閉じた辺を除いたときの頂点vの次数
+		size_t degree(VertexId v) const{
+			size_t result = 0;
+			for(size_t pos = network_.adjacency_begin(v); pos < network_.adjacency_end(v); ++pos){
+				if(!removed_[network_.adjacent_edge(pos)]) ++result;
+			}
+			return result;
+		}
+		
+		// 頂点vの次数の偶奇を反映する（新たに奇数次になった頂点は始点に加える）
+		void update_parity(Component & component, VertexId v){
+			bool odd = (degree(v) % 2 == 1);
+			size_t i = component.terminal_index[local_index_[v]];
+			if(i != Component::no_terminal()){
+				if((component.odd[i] != 0) == odd) return;
+				component.odd[i] = (odd ? 1 : 0);
+			}else{
+				if(!odd) return;
+				component.add_terminal(v, local_index_[v], true);
+			}
+			component.matched = false;
+		}
+		
+		// 辺eの連結成分の中での距離をold_weightから変えたときに、最短距離を求め直す始点を決める
+		void apply_change(EdgeId e, EdgeWeightType old_weight){
+			VertexId v1 = network_.edge_source(e), v2 = network_.edge_target(e);
+			if(component_[v1] != component_[v2]) return; // 橋や、連結成分をまたぐ閉じた辺
+			size_t id = component_[v1];
+			Component & component = *components_[id];
+			update_parity(component, v1);
+			update_parity(component, v2);
+			
+			VertexId l1 = local_index_[v1], l2 = local_index_[v2];
+			EdgeId local_e = local_edge_[e];
+			EdgeWeightType new_weight = effective_weight(e);
+			for(size_t i = 0; i < component.terminals.size(); ++i){
+				if(component.stale_rows[i]) continue;
+				if(new_weight > old_weight){
+					if(component.trees.predecessor(i, l1) != local_e && component.trees.predecessor(i, l2) != local_e) continue;
+				}else if(new_weight < old_weight){
+					// 最も遠い始点より近い頂点の距離は確定している。辺を通っても最も遠い始点より遠くなるか、
+					// どちらの端点への距離も縮まなければ、この始点からの最短距離は変わらない
+					EdgeWeightType r = component.radius[i];
+					EdgeWeightType d1 = std::min(component.trees.distance(i, l1), r);
+					EdgeWeightType d2 = std::min(component.trees.distance(i, l2), r);
+					if(std::min(d1, d2) >= r || std::min(d1, d2) + new_weight >= r) continue;
+					if(d1 < r && d2 < r && d1 + new_weight >= d2 && d2 + new_weight >= d1) continue;
+				}else{
+					continue;
+				}
+				component.stale_rows[i] = 1;
+				mark_dirty(id);
+			}
+			if(!component.matched) mark_dirty(id);
+		}
+		
+		// 求め直す始点からの最短距離を求め、距離が変わった場合は最小マッチングを求め直すようにする
+		void update_distances(Component & component){
+			EdgeOverlay overlay(&weights_, &removed_, &component.edges);
+			size_t n = component.terminals.size();
+			std::vector<EdgeWeightType> old_row(n);
+			for(size_t i = 0; i < n; ++i){
+				if(!component.stale_rows[i]) continue;
+				component.stale_rows[i] = 0;
+				for(size_t j = 0; j < n; ++j){
+					if(j != i) old_row[j] = component.distances(i, j);
+				}
+				terminal_shortest_distances_row(component.graph, component.local_terminals, i, component.distances, &component.trees, &overlay, component.full_row[i] != 0);
+				count(matching_options_.instrumentation, "shortest_path_rows");
+				component.covered_end[i] = n;
+				component.radius[i] = 0;
+				for(size_t j = (component.full_row[i] ? 0 : i + 1); j < n; ++j){
+					if(j != i) component.radius[i] = std::max(component.radius[i], component.distances(i, j));
+				}
+				for(size_t j = 0; j < n && component.matched; ++j){
+					if(j != i && component.distances(i, j) != old_row[j]) component.matched = false;
+				}
+			}
+		}
+		
+		void solve_matching(Component & component){
+			std::vector<size_t> odd_terminals; // 奇数次の始点の番号
+			std::vector<size_t> position(component.terminals.size(), component.terminals.size()); // 始点の番号→odd_terminals上の番号
+			for(size_t i = 0; i < component.terminals.size(); ++i){
+				if(!component.odd[i]) continue;
+				position[i] = odd_terminals.size();
+				odd_terminals.push_back(i);
+			}
+			size_t n = odd_terminals.size();
+			std::vector< std::pair<size_t, size_t> > initial_candidates;
+			for(size_t k = 0; k < n; ++k){
+				VertexId v = component.terminals[odd_terminals[k]], partner = partner_[v];
+				if(component_[partner] != component_[v]) continue;
+				size_t i = component.terminal_index[local_index_[partner]];
+				if(i == Component::no_terminal()) continue;
+				size_t j = position[i];
+				if(j != component.terminals.size() && j != k) initial_candidates.push_back(std::make_pair(k, j));
+			}
+			
+			std::vector<size_t> mate;
+			CompleteMatchingStatistics statistics;
+			bool solved = solve_complete_matching(
+				n,
+				[&](size_t k1, size_t k2){ return component.distances(odd_terminals[k1], odd_terminals[k2]); },
+				matching_options_.candidate_neighbors, mate, &initial_candidates, (matching_options_.instrumentation != NULL ? &statistics : NULL));
+			count(matching_options_.instrumentation, "matchings");
+			count(matching_options_.instrumentation, "matching_rounds", static_cast<long long>(statistics.rounds));
+			count(matching_options_.instrumentation, "matching_columns", static_cast<long long>(statistics.columns));
+			if(!solved){
+				// 連結成分の奇数次の頂点は偶数個で、全ての組の距離が有限なので起こらないはず
+				std::cerr << "Unexpected Error: no perfect matching among " << n << " odd vertices" << std::endl;
+				throw unexpected_graph_exception();
+			}
+			
+			component.doubled_edges.clear();
+			for(size_t k = 0; k < n; ++k){
+				size_t i = odd_terminals[k], j = odd_terminals[mate[k]];
+				if(mate[k] > k) component.doubled_edges.push_back(SubRoute(component.terminals[i], component.terminals[j], component.distances(i, j)));
+				partner_[component.terminals[i]] = component.terminals[j];
+			}
+			component.matched = true;
+		}
+	
+	public:
+		struct unexpected_graph_exception{};
+		
+		IncrementalSolver(const CompactGraph & network, const MatchingOptions & matching_options = MatchingOptions())
+		: network_(network), matching_options_(matching_options), weights_(network.num_edges()), closed_(network.num_edges(), false),
+		  local_index_(network.num_vertices()), local_edge_(network.num_edges()), subgraph_index_(network.num_vertices(), static_cast<VertexId>(network.num_vertices())),
+		  partner_(network.num_vertices()), structure_changed_(true){
+			for(EdgeId e = 0; e < network_.num_edges(); ++e) weights_[e] = network_.edge_weight(e);
+			for(VertexId v = 0; v < network_.num_vertices(); ++v) partner_[v] = v;
+			resolve();
+		}
+		
+		// 路線網（辺の距離は元のまま。現在の距離はedge_weightで得る）
+		inline const CompactGraph & network() const{ return network_; }
+		
+		inline EdgeWeightType edge_weight(EdgeId e) const{ return weights_[e]; }
+		inline bool closed(EdgeId e) const{ return closed_[e]; }
+		
+		// 辺eの距離を変える（resolveを呼ぶまで結果には反映しない）
+		void set_edge_weight(EdgeId e, EdgeWeightType weight){
+			if(weights_[e] == weight) return;
+			changes_.push_back(std::make_pair(e, effective_weight(e)));
+			weights_[e] = weight;
+		}
+		
+		// 辺eを閉じる（通らない）・開く（resolveを呼ぶまで結果には反映しない）
+		void close_edge(EdgeId e){
+			if(closed_[e]) return;
+			changes_.push_back(std::make_pair(e, effective_weight(e)));
+			closed_[e] = true;
+			structure_changed_ = true;
+		}
+		void open_edge(EdgeId e){
+			if(!closed_[e]) return;
+			changes_.push_back(std::make_pair(e, effective_weight(e)));
+			closed_[e] = false;
+			structure_changed_ = true;
+		}
+		
+		// まだ反映していない変更があるか
+		inline bool pending() const{
+			return structure_changed_ || !changes_.empty();
+		}
+		
+		// 変更を反映し、影響のある連結成分だけ解き直す。返り値は最小マッチングを求め直した連結成分の数。
+		// 連結成分ごとの計算は、matching_options.num_threadsのスレッドで並行して行う。
+		size_t resolve(){
+			Instrumentation * instrumentation = matching_options_.instrumentation;
+			if(structure_changed_){
+				ScopedPhase phase(instrumentation, "components");
+				rebuild_components();
+			}
+			for(std::vector< std::pair<EdgeId, EdgeWeightType> >::const_iterator itc = changes_.begin(); itc != changes_.end(); ++itc){
+				apply_change(itc->first, itc->second);
+			}
+			structure_changed_ = false;
+			changes_.clear();
+			
+			std::vector<size_t> targets;
+			targets.swap(dirty_);
+			std::sort(targets.begin(), targets.end());
+			for(std::vector<size_t>::const_iterator itt = targets.begin(); itt != targets.end(); ++itt){
+				components_[*itt]->dirty = false;
+			}
+			{
+				ScopedPhase phase(instrumentation, "shortest_paths");
+				parallel_for(targets.size(), matching_options_.num_threads, [&](size_t k){
+					update_distances(*components_[targets[k]]);
+				});
+			}
+			
+			// 最短距離が変わらなかった連結成分は、最小マッチングも変わらない
+			std::vector<size_t> unmatched;
+			for(std::vector<size_t>::const_iterator itt = targets.begin(); itt != targets.end(); ++itt){
+				if(!components_[*itt]->matched) unmatched.push_back(*itt);
+			}
+			{
+				ScopedPhase phase(instrumentation, "matching");
+				parallel_for(unmatched.size(), matching_options_.num_threads, [&](size_t k){
+					solve_matching(*components_[unmatched[k]]);
+				});
+			}
+			return unmatched.size();
+		}
+		
+		// 閉じた辺を除いたときの橋（2回通る）
+		inline const std::vector<EdgeId> & bridges() const{ return bridges_; }
+		
+		// 橋以外で2回通る区間を、連結成分の順にresultの末尾に加える
+		void doubled_edges(std::deque<SubRoute> & result) const{
+			for(size_t id = 0; id < components_.size(); ++id){
+				result.insert(result.end(), components_[id]->doubled_edges.begin(), components_[id]->doubled_edges.end());
+			}
+		}
+		
+		// 2回通る辺（橋と、橋以外で2回通る区間）の距離の合計
+		EdgeWeightType doubled_distance() const{
+			EdgeWeightType result = 0;
+			for(std::vector<EdgeId>::const_iterator ite = bridges_.begin(); ite != bridges_.end(); ++ite){
+				result += weights_[*ite];
+			}
+			for(size_t id = 0; id < components_.size(); ++id){
+				for(std::deque<SubRoute>::const_iterator its = components_[id]->doubled_edges.begin(); its != components_[id]->doubled_edges.end(); ++its){
+					result += its->weight;
+				}
+			}
+			return result;
+		}
+		
+		// 駅startから出発してstartに戻る郵便配達の経路を求め、通る順に1本ずつ
+		// sink(出発する駅, 辺, 到着する駅) に渡す（Solver::tourを参照。距離はedge_weightで得る）。
+		// 閉じた辺は通らない。resolveで変更を反映してから呼ぶこと。
+		template <class TourSink>
+		bool tour(VertexId start, TourSink sink, size_t * steps = NULL) const{
+			PostmanTour postman_tour(network_);
+			for(EdgeId e = 0; e < network_.num_edges(); ++e){
+				if(closed_[e]) postman_tour.remove_edge(e);
+			}
+			for(std::vector<EdgeId>::const_iterator ite = bridges_.begin(); ite != bridges_.end(); ++ite){
+				postman_tour.add_doubled_edge(*ite);
+			}
+			for(size_t id = 0; id < components_.size(); ++id){
+				const Component & component = *components_[id];
+				for(std::deque<SubRoute>::const_iterator its = component.doubled_edges.begin(); its != component.doubled_edges.end(); ++its){
+					size_t i = component.terminal_index[local_index_[its->v1]], j = component.terminal_index[local_index_[its->v2]];
+					size_t row = component.covering_row(i, j);
+					if(!component.trees.for_each_tree_edge(component.graph, row, component.local_terminals[row == i ? j : i], [&](VertexId, EdgeId e, VertexId){ postman_tour.add_doubled_edge(component.edges[e]); })) return false;
+				}
+			}
+			return postman_tour.write(start, sink, steps);
+		}
+	};
+} // namespace ChinesePostman
+
+#endif // INCREMENTAL_SOLVER_HPP_
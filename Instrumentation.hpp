@@ -0,0 +1,202 @@
+#ifndef INSTRUMENTATION_HPP_
+#define INSTRUMENTATION_HPP_
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <ostream>
+#include <mutex>
+#include <chrono>
+
+namespace ChinesePostman{
+	// 実行中の計測。段階ごとの時間（ScopedPhaseを参照）と、奇数次の頂点の数などのカウンタを記録し、
+	// 最後にJSONかCSVで書き出す。途中経過や計算結果の詳細を表示する先も持つ。
+	// 計測する側はInstrumentationへのポインタを受け取り、NULLなら何もしない
+	// （計測しない場合の負担は、ポインタがNULLかどうかを調べるだけになる）。
+	// 複数のスレッドから同時に記録してよい。
+	// 段階とカウンタの名前は英小文字と_だけからなるものとし、最初に記録した順に書き出す。
+	class Instrumentation{
+	private:
+		struct Phase{
+			std::string name;
+			size_t calls;
+			double seconds; // 複数のスレッドで同時に計測した場合は、その合計
+			
+			Phase(const char * nname) : name(nname), calls(0), seconds(0.0) {}
+		};
+		struct Counter{
+			std::string name;
+			long long value;
+			
+			Counter(const char * nname) : name(nname), value(0) {}
+		};
+		
+		mutable std::mutex mutex_; // 以下の変数を保護する
+		std::vector<Phase> phases_;
+		std::vector<Counter> counters_;
+		std::ostream * progress_; // 段階の開始・終了を表示する先（NULLなら表示しない）
+		std::ostream * dump_; // 途中の計算結果の詳細を表示する先（NULLなら表示しない）
+		std::chrono::steady_clock::time_point start_;
+		
+		// 以下の2つは、mutex_をロックしてから呼ぶ
+		Phase & phase(const char * name){
+			for(std::vector<Phase>::iterator itp = phases_.begin(); itp != phases_.end(); ++itp){
+				if(itp->name == name) return *itp;
+			}
+			phases_.push_back(Phase(name));
+			return phases_.back();
+		}
+		Counter & counter(const char * name){
+			for(std::vector<Counter>::iterator itc = counters_.begin(); itc != counters_.end(); ++itc){
+				if(itc->name == name) return *itc;
+			}
+			counters_.push_back(Counter(name));
+			return counters_.back();
+		}
+	
+	public:
+		Instrumentation() : progress_(NULL), dump_(NULL), start_(std::chrono::steady_clock::now()) {}
+		
+		inline void set_progress_stream(std::ostream * os){ progress_ = os; }
+		inline void set_dump_stream(std::ostream * os){ dump_ = os; }
+		inline bool showing_progress() const{ return progress_ != NULL; }
+		inline bool dumping() const{ return dump_ != NULL; }
+		
+		// 計測を始めてからの秒数
+		double elapsed_seconds() const{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+		}
+		
+		void add_time(const char * name, double seconds){
+			std::lock_guard<std::mutex> lock(mutex_);
+			Phase & p = phase(name);
+			++(p.calls);
+			p.seconds += seconds;
+		}
+		
+		void add(const char * name, long long value = 1){
+			std::lock_guard<std::mutex> lock(mutex_);
+			counter(name).value += value;
+		}
+		
+		long long value(const char * name) const{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for(std::vector<Counter>::const_iterator itc = counters_.begin(); itc != counters_.end(); ++itc){
+				if(itc->name == name) return itc->value;
+			}
+			return 0;
+		}
+		
+		// 途中経過を1行表示する（先頭に経過時間を付ける）
+		void progress(const std::string & message){
+			if(progress_ == NULL) return;
+			std::ostringstream line;
+			line.setf(std::ios::fixed);
+			line.precision(3);
+			line << "[" << elapsed_seconds() << "s] " << message << "\n";
+			std::lock_guard<std::mutex> lock(mutex_);
+			*progress_ << line.str();
+			progress_->flush();
+		}
+		
+		// 途中の計算結果の詳細を表示する。ほかのスレッドの表示と混ざらないよう、まとめて渡すこと
+		void dump(const std::string & text){
+			if(dump_ == NULL) return;
+			std::lock_guard<std::mutex> lock(mutex_);
+			*dump_ << text;
+			dump_->flush();
+		}
+		
+		void write_json(std::ostream & os) const{
+			std::lock_guard<std::mutex> lock(mutex_);
+			os << "{\n";
+			os << "  \"elapsed_seconds\": " << elapsed_seconds() << ",\n";
+			os << "  \"phases\": [";
+			for(size_t i = 0; i < phases_.size(); ++i){
+				os << (i == 0 ? "\n" : ",\n");
+				os << "    {\"name\": \"" << phases_[i].name << "\", \"calls\": " << phases_[i].calls << ", \"seconds\": " << phases_[i].seconds << "}";
+			}
+			os << (phases_.empty() ? "],\n" : "\n  ],\n");
+			os << "  \"counters\": {";
+			for(size_t i = 0; i < counters_.size(); ++i){
+				os << (i == 0 ? "\n" : ",\n");
+				os << "    \"" << counters_[i].name << "\": " << counters_[i].value;
+			}
+			os << (counters_.empty() ? "}\n" : "\n  }\n");
+			os << "}\n";
+		}
+		
+		// 1行目を見出しとし、1行に1つの段階かカウンタを書き出す
+		void write_csv(std::ostream & os) const{
+			std::lock_guard<std::mutex> lock(mutex_);
+			os << "kind,name,calls,value\n";
+			os << "total,elapsed_seconds,1," << elapsed_seconds() << "\n";
+			for(std::vector<Phase>::const_iterator itp = phases_.begin(); itp != phases_.end(); ++itp){
+				os << "phase," << itp->name << "," << itp->calls << "," << itp->seconds << "\n";
+			}
+			for(std::vector<Counter>::const_iterator itc = counters_.begin(); itc != counters_.end(); ++itc){
+				os << "counter," << itc->name << ",," << itc->value << "\n";
+			}
+		}
+		
+		// ファイルに書き出す。名前が.csvで終わればCSV、そうでなければJSONとする。
+		// 書き出せなかった場合はfalseを返す。
+		bool write(const char * fname) const{
+			std::ofstream ofs(fname);
+			if(!ofs) return false;
+			std::string name(fname);
+			if(name.size() >= 4 && name.compare(name.size() - 4, 4, ".csv") == 0){
+				write_csv(ofs);
+			}else{
+				write_json(ofs);
+			}
+			return static_cast<bool>(ofs);
+		}
+	};
+	
+	// 生存期間の時間を、段階nameの時間としてinstrumentationに加える（NULLなら何もしない）。
+	// show_progressが真なら、開始と終了を途中経過として表示する
+	// （スレッドごとに何度も呼ばれる細かい段階では偽にする）。
+	class ScopedPhase{
+	private:
+		Instrumentation * instrumentation_;
+		const char * name_;
+		bool show_progress_;
+		std::chrono::steady_clock::time_point start_;
+		
+		ScopedPhase(const ScopedPhase &);
+		ScopedPhase & operator=(const ScopedPhase &);
+	
+	public:
+		ScopedPhase(Instrumentation * instrumentation, const char * name, bool show_progress = true)
+		: instrumentation_(instrumentation), name_(name), show_progress_(show_progress){
+			if(instrumentation_ == NULL) return;
+			if(show_progress_ && instrumentation_->showing_progress()) instrumentation_->progress(std::string("Start ") + name_);
+			start_ = std::chrono::steady_clock::now();
+		}
+		
+		~ScopedPhase(){
+			if(instrumentation_ == NULL) return;
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+			instrumentation_->add_time(name_, seconds);
+			if(show_progress_ && instrumentation_->showing_progress()){
+				std::ostringstream message;
+				message << "End " << name_ << " (" << seconds << "s)";
+				instrumentation_->progress(message.str());
+			}
+		}
+	};
+	
+	// カウンタnameにvalueを加える（instrumentationがNULLなら何もしない）
+	inline void count(Instrumentation * instrumentation, const char * name, long long value = 1){
+		if(instrumentation != NULL) instrumentation->add(name, value);
+	}
+	
+	// 途中の計算結果の詳細を表示するか
+	inline bool dumping(const Instrumentation * instrumentation){
+		return instrumentation != NULL && instrumentation->dumping();
+	}
+} // namespace ChinesePostman
+
+#endif // INSTRUMENTATION_HPP_
@@ -0,0 +1,685 @@
+#ifndef PERFECT_MATCHING_HPP_
+#define PERFECT_MATCHING_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace ChinesePostman{
+	// 一般グラフ上の最小費用完全マッチングを求めるクラス。
+	// Edmondsのblossomアルゴリズム（主双対法、O(n^3)）による。
+	// 参考: J. van Rantwijk, "Maximum Weighted Matching" (mwmatching.py)
+	// http://jorisvr.nl/article/maximum-matching
+	//
+	// 内部では「辺の重み = 定数 - 距離」とした上で、最大基数のマッチングのうち
+	// 重み最大のものを求めている。最大基数であれば完全マッチングは
+	// すべて同じ本数の辺からなるので、これは距離最小の完全マッチングに一致する。
+	class MinimumPerfectMatching{
+	public:
+		typedef long long WeightType;
+	
+	private:
+		struct MatchingEdge{
+			int v1, v2;
+			WeightType weight;
+			MatchingEdge(int vv1, int vv2, WeightType wweight) : v1(vv1), v2(vv2), weight(wweight) {}
+		};
+		
+		int nvertex_;
+		std::vector<MatchingEdge> edges_;
+		WeightType weight_offset_;
+		
+		// 以下はsolve()の作業領域。
+		// 「端点番号」pは、辺kについて 2k（辺のv1側）、2k+1（辺のv2側）を表す。
+		std::vector< std::vector<int> > neighbend_;
+		std::vector<int> mate_; // 相手側の端点番号（マッチしていなければ-1）
+		std::vector<int> label_; // 0: 未ラベル, 1: S, 2: T（5はscan_blossom中の一時的な印）
+		std::vector<int> labelend_;
+		std::vector<int> inblossom_;
+		std::vector<int> blossomparent_;
+		std::vector< std::vector<int> > blossomchilds_;
+		std::vector<int> blossombase_;
+		std::vector< std::vector<int> > blossomendps_;
+		std::vector<int> bestedge_;
+		std::vector< std::vector<int> > blossombestedges_;
+		std::vector<bool> has_blossombestedges_;
+		std::vector<int> unusedblossoms_;
+		std::vector<WeightType> dualvar_;
+		std::vector<bool> allowedge_;
+		std::vector<int> queue_;
+		
+		inline int endpoint(int p) const{ return (p & 1) ? edges_[p/2].v2 : edges_[p/2].v1; }
+		
+		inline WeightType slack(int k) const{
+			return dualvar_[edges_[k].v1] + dualvar_[edges_[k].v2] - 2 * edges_[k].weight;
+		}
+		
+		// Pythonの負の添字と同じく、末尾から数えた位置も受け付ける
+		static inline int cyclic_at(const std::vector<int> & vec, int pos){
+			int n = static_cast<int>(vec.size());
+			return vec[((pos % n) + n) % n];
+		}
+		
+		// blossom（または頂点）bに含まれる頂点を列挙する
+		void blossom_leaves(int b, std::vector<int> & result) const{
+			result.clear();
+			std::vector<int> stack(1, b);
+			while(!stack.empty()){
+				int t = stack.back();
+				stack.pop_back();
+				if(t < nvertex_){
+					result.push_back(t);
+				}else{
+					for(std::vector<int>::const_reverse_iterator it = blossomchilds_[t].rbegin(); it != blossomchilds_[t].rend(); ++it){
+						stack.push_back(*it);
+					}
+				}
+			}
+		}
+		
+		void assign_label(int w, int t, int p){
+			for(;;){
+				int b = inblossom_[w];
+				label_[w] = label_[b] = t;
+				labelend_[w] = labelend_[b] = p;
+				bestedge_[w] = bestedge_[b] = -1;
+				if(t == 1){
+					std::vector<int> leaves;
+					blossom_leaves(b, leaves);
+					queue_.insert(queue_.end(), leaves.begin(), leaves.end());
+					return;
+				}
+				// Tラベルの場合は、底の相手にSラベルを付ける
+				int base = blossombase_[b];
+				w = endpoint(mate_[base]);
+				t = 1;
+				p = mate_[base] ^ 1;
+			}
+		}
+		
+		// S頂点v, wを結ぶ辺について、新しいblossomの底か、
+		// 増加路が見つかったこと（-1）を返す
+		int scan_blossom(int v, int w){
+			std::vector<int> path;
+			int base = -1;
+			while(v != -1 || w != -1){
+				int b = inblossom_[v];
+				if(label_[b] & 4){
+					base = blossombase_[b];
+					break;
+				}
+				path.push_back(b);
+				label_[b] = 5;
+				if(labelend_[b] == -1){
+					v = -1;
+				}else{
+					v = endpoint(labelend_[b]);
+					b = inblossom_[v];
+					v = endpoint(labelend_[b]);
+				}
+				if(w != -1) std::swap(v, w);
+			}
+			for(std::vector<int>::iterator it = path.begin(); it != path.end(); ++it){
+				label_[*it] = 1;
+			}
+			return base;
+		}
+		
+		void add_blossom(int base, int k){
+			int v = edges_[k].v1;
+			int w = edges_[k].v2;
+			int bb = inblossom_[base];
+			int bv = inblossom_[v];
+			int bw = inblossom_[w];
+			int b = unusedblossoms_.back();
+			unusedblossoms_.pop_back();
+			blossombase_[b] = base;
+			blossomparent_[b] = -1;
+			blossomparent_[bb] = b;
+			std::vector<int> & path = blossomchilds_[b];
+			std::vector<int> & endps = blossomendps_[b];
+			path.clear();
+			endps.clear();
+			while(bv != bb){
+				blossomparent_[bv] = b;
+				path.push_back(bv);
+				endps.push_back(labelend_[bv]);
+				v = endpoint(labelend_[bv]);
+				bv = inblossom_[v];
+			}
+			path.push_back(bb);
+			std::reverse(path.begin(), path.end());
+			std::reverse(endps.begin(), endps.end());
+			endps.push_back(2 * k);
+			while(bw != bb){
+				blossomparent_[bw] = b;
+				path.push_back(bw);
+				endps.push_back(labelend_[bw] ^ 1);
+				w = endpoint(labelend_[bw]);
+				bw = inblossom_[w];
+			}
+			label_[b] = 1;
+			labelend_[b] = labelend_[bb];
+			dualvar_[b] = 0;
+			
+			std::vector<int> leaves;
+			blossom_leaves(b, leaves);
+			for(std::vector<int>::iterator it = leaves.begin(); it != leaves.end(); ++it){
+				if(label_[inblossom_[*it]] == 2) queue_.push_back(*it);
+				inblossom_[*it] = b;
+			}
+			
+			// 新しいblossomから外のS-blossomへの辺のうち、スラックが最小のものを求める
+			std::vector<int> bestedgeto(2 * nvertex_, -1);
+			for(std::vector<int>::iterator itb = path.begin(); itb != path.end(); ++itb){
+				std::vector<int> nblist;
+				if(!has_blossombestedges_[*itb]){
+					std::vector<int> sub_leaves;
+					blossom_leaves(*itb, sub_leaves);
+					for(std::vector<int>::iterator itv = sub_leaves.begin(); itv != sub_leaves.end(); ++itv){
+						for(std::vector<int>::iterator itp = neighbend_[*itv].begin(); itp != neighbend_[*itv].end(); ++itp){
+							nblist.push_back(*itp / 2);
+						}
+					}
+				}else{
+					nblist = blossombestedges_[*itb];
+				}
+				for(std::vector<int>::iterator itk = nblist.begin(); itk != nblist.end(); ++itk){
+					int i = edges_[*itk].v1;
+					int j = edges_[*itk].v2;
+					if(inblossom_[j] == b) std::swap(i, j);
+					int bj = inblossom_[j];
+					if(bj != b && label_[bj] == 1 && (bestedgeto[bj] == -1 || slack(*itk) < slack(bestedgeto[bj]))){
+						bestedgeto[bj] = *itk;
+					}
+				}
+				blossombestedges_[*itb].clear();
+				has_blossombestedges_[*itb] = false;
+				bestedge_[*itb] = -1;
+			}
+			blossombestedges_[b].clear();
+			for(std::vector<int>::iterator itk = bestedgeto.begin(); itk != bestedgeto.end(); ++itk){
+				if(*itk != -1) blossombestedges_[b].push_back(*itk);
+			}
+			has_blossombestedges_[b] = true;
+			bestedge_[b] = -1;
+			for(std::vector<int>::iterator itk = blossombestedges_[b].begin(); itk != blossombestedges_[b].end(); ++itk){
+				if(bestedge_[b] == -1 || slack(*itk) < slack(bestedge_[b])) bestedge_[b] = *itk;
+			}
+		}
+		
+		void expand_blossom(int b, bool endstage){
+			std::vector<int> leaves;
+			for(std::vector<int>::iterator its = blossomchilds_[b].begin(); its != blossomchilds_[b].end(); ++its){
+				int s = *its;
+				blossomparent_[s] = -1;
+				if(s < nvertex_){
+					inblossom_[s] = s;
+				}else if(endstage && dualvar_[s] == 0){
+					expand_blossom(s, endstage);
+				}else{
+					blossom_leaves(s, leaves);
+					for(std::vector<int>::iterator itv = leaves.begin(); itv != leaves.end(); ++itv){
+						inblossom_[*itv] = s;
+					}
+				}
+			}
+			
+			if(!endstage && label_[b] == 2){
+				// Tラベルのblossomを展開する場合、子blossomのラベルを付け直す
+				const std::vector<int> & childs = blossomchilds_[b];
+				const std::vector<int> & endps = blossomendps_[b];
+				int entrychild = inblossom_[endpoint(labelend_[b] ^ 1)];
+				int j = static_cast<int>(std::find(childs.begin(), childs.end(), entrychild) - childs.begin());
+				int jstep, endptrick;
+				if(j & 1){
+					j -= static_cast<int>(childs.size());
+					jstep = 1;
+					endptrick = 0;
+				}else{
+					jstep = -1;
+					endptrick = 1;
+				}
+				int p = labelend_[b];
+				while(j != 0){
+					label_[endpoint(p ^ 1)] = 0;
+					label_[endpoint(cyclic_at(endps, j - endptrick) ^ endptrick ^ 1)] = 0;
+					assign_label(endpoint(p ^ 1), 2, p);
+					allowedge_[cyclic_at(endps, j - endptrick) / 2] = true;
+					j += jstep;
+					p = cyclic_at(endps, j - endptrick) ^ endptrick;
+					allowedge_[p / 2] = true;
+					j += jstep;
+				}
+				int bv = cyclic_at(childs, j);
+				label_[endpoint(p ^ 1)] = label_[bv] = 2;
+				labelend_[endpoint(p ^ 1)] = labelend_[bv] = p;
+				bestedge_[bv] = -1;
+				j += jstep;
+				while(cyclic_at(childs, j) != entrychild){
+					bv = cyclic_at(childs, j);
+					if(label_[bv] == 1){
+						j += jstep;
+						continue;
+					}
+					blossom_leaves(bv, leaves);
+					int v = -1;
+					for(std::vector<int>::iterator itv = leaves.begin(); itv != leaves.end(); ++itv){
+						v = *itv;
+						if(label_[v] != 0) break;
+					}
+					if(label_[v] != 0){
+						label_[v] = 0;
+						label_[endpoint(mate_[blossombase_[bv]])] = 0;
+						assign_label(v, 2, labelend_[v]);
+					}
+					j += jstep;
+				}
+			}
+			
+			label_[b] = labelend_[b] = -1;
+			blossomchilds_[b].clear();
+			blossomendps_[b].clear();
+			blossombase_[b] = -1;
+			blossombestedges_[b].clear();
+			has_blossombestedges_[b] = false;
+			bestedge_[b] = -1;
+			unusedblossoms_.push_back(b);
+		}
+		
+		// blossom b内で、頂点vが底となるようにマッチングを入れ替える
+		void augment_blossom(int b, int v){
+			int t = v;
+			while(blossomparent_[t] != b) t = blossomparent_[t];
+			if(t >= nvertex_) augment_blossom(t, v);
+			
+			std::vector<int> & childs = blossomchilds_[b];
+			std::vector<int> & endps = blossomendps_[b];
+			int i = static_cast<int>(std::find(childs.begin(), childs.end(), t) - childs.begin());
+			int j = i;
+			int jstep, endptrick;
+			if(i & 1){
+				j -= static_cast<int>(childs.size());
+				jstep = 1;
+				endptrick = 0;
+			}else{
+				jstep = -1;
+				endptrick = 1;
+			}
+			while(j != 0){
+				j += jstep;
+				t = cyclic_at(childs, j);
+				int p = cyclic_at(endps, j - endptrick) ^ endptrick;
+				if(t >= nvertex_) augment_blossom(t, endpoint(p));
+				j += jstep;
+				t = cyclic_at(childs, j);
+				if(t >= nvertex_) augment_blossom(t, endpoint(p ^ 1));
+				mate_[endpoint(p)] = p ^ 1;
+				mate_[endpoint(p ^ 1)] = p;
+			}
+			std::rotate(childs.begin(), childs.begin() + i, childs.end());
+			std::rotate(endps.begin(), endps.begin() + i, endps.end());
+			blossombase_[b] = blossombase_[childs[0]];
+		}
+		
+		void augment_matching(int k){
+			int s_list[2] = { edges_[k].v1, edges_[k].v2 };
+			int p_list[2] = { 2*k + 1, 2*k };
+			for(int side = 0; side < 2; ++side){
+				int s = s_list[side];
+				int p = p_list[side];
+				for(;;){
+					int bs = inblossom_[s];
+					if(bs >= nvertex_) augment_blossom(bs, s);
+					mate_[s] = p;
+					if(labelend_[bs] == -1) break;
+					int t = endpoint(labelend_[bs]);
+					int bt = inblossom_[t];
+					s = endpoint(labelend_[bt]);
+					int j = endpoint(labelend_[bt] ^ 1);
+					if(bt >= nvertex_) augment_blossom(bt, j);
+					mate_[j] = labelend_[bt];
+					p = labelend_[bt] ^ 1;
+				}
+			}
+		}
+	
+	public:
+		MinimumPerfectMatching(size_t num_vertices) : nvertex_(static_cast<int>(num_vertices)), weight_offset_(0) {}
+		
+		inline size_t num_vertices() const{ return static_cast<size_t>(nvertex_); }
+		inline size_t num_edges() const{ return edges_.size(); }
+		
+		// 頂点v1, v2を距離distanceで結ぶ辺を、マッチングの候補として追加する。
+		inline void add_edge(size_t v1, size_t v2, WeightType distance){
+			edges_.push_back(MatchingEdge(static_cast<int>(v1), static_cast<int>(v2), distance));
+		}
+		
+		// マッチングを求める。
+		// 候補の辺だけでは完全マッチングが作れない場合はfalseを返す
+		// （そのときも、できるだけ多くの頂点をマッチさせた結果が得られる）。
+		bool solve(){
+			const int n = nvertex_;
+			const int nedge = static_cast<int>(edges_.size());
+			
+			// 距離を「最大の距離 + 1 - 距離」に置き換えて、最大重みマッチングに帰着する
+			WeightType max_distance = 0;
+			for(std::vector<MatchingEdge>::iterator ite = edges_.begin(); ite != edges_.end(); ++ite){
+				max_distance = std::max(max_distance, ite->weight);
+			}
+			weight_offset_ = max_distance + 1;
+			for(std::vector<MatchingEdge>::iterator ite = edges_.begin(); ite != edges_.end(); ++ite){
+				ite->weight = weight_offset_ - ite->weight;
+			}
+			WeightType maxweight = 0;
+			for(std::vector<MatchingEdge>::iterator ite = edges_.begin(); ite != edges_.end(); ++ite){
+				maxweight = std::max(maxweight, ite->weight);
+			}
+			
+			neighbend_.assign(n, std::vector<int>());
+			for(int k = 0; k < nedge; ++k){
+				neighbend_[edges_[k].v1].push_back(2*k + 1);
+				neighbend_[edges_[k].v2].push_back(2*k);
+			}
+			mate_.assign(n, -1);
+			label_.assign(2*n, 0);
+			labelend_.assign(2*n, -1);
+			inblossom_.resize(n);
+			for(int v = 0; v < n; ++v) inblossom_[v] = v;
+			blossomparent_.assign(2*n, -1);
+			blossomchilds_.assign(2*n, std::vector<int>());
+			blossombase_.assign(2*n, -1);
+			for(int v = 0; v < n; ++v) blossombase_[v] = v;
+			blossomendps_.assign(2*n, std::vector<int>());
+			bestedge_.assign(2*n, -1);
+			blossombestedges_.assign(2*n, std::vector<int>());
+			has_blossombestedges_.assign(2*n, false);
+			unusedblossoms_.clear();
+			for(int b = n; b < 2*n; ++b) unusedblossoms_.push_back(b);
+			dualvar_.assign(2*n, 0);
+			for(int v = 0; v < n; ++v) dualvar_[v] = maxweight;
+			allowedge_.assign(nedge, false);
+			queue_.clear();
+			
+			// 1段階ごとに増加路を1本見つけ、マッチングを1本増やす
+			for(int stage = 0; stage < n; ++stage){
+				std::fill(label_.begin(), label_.end(), 0);
+				std::fill(bestedge_.begin(), bestedge_.end(), -1);
+				for(int b = n; b < 2*n; ++b){
+					blossombestedges_[b].clear();
+					has_blossombestedges_[b] = false;
+				}
+				std::fill(allowedge_.begin(), allowedge_.end(), false);
+				queue_.clear();
+				
+				for(int v = 0; v < n; ++v){
+					if(mate_[v] == -1 && label_[inblossom_[v]] == 0) assign_label(v, 1, -1);
+				}
+				
+				bool augmented = false;
+				for(;;){
+					while(!queue_.empty() && !augmented){
+						int v = queue_.back();
+						queue_.pop_back();
+						
+						for(std::vector<int>::iterator itp = neighbend_[v].begin(); itp != neighbend_[v].end(); ++itp){
+							int p = *itp;
+							int k = p / 2;
+							int w = endpoint(p);
+							if(inblossom_[v] == inblossom_[w]) continue;
+							WeightType kslack = 0;
+							if(!allowedge_[k]){
+								kslack = slack(k);
+								if(kslack <= 0) allowedge_[k] = true;
+							}
+							if(allowedge_[k]){
+								if(label_[inblossom_[w]] == 0){
+									assign_label(w, 2, p ^ 1);
+								}else if(label_[inblossom_[w]] == 1){
+									int base = scan_blossom(v, w);
+									if(base >= 0){
+										add_blossom(base, k);
+									}else{
+										augment_matching(k);
+										augmented = true;
+										break;
+									}
+								}else if(label_[w] == 0){
+									label_[w] = 2;
+									labelend_[w] = p ^ 1;
+								}
+							}else if(label_[inblossom_[w]] == 1){
+								int b = inblossom_[v];
+								if(bestedge_[b] == -1 || kslack < slack(bestedge_[b])) bestedge_[b] = k;
+							}else if(label_[w] == 0){
+								if(bestedge_[w] == -1 || kslack < slack(bestedge_[w])) bestedge_[w] = k;
+							}
+						}
+					}
+					if(augmented) break;
+					
+					// 双対変数の更新量を求める（最大基数を優先するので、型1の更新は最後の手段）
+					int deltatype = -1;
+					WeightType delta = 0;
+					int deltaedge = -1, deltablossom = -1;
+					
+					for(int v = 0; v < n; ++v){
+						if(label_[inblossom_[v]] == 0 && bestedge_[v] != -1){
+							WeightType d = slack(bestedge_[v]);
+							if(deltatype == -1 || d < delta){
+								delta = d;
+								deltatype = 2;
+								deltaedge = bestedge_[v];
+							}
+						}
+					}
+					for(int b = 0; b < 2*n; ++b){
+						if(blossomparent_[b] == -1 && label_[b] == 1 && bestedge_[b] != -1){
+							WeightType d = slack(bestedge_[b]) / 2;
+							if(deltatype == -1 || d < delta){
+								delta = d;
+								deltatype = 3;
+								deltaedge = bestedge_[b];
+							}
+						}
+					}
+					for(int b = n; b < 2*n; ++b){
+						if(blossombase_[b] >= 0 && blossomparent_[b] == -1 && label_[b] == 2 && (deltatype == -1 || dualvar_[b] < delta)){
+							delta = dualvar_[b];
+							deltatype = 4;
+							deltablossom = b;
+						}
+					}
+					if(deltatype == -1){
+						// これ以上マッチングを増やせない
+						deltatype = 1;
+						delta = std::max<WeightType>(0, *std::min_element(dualvar_.begin(), dualvar_.begin() + n));
+					}
+					
+					for(int v = 0; v < n; ++v){
+						if(label_[inblossom_[v]] == 1){
+							dualvar_[v] -= delta;
+						}else if(label_[inblossom_[v]] == 2){
+							dualvar_[v] += delta;
+						}
+					}
+					for(int b = n; b < 2*n; ++b){
+						if(blossombase_[b] >= 0 && blossomparent_[b] == -1){
+							if(label_[b] == 1){
+								dualvar_[b] += delta;
+							}else if(label_[b] == 2){
+								dualvar_[b] -= delta;
+							}
+						}
+					}
+					
+					if(deltatype == 1){
+						break;
+					}else if(deltatype == 2){
+						allowedge_[deltaedge] = true;
+						int i = edges_[deltaedge].v1;
+						if(label_[inblossom_[i]] == 0) i = edges_[deltaedge].v2;
+						queue_.push_back(i);
+					}else if(deltatype == 3){
+						allowedge_[deltaedge] = true;
+						queue_.push_back(edges_[deltaedge].v1);
+					}else if(deltatype == 4){
+						expand_blossom(deltablossom, false);
+					}
+				}
+				
+				if(!augmented) break;
+				
+				// 双対変数が0になったS-blossomを展開しておく
+				for(int b = n; b < 2*n; ++b){
+					if(blossomparent_[b] == -1 && blossombase_[b] >= 0 && label_[b] == 1 && dualvar_[b] == 0){
+						expand_blossom(b, true);
+					}
+				}
+			}
+			
+			// 距離を元に戻しておく
+			for(std::vector<MatchingEdge>::iterator ite = edges_.begin(); ite != edges_.end(); ++ite){
+				ite->weight = weight_offset_ - ite->weight;
+			}
+			
+			for(int v = 0; v < n; ++v){
+				if(mate_[v] == -1) return false;
+			}
+			return true;
+		}
+		
+		// 頂点vの相手を返す。相手がいなければnum_vertices()を返す。
+		inline size_t mate(size_t v) const{
+			return mate_[v] == -1 ? num_vertices() : static_cast<size_t>(endpoint(mate_[v]));
+		}
+		
+		// solve()の後で、候補に含めなかった頂点の組(v1, v2)について
+		// 求めた双対変数が実行可能性（スラックが非負）を満たすかを返す。
+		// すべての組について満たされていれば、候補を制限せずに解いた場合と
+		// 同じく最適な完全マッチングが得られている（双対による最適性の証明）。
+		bool dual_feasible(size_t v1, size_t v2, WeightType distance) const{
+			WeightType s = dualvar_[v1] + dualvar_[v2] - 2 * (weight_offset_ - distance);
+			if(s >= 0) return true;
+			
+			// 同じblossomに含まれる場合は、その双対変数の分を加える
+			int b1 = static_cast<int>(v1), b2 = static_cast<int>(v2);
+			std::vector<int> chain1, chain2;
+			for(; b1 != -1; b1 = blossomparent_[b1]) chain1.push_back(b1);
+			for(; b2 != -1; b2 = blossomparent_[b2]) chain2.push_back(b2);
+			std::vector<int>::reverse_iterator it1 = chain1.rbegin(), it2 = chain2.rbegin();
+			for(; it1 != chain1.rend() && it2 != chain2.rend() && *it1 == *it2; ++it1, ++it2){
+				s += 2 * dualvar_[*it1];
+			}
+			return s >= 0;
+		}
+	};
+	
+	// solve_complete_matchingで解いた問題の大きさ
+	struct CompleteMatchingStatistics{
+		size_t rounds; // 解いた回数（候補を加えて解き直した回数を含む）
+		size_t columns; // 各回で与えた候補の組（辺）の数の合計
+		
+		CompleteMatchingStatistics() : rounds(0), columns(0) {}
+	};
+	
+	// 全ての頂点の組の間に辺がある（完全グラフの）最小費用完全マッチングを求める。
+	// distance(i, j)は頂点i, jの間の距離を返す関数オブジェクト。
+	// 結果はmate[i]（頂点iの相手）に格納される。
+	// 
+	// candidate_neighborsが正の場合、各頂点から近い順にその個数の頂点への辺
+	// だけを候補として解き、双対変数で最適性を確認する。確認できなければ
+	// 条件を満たさない組を候補に加えて解き直すため、結果は常に最適である。
+	// 完全グラフの O(n^2) 本ではなく O(nk) 本の辺で解けることが多い。
+	// initial_candidatesが与えられた場合、その組も最初から候補に加える
+	// （似た問題を解いたときのマッチングを与えると、解き直しが少なくなる）。
+	// statisticsが与えられた場合、解いた回数と候補の組の数を加える。
+	// 頂点が奇数個の場合など、全ての組を候補にしても完全マッチングが作れない場合はfalseを返す。
+	template <class DistanceFunction>
+	bool solve_complete_matching(size_t num_vertices, DistanceFunction distance, size_t candidate_neighbors, std::vector<size_t> & mate, const std::vector< std::pair<size_t, size_t> > * initial_candidates = NULL, CompleteMatchingStatistics * statistics = NULL){
+		typedef MinimumPerfectMatching::WeightType WeightType;
+		size_t i, j;
+		mate.assign(num_vertices, num_vertices);
+		if(num_vertices == 0) return true;
+		if(num_vertices % 2 == 1) return false;
+		
+		// 候補となる頂点の組（i < j）
+		std::vector< std::vector<size_t> > candidates(num_vertices);
+		if(candidate_neighbors == 0 || candidate_neighbors + 1 >= num_vertices){
+			for(i = 0; i < num_vertices; ++i){
+				for(j = i + 1; j < num_vertices; ++j) candidates[i].push_back(j);
+			}
+		}else{
+			std::vector< std::pair<WeightType, size_t> > row;
+			for(i = 0; i < num_vertices; ++i){
+				row.clear();
+				for(j = 0; j < num_vertices; ++j){
+					if(j != i) row.push_back(std::make_pair(static_cast<WeightType>(distance(i, j)), j));
+				}
+				std::partial_sort(row.begin(), row.begin() + candidate_neighbors, row.end());
+				for(size_t n = 0; n < candidate_neighbors; ++n){
+					j = row[n].second;
+					candidates[std::min(i, j)].push_back(std::max(i, j));
+				}
+			}
+		}
+		
+		if(initial_candidates != NULL){
+			for(std::vector< std::pair<size_t, size_t> >::const_iterator itp = initial_candidates->begin(); itp != initial_candidates->end(); ++itp){
+				if(itp->first != itp->second) candidates[std::min(itp->first, itp->second)].push_back(std::max(itp->first, itp->second));
+			}
+		}
+		
+		for(;;){
+			MinimumPerfectMatching matching(num_vertices);
+			size_t num_candidates = 0;
+			for(i = 0; i < num_vertices; ++i){
+				std::sort(candidates[i].begin(), candidates[i].end());
+				candidates[i].erase(std::unique(candidates[i].begin(), candidates[i].end()), candidates[i].end());
+				for(std::vector<size_t>::iterator itj = candidates[i].begin(); itj != candidates[i].end(); ++itj){
+					matching.add_edge(i, *itj, distance(i, *itj));
+				}
+				num_candidates += candidates[i].size();
+			}
+			if(statistics != NULL){
+				statistics->columns += num_candidates;
+				++(statistics->rounds);
+			}
+			
+			if(!matching.solve()){
+				// 既に全ての組が候補なら、これ以上加えるものはない
+				if(num_candidates == num_vertices * (num_vertices - 1) / 2) return false;
+				
+				// 候補の辺だけでは完全マッチングが作れない場合、
+				// 相手のいない頂点からは全ての頂点への辺を候補に加える
+				for(i = 0; i < num_vertices; ++i){
+					if(matching.mate(i) != num_vertices) continue;
+					for(j = 0; j < num_vertices; ++j){
+						if(j != i) candidates[std::min(i, j)].push_back(std::max(i, j));
+					}
+				}
+				continue;
+			}
+			
+			// 候補外の組について双対変数の実行可能性を確認する
+			std::vector< std::pair<size_t, size_t> > violated;
+			for(i = 0; i < num_vertices; ++i){
+				std::vector<size_t>::const_iterator itc = candidates[i].begin();
+				for(j = i + 1; j < num_vertices; ++j){
+					while(itc != candidates[i].end() && *itc < j) ++itc;
+					if(itc != candidates[i].end() && *itc == j) continue;
+					if(!matching.dual_feasible(i, j, distance(i, j))) violated.push_back(std::make_pair(i, j));
+				}
+			}
+			for(std::vector< std::pair<size_t, size_t> >::iterator itp = violated.begin(); itp != violated.end(); ++itp){
+				candidates[itp->first].push_back(itp->second);
+			}
+			if(violated.empty()){
+				for(i = 0; i < num_vertices; ++i) mate[i] = matching.mate(i);
+				return true;
+			}
+		}
+	}
+} // namespace ChinesePostman
+
+#endif // PERFECT_MATCHING_HPP_
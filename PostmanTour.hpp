@@ -0,0 +1,126 @@
+#ifndef POSTMAN_TOUR_HPP_
+#define POSTMAN_TOUR_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include "CompactGraph.hpp"
+#include "ShortestPaths.hpp"
+#include <vector>
+
+namespace ChinesePostman{
+	// 辺eをmultiplicity[e]回ずつ通り、頂点startから出発してstartに戻る閉路（オイラー閉路）を
+	// Hierholzerの方法で求め、通る順に1本ずつ sink(出発する頂点, 辺, 到着する頂点) を呼ぶ。
+	// 再帰の代わりに明示的なスタックを用いる。計算量は（通る回数を含めた）辺の数に対して線形。
+	// 
+	// スタックから頂点を取り出した順に閉路が得られる（無向グラフなので、逆向きに辿っても同じ閉路）。
+	// startを含む連結成分の辺だけを通る。返り値は通った辺の数（通る回数を含む）。
+	// 各頂点の次数（通る回数を含む）が偶数であることは呼び出す側で確かめておくこと。
+	template <class TourSink>
+	size_t euler_circuit(const CompactGraph & graph, const std::vector<unsigned int> & multiplicity, VertexId start, TourSink sink){
+		const EdgeId no_edge = static_cast<EdgeId>(-1);
+		std::vector<unsigned int> remaining(multiplicity);
+		std::vector<size_t> next(graph.num_vertices()); // 次に調べる隣接リストの位置
+		for(VertexId v = 0; v < graph.num_vertices(); ++v){
+			next[v] = graph.adjacency_begin(v);
+		}
+		
+		// 頂点と、その頂点に入ってきた辺
+		std::vector< std::pair<VertexId, EdgeId> > stack;
+		stack.push_back(std::make_pair(start, no_edge));
+		size_t steps = 0;
+		
+		while(!stack.empty()){
+			VertexId v = stack.back().first;
+			while(next[v] < graph.adjacency_end(v) && remaining[graph.adjacent_edge(next[v])] == 0) ++next[v];
+			
+			if(next[v] < graph.adjacency_end(v)){
+				// まだ通っていない辺を進む
+				EdgeId e = graph.adjacent_edge(next[v]);
+				--remaining[e];
+				stack.push_back(std::make_pair(graph.adjacent_vertex(next[v]), e));
+			}else{
+				// vから進める辺がなくなったので、閉路に加える
+				EdgeId e = stack.back().second;
+				stack.pop_back();
+				if(e == no_edge) continue;
+				sink(v, e, stack.back().first);
+				++steps;
+			}
+		}
+		return steps;
+	}
+	
+	// 郵便配達の経路を作る。
+	// 元の路線網のすべての辺を1回ずつ通り、さらに2回通る区間（橋や、最小マッチングで
+	// 組になった2頂点の間）の最短経路の辺をもう1回ずつ通る閉路を求める。
+	class PostmanTour{
+	private:
+		const CompactGraph & graph_;
+		std::vector<unsigned int> multiplicity_; // 辺ごとの通る回数
+	
+	public:
+		explicit PostmanTour(const CompactGraph & graph)
+		: graph_(graph), multiplicity_(graph.num_edges(), 1) {}
+		
+		// 頂点v1とv2の間（SubRouteの両端など）の最短経路の辺を、もう1回ずつ通るようにする。
+		// 到達できない場合はfalseを返す。
+		bool add_doubled_route(VertexId v1, VertexId v2){
+			std::vector<EdgeId> path;
+			if(!shortest_path_edges(graph_, v1, v2, path)) return false;
+			for(std::vector<EdgeId>::iterator ite = path.begin(); ite != path.end(); ++ite){
+				++multiplicity_[*ite];
+			}
+			return true;
+		}
+		
+		// 辺eをもう1回通るようにする（経路が既に分かっている場合に用いる）。
+		inline void add_doubled_edge(EdgeId e){
+			++multiplicity_[e];
+		}
+		
+		// 辺eを通らないようにする（閉じた区間など）。
+		inline void remove_edge(EdgeId e){
+			multiplicity_[e] = 0;
+		}
+		
+		// 2回通る区間を順に加える。SubRouteの頂点の番号は、graphの頂点の番号と同じであること。
+		template <class SubRouteContainer>
+		bool add_doubled_routes(const SubRouteContainer & routes){
+			for(typename SubRouteContainer::const_iterator itr = routes.begin(); itr != routes.end(); ++itr){
+				if(!add_doubled_route(itr->v1, itr->v2)) return false;
+			}
+			return true;
+		}
+		
+		inline const std::vector<unsigned int> & multiplicity() const{ return multiplicity_; }
+		
+		// 閉路の距離の合計
+		EdgeWeightType total_distance() const{
+			EdgeWeightType result = 0;
+			for(EdgeId e = 0; e < graph_.num_edges(); ++e){
+				result += graph_.edge_weight(e) * static_cast<EdgeWeightType>(multiplicity_[e]);
+			}
+			return result;
+		}
+		
+		// 頂点startから出発してstartに戻る閉路を、通る順に1本ずつ sink(出発する頂点, 辺, 到着する頂点) に渡す
+		// （euler_circuitを参照）。通る回数が奇数の頂点があって閉路にならない場合は、何もせずfalseを返す。
+		// stepsが与えられた場合、通った辺の数を格納する（startを含まない連結成分の辺は通らない）。
+		template <class TourSink>
+		bool write(VertexId start, TourSink sink, size_t * steps = NULL) const{
+			std::vector<unsigned int> degree(graph_.num_vertices(), 0);
+			for(EdgeId e = 0; e < graph_.num_edges(); ++e){
+				degree[graph_.edge_source(e)] += multiplicity_[e];
+				degree[graph_.edge_target(e)] += multiplicity_[e];
+			}
+			for(VertexId v = 0; v < graph_.num_vertices(); ++v){
+				if(degree[v] % 2 == 1) return false;
+			}
+			
+			size_t count = euler_circuit(graph_, multiplicity_, start, sink);
+			if(steps != NULL) *steps = count;
+			return true;
+		}
+	};
+} // namespace ChinesePostman
+
+#endif // POSTMAN_TOUR_HPP_
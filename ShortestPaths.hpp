@@ -0,0 +1,331 @@
+#ifndef SHORTEST_PATHS_HPP_
+#define SHORTEST_PATHS_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include "CompactGraph.hpp"
+#include <vector>
+#include <map>
+#include <queue>
+#include <limits>
+#include <functional>
+#include <algorithm>
+
+namespace ChinesePostman{
+	// 到達できない頂点への距離
+	inline EdgeWeightType unreachable_distance(){
+		return std::numeric_limits<EdgeWeightType>::max();
+	}
+	
+	// 最短経路木で、親を持たない頂点（始点と、到達できない頂点）の親の辺
+	inline EdgeId no_predecessor(){
+		return static_cast<EdgeId>(-1);
+	}
+	
+	// 頂点sourceからの最短距離をDijkstra法（二分ヒープ）で求め、distanceに格納する。
+	// wantedが与えられた場合、wanted[i]がtrueである頂点（wanted_count個）の距離が
+	// すべて確定した時点で打ち切る（そのほかの頂点の距離は確定していない場合がある）。
+	// predecessorが与えられた場合、各頂点に最短経路で入ってくる辺（最短経路木の親の辺）を格納する。
+	// overlayが与えられた場合、辺の距離と有無はoverlayに従う。
+	void dijkstra_shortest_distances(const CompactGraph & graph, VertexId source, std::vector<EdgeWeightType> & distance, const std::vector<bool> * wanted = NULL, size_t wanted_count = 0, std::vector<EdgeId> * predecessor = NULL, const EdgeOverlay * overlay = NULL){
+		typedef std::pair<EdgeWeightType, VertexId> QueueItem;
+		std::priority_queue< QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > queue;
+		std::vector<bool> settled(graph.num_vertices(), false);
+		
+		if(predecessor != NULL) predecessor->assign(graph.num_vertices(), no_predecessor());
+		distance.assign(graph.num_vertices(), unreachable_distance());
+		distance[source] = 0;
+		queue.push(QueueItem(0, source));
+		
+		while(!queue.empty()){
+			QueueItem item = queue.top();
+			queue.pop();
+			VertexId v = item.second;
+			if(settled[v]) continue;
+			settled[v] = true;
+			if(wanted != NULL && (*wanted)[v]){
+				if(--wanted_count == 0) break;
+			}
+			
+			for(size_t pos = graph.adjacency_begin(v); pos < graph.adjacency_end(v); ++pos){
+				EdgeId e = graph.adjacent_edge(pos);
+				if(overlay != NULL && overlay->excluded(e)) continue;
+				VertexId w = graph.adjacent_vertex(pos);
+				EdgeWeightType d = item.first + (overlay != NULL ? overlay->weight(graph, e) : graph.edge_weight(e));
+				if(!settled[w] && d < distance[w]){
+					distance[w] = d;
+					if(predecessor != NULL) (*predecessor)[w] = e;
+					queue.push(QueueItem(d, w));
+				}
+			}
+		}
+	}
+	
+	// 頂点sourceからtargetへの最短経路の辺を、source側から順にpathに格納する。
+	// 到達できない場合はfalseを返す。
+	bool shortest_path_edges(const CompactGraph & graph, VertexId source, VertexId target, std::vector<EdgeId> & path){
+		std::vector<EdgeWeightType> distance;
+		std::vector<EdgeId> predecessor;
+		std::vector<bool> wanted(graph.num_vertices(), false);
+		wanted[target] = true;
+		dijkstra_shortest_distances(graph, source, distance, &wanted, 1, &predecessor);
+		
+		path.clear();
+		if(distance[target] == unreachable_distance()) return false;
+		for(VertexId v = target; v != source; ){
+			EdgeId e = predecessor[v];
+			path.push_back(e);
+			v = graph.opposite(e, v);
+		}
+		std::reverse(path.begin(), path.end());
+		return true;
+	}
+	
+	// 始点ごとの最短経路木（各頂点に入ってくる辺）を、まとめて1つの配列に格納したもの。
+	// i番目の始点の木を predecessors_[i * num_vertices()] からのnum_vertices()個の要素とし、頂点の番号をそのまま添字にする
+	// （連結成分ごとに記録する場合は、induced_subgraphで成分の頂点に番号を振り直したグラフの上で求めれば、成分の頂点数の分だけで済む）。
+	// terminal_shortest_distancesで記録した場合、i番目の始点の木はi+1番目以降の始点への経路だけを含む
+	// （i < j のとき、i番目とj番目の始点の間の経路はi番目の木から得られる）。
+	// record_distancesを指定して確保した場合は、木を求めたときの各頂点への距離も記録する
+	// （Dijkstra法を打ち切った場合、最も遠い始点より遠い頂点の距離は確定していない）。
+	class ShortestPathTrees{
+	private:
+		size_t num_vertices_;
+		std::vector<VertexId> sources_;
+		std::vector<size_t> source_index_; // 頂点→始点としての順番（始点でなければno_source()）
+		std::vector<EdgeId> predecessors_;
+		std::vector<EdgeWeightType> distances_; // predecessors_と同じ並び（記録する場合のみ）
+		bool record_distances_;
+		
+		static inline size_t no_source(){ return static_cast<size_t>(-1); }
+	
+	public:
+		ShortestPathTrees() : num_vertices_(0), record_distances_(false) {}
+		
+		// 頂点数num_verticesのグラフについて、sourcesの各頂点を始点とする木の領域を確保する
+		void assign(size_t num_vertices, const std::vector<VertexId> & sources, bool record_distances = false){
+			num_vertices_ = num_vertices;
+			sources_ = sources;
+			source_index_.assign(num_vertices_, no_source());
+			for(size_t i = 0; i < sources_.size(); ++i){
+				if(source_index_[sources_[i]] == no_source()) source_index_[sources_[i]] = i;
+			}
+			predecessors_.assign(num_vertices_ * sources_.size(), no_predecessor());
+			record_distances_ = record_distances;
+			distances_.assign(record_distances_ ? predecessors_.size() : 0, unreachable_distance());
+		}
+		
+		// 始点を1つ末尾に加え、その木の領域を確保する（ほかの始点の木はそのまま残る）
+		void add_source(VertexId source){
+			if(source_index_[source] == no_source()) source_index_[source] = sources_.size();
+			sources_.push_back(source);
+			predecessors_.resize(num_vertices_ * sources_.size(), no_predecessor());
+			if(record_distances_) distances_.resize(predecessors_.size(), unreachable_distance());
+		}
+		
+		inline size_t num_vertices() const{ return num_vertices_; }
+		inline size_t num_sources() const{ return sources_.size(); }
+		inline VertexId source(size_t i) const{ return sources_[i]; }
+		inline bool contains_source(VertexId v) const{ return source_index_[v] != no_source(); }
+		
+		inline bool records_distances() const{ return record_distances_; }
+		
+		// i番目の始点の木に、dijkstra_shortest_distancesで得た（グラフの頂点ごとの）入ってくる辺を格納する。
+		// 距離を記録する場合は、distanceに（グラフの頂点ごとの）距離を与える
+		void set_tree(size_t i, const std::vector<EdgeId> & predecessor, const std::vector<EdgeWeightType> * distance = NULL){
+			std::copy(predecessor.begin(), predecessor.begin() + num_vertices_, predecessors_.begin() + i * num_vertices_);
+			if(record_distances_ && distance != NULL){
+				std::copy(distance->begin(), distance->begin() + num_vertices_, distances_.begin() + i * num_vertices_);
+			}
+		}
+		
+		// i番目の始点の木で、頂点vに入ってくる辺（木に含まれない場合はno_predecessor()）
+		inline EdgeId predecessor(size_t i, VertexId v) const{
+			return predecessors_[i * num_vertices_ + v];
+		}
+		
+		// i番目の始点の木を求めたときの、頂点vへの距離（記録していない場合はunreachable_distance()）
+		inline EdgeWeightType distance(size_t i, VertexId v) const{
+			return record_distances_ ? distances_[i * num_vertices_ + v] : unreachable_distance();
+		}
+		
+		// i番目の始点の木を、頂点vから根（始点）に向かって辿り、順に visitor(出発する頂点, 辺, 到着する頂点) に渡す。
+		// vが木に含まれない場合はfalseを返す。
+		template <class EdgeVisitor>
+		bool for_each_tree_edge(const CompactGraph & graph, size_t i, VertexId v, EdgeVisitor visitor) const{
+			while(v != sources_[i]){
+				EdgeId e = predecessor(i, v);
+				if(e == no_predecessor()) return false;
+				VertexId next = graph.opposite(e, v);
+				visitor(v, e, next);
+				v = next;
+			}
+			return true;
+		}
+		
+		// 始点v1, v2の間の最短経路の辺を、順に visitor(出発する頂点, 辺, 到着する頂点) に渡す。
+		// 経路を配列に取り出さず、木を辿りながら渡す（どちらの端から辿るかは始点の順による）。
+		// 経路が記録されていない場合はfalseを返す。
+		template <class EdgeVisitor>
+		bool for_each_path_edge(const CompactGraph & graph, VertexId v1, VertexId v2, EdgeVisitor visitor) const{
+			if(!contains_source(v1) || !contains_source(v2)) return false;
+			size_t i = source_index_[v1];
+			if(i > source_index_[v2]){
+				i = source_index_[v2];
+				std::swap(v1, v2);
+			}
+			// v1を根とする木を、v2から根に向かって辿る
+			return for_each_tree_edge(graph, i, v2, visitor);
+		}
+	};
+	
+	// terminal_shortest_distances_mainのうち、i番目の頂点からi+1番目以降の頂点への距離（とi番目の木）だけを求める。
+	// full_rowが真なら、i番目より前の頂点への距離も求める（後から加えた頂点の距離を求める場合など）。
+	// 辺の距離を変えたときに、影響のある始点についてだけ求め直すのにも用いる。
+	template <class MatrixType>
+	void terminal_shortest_distances_row(const CompactGraph & graph, const std::vector<VertexId> & terminals, size_t i, MatrixType & result, ShortestPathTrees * trees = NULL, const EdgeOverlay * overlay = NULL, bool full_row = false){
+		size_t first = (full_row ? 0 : i + 1);
+		std::vector<EdgeWeightType> distance;
+		std::vector<EdgeId> predecessor;
+		std::vector<bool> wanted(graph.num_vertices(), false);
+		size_t wanted_count = 0;
+		for(size_t j = first; j < terminals.size(); ++j){
+			if(j != i && !wanted[terminals[j]]){
+				wanted[terminals[j]] = true;
+				++wanted_count;
+			}
+		}
+		if(wanted_count == 0) return;
+		
+		dijkstra_shortest_distances(graph, terminals[i], distance, &wanted, wanted_count, (trees != NULL ? &predecessor : NULL), overlay);
+		for(size_t j = first; j < terminals.size(); ++j){
+			if(j != i) result(i, j) = distance[terminals[j]];
+		}
+		if(trees != NULL) trees->set_tree(i, predecessor, &distance);
+	}
+	
+	// terminals同士の最短距離を求め、result(i, j)に格納する
+	// （resultはterminalsの順に番号が振られているものとする）。
+	// 距離は対称なので、i番目の頂点からはi+1番目以降の頂点への距離だけを求める。
+	// treesが与えられた場合は、最短経路木も記録する（treesはterminalsを始点として確保しておくこと）。
+	// overlayが与えられた場合、辺の距離と有無はoverlayに従う。
+	template <class MatrixType>
+	void terminal_shortest_distances_main(const CompactGraph & graph, const std::vector<VertexId> & terminals, MatrixType & result, ShortestPathTrees * trees = NULL, const EdgeOverlay * overlay = NULL){
+		for(size_t i = 0; i + 1 < terminals.size(); ++i){
+			terminal_shortest_distances_row(graph, terminals, i, result, trees, overlay);
+		}
+	}
+	
+	// 与えられた頂点（奇数次の頂点など）同士の最短距離を求め、resultに格納する。
+	// resultの頂点の番号はterminalsでの順序と同じになる。
+	// 各頂点からDijkstra法を用いるので、計算量は O(|terminals| E log V)。
+	// 全頂点対を求めるFloyd-Warshall法（O(V^3)）よりも、
+	// 疎なグラフで奇数次の頂点が少ない場合にずっと速い。
+	// treesが与えられた場合は、頂点同士の最短経路も（木の形で）記録する。
+	void terminal_shortest_distances(const CompactGraph & graph, const std::vector<VertexId> & terminals, CompactDistanceMatrix & result, ShortestPathTrees * trees = NULL){
+		result.assign(terminals);
+		if(trees != NULL) trees->assign(graph.num_vertices(), terminals);
+		terminal_shortest_distances_main(graph, terminals, result, trees);
+	}
+	
+	// boost::adjacency_listのグラフ上で記録した、頂点同士の最短経路木。
+	// 木は、グラフをCompactGraphに変換したもの（頂点と辺の番号は0から振り直す）の上で記録する。
+	struct GraphPathTrees{
+		CompactGraph graph;
+		std::vector<Graph::vertex_descriptor> vertices; // graphの頂点に対応する元のグラフの頂点
+		std::vector<Graph::edge_descriptor> edges; // graphの辺に対応する元のグラフの辺
+		std::map<VertexId, VertexId> terminals; // 始点の頂点の名前（駅名の表での番号）→graphでの番号
+		ShortestPathTrees trees;
+		
+		// 始点とした頂点（駅名の表での番号）v1, v2の間の最短経路の辺を、元のグラフの頂点と辺で
+		// 順に visitor(出発する頂点, 辺, 到着する頂点) に渡す。経路が記録されていない場合はfalseを返す。
+		template <class EdgeVisitor>
+		bool for_each_path_edge(VertexId v1, VertexId v2, EdgeVisitor visitor) const{
+			std::map<VertexId, VertexId>::const_iterator found1 = terminals.find(v1), found2 = terminals.find(v2);
+			if(found1 == terminals.end() || found2 == terminals.end()) return false;
+			return trees.for_each_path_edge(graph, found1->second, found2->second, [&](VertexId from, EdgeId e, VertexId to){
+				visitor(vertices[from], edges[e], vertices[to]);
+			});
+		}
+	};
+	
+	// CompactGraphの一部（連結成分など）をinduced_subgraphで取り出し、その上で記録した頂点同士の最短経路木。
+	// 木の頂点と辺は部分グラフでの番号なので、Dijkstra法も木も元のグラフ全体の大きさによらない。
+	struct SubgraphPathTrees{
+		CompactGraph graph;
+		std::vector<VertexId> vertices; // graphの頂点に対応する元のグラフの頂点
+		std::vector<EdgeId> edges; // graphの辺に対応する元のグラフの辺
+		ShortestPathTrees trees;
+		
+		// 始点としたgraphの頂点v1, v2の間の最短経路の辺を、元のグラフの頂点と辺で
+		// 順に visitor(出発する頂点, 辺, 到着する頂点) に渡す。経路が記録されていない場合はfalseを返す。
+		template <class EdgeVisitor>
+		bool for_each_path_edge(VertexId v1, VertexId v2, EdgeVisitor visitor) const{
+			return trees.for_each_path_edge(graph, v1, v2, [&](VertexId from, EdgeId e, VertexId to){
+				visitor(vertices[from], edges[e], vertices[to]);
+			});
+		}
+	};
+	
+	// boost::adjacency_listのグラフについて、CompactGraphに変換してから同様に求める。
+	// pathsが与えられた場合は、頂点同士の最短経路も（木の形で）記録する。
+	void terminal_shortest_distances(const Graph & graph, const std::vector<Graph::vertex_descriptor> & terminals, DistanceMatrix & result, GraphPathTrees * paths = NULL){
+		result.assign(terminals);
+		if(terminals.empty()) return;
+		
+		CompactGraph local_compact;
+		std::vector<Graph::vertex_descriptor> local_vertices;
+		CompactGraph & compact = (paths != NULL ? paths->graph : local_compact);
+		std::vector<Graph::vertex_descriptor> & vertices = (paths != NULL ? paths->vertices : local_vertices);
+		make_compact_graph(graph, compact, &vertices, (paths != NULL ? &paths->edges : NULL));
+		
+		std::map<Graph::vertex_descriptor, VertexId> index;
+		for(size_t i = 0; i < vertices.size(); ++i){
+			index.insert(std::make_pair(vertices[i], static_cast<VertexId>(i)));
+		}
+		std::vector<VertexId> terminal_ids(terminals.size());
+		for(size_t i = 0; i < terminals.size(); ++i){
+			terminal_ids[i] = index.at(terminals[i]);
+		}
+		if(paths != NULL){
+			paths->terminals.clear();
+			for(size_t i = 0; i < terminals.size(); ++i){
+				paths->terminals.insert(std::make_pair(boost::get(boost::vertex_name, graph, terminals[i]), terminal_ids[i]));
+			}
+			paths->trees.assign(compact.num_vertices(), terminal_ids);
+		}
+		terminal_shortest_distances_main(compact, terminal_ids, result, (paths != NULL ? &paths->trees : NULL));
+	}
+	
+	// 全頂点対の最短距離をFloyd-Warshall法で求める。
+	// terminal_shortest_distancesの結果の検算用。
+	// グラフをCompactGraphに変換し、その頂点の番号をそのまま表の番号として、表を番号で直接読み書きする
+	// （頂点から表の番号への変換は、変換のときに一度だけ行う）。表は対称なので、i <= j の組だけを更新する。
+	inline void all_pairs_shortest_distances(const Graph & graph, DistanceMatrix & result){
+		CompactGraph compact;
+		std::vector<Graph::vertex_descriptor> vertices;
+		make_compact_graph(graph, compact, &vertices);
+		result.assign(vertices, true, unreachable_distance());
+		
+		size_t n = vertices.size();
+		for(size_t i = 0; i < n; ++i) result(i, i) = 0;
+		for(EdgeId e = 0; e < compact.num_edges(); ++e){
+			EdgeWeightType & d = result(compact.edge_source(e), compact.edge_target(e));
+			d = std::min(d, compact.edge_weight(e));
+		}
+		
+		for(size_t k = 0; k < n; ++k){
+			for(size_t i = 0; i < n; ++i){
+				EdgeWeightType d_ik = result(i, k);
+				if(d_ik == unreachable_distance()) continue;
+				for(size_t j = i; j < n; ++j){
+					EdgeWeightType d_kj = result(k, j);
+					if(d_kj == unreachable_distance()) continue;
+					EdgeWeightType & d_ij = result(i, j);
+					if(d_ik + d_kj < d_ij) d_ij = d_ik + d_kj;
+				}
+			}
+		}
+	}
+} // namespace ChinesePostman
+
+#endif // SHORTEST_PATHS_HPP_
@@ -1,328 +1,868 @@
-#include "ChinesePostman.hpp"
-#include "masked_vector.hpp"
-#include <iostream>
-#include <algorithm>
-
-//#define CHINESE_POSTMAN_DEBUG_DUMP // řvZʂ̏ڍׂ\ꍇ
-//#define CHINESE_POSTMAN_DEBUG_PROGRESS // řvZǂ̒xił邩\ꍇ
-
-template <class TYPE>
-inline bool equal_pair(const TYPE & obj1_elem1, const TYPE & obj1_elem2, const TYPE & obj2_elem1, const TYPE & obj2_elem2){
-	if(obj1_elem1 == obj2_elem1){
-		return(obj1_elem2 == obj2_elem2);
-	}else if(obj1_elem1 == obj2_elem2){
-		return(obj1_elem2 == obj2_elem1);
-	}else{
-		return false;
-	}
-}
-
-ChinesePostman::EdgeWeightType sum_of_distance(const std::deque<ChinesePostman::SubRoute> & route){
-	ChinesePostman::EdgeWeightType result = 0;
-	for(auto it = route.cbegin(); it != route.cend(); ++it){
-		result += it->weight;
-	}
-	return result;
-}
-
-int main(int argc, char ** argv){
-	if(argc < 2 || argc > 3){
-		std::cerr << "Usage: " << argv[0] << " GRAPH_FILENAME (CUT_FILENAME)" << std::endl;
-		return 1;
-	}
-	
-	// ---------- Jbgӂ̈ꗗ
-	ChinesePostman::RouteNetwork cut;
-	if(argc == 3){
-		ChinesePostman::EdgeWeightType cut_distance = ChinesePostman::read_from(argv[2], cut);
-		if(cut_distance == 0){
-			std::cerr << "Error: When reading \"" << argv[2] << "\"" << std::endl;
-			return 1;
-		}
-	}
-	
-	// ---------- Ot
-	ChinesePostman::RouteNetwork rn;
-	ChinesePostman::EdgeWeightType total_distance = ChinesePostman::read_from(argv[1], rn);
-	if(total_distance == 0){
-		std::cerr << "Error: When reading \"" << argv[1] << "\"" << std::endl;
-		return 1;
-	}
-	
-	// ---------- uJbgӂ̈ꗗvɂӂƂƂɁAꂽӂɐڂ钸_񋓂
-	std::pair<ChinesePostman::Graph::edge_iterator, ChinesePostman::Graph::edge_iterator> edge_range = boost::edges(rn);
-	std::vector<ChinesePostman::Graph::edge_descriptor> removed_edges_later_rn;
-	
-	// border_vertices
-	// L[F_
-	// lfirstFY_̃Ot̂߂ɑĂ邩iقǎwj
-	// lsecondFY_masked_vertices_orig̉Ԗڂ̗vfł邩iقǎwj
-	std::map< ChinesePostman::Graph::vertex_descriptor, std::pair<size_t, size_t> > border_vertices;
-	
-	// cut̕ӏWɒ_xoĂ邩
-	std::map< ChinesePostman::Graph::vertex_descriptor, size_t > border_vertices_count, border_vertices_count_tmp;
-	
-	std::multiset<ChinesePostman::VirtualEdge> border_edges;
-	
-	
-	std::pair<ChinesePostman::Graph::edge_iterator, ChinesePostman::Graph::edge_iterator> cutedge_range;
-	
-	for(ChinesePostman::Graph::edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
-		cutedge_range = boost::edges(cut);
-		ChinesePostman::Graph::edge_iterator cutite;
-		
-		for(cutite = cutedge_range.first; cutite != cutedge_range.second; ++cutite){
-			if(rn.edgeweight(*ite) == cut.edgeweight(*cutite) && equal_pair(
-				rn.vertexname1_fromedge(*ite), rn.vertexname2_fromedge(*ite),
-				cut.vertexname1_fromedge(*cutite), cut.vertexname2_fromedge(*cutite)
-			)){
-				break;
-			}
-		}
-		if(cutite != cutedge_range.second){
-			boost::remove_edge(*cutite, cut);
-			removed_edges_later_rn.push_back(*ite);
-			
-			ChinesePostman::Graph::vertex_descriptor v1, v2;
-			v1 = boost::source(*ite, rn);
-			v2 = boost::target(*ite, rn);
-			border_vertices.insert(std::make_pair(v1, std::make_pair(-1, -1)));
-			border_vertices.insert(std::make_pair(v2, std::make_pair(-1, -1)));
-			border_vertices_count_tmp[v1] += 1;
-			border_vertices_count_tmp[v2] += 1;
-			border_edges.insert(ChinesePostman::VirtualEdge(v1, v2, rn.edgeweight(*ite)));
-		}
-	}
-	
-	cutedge_range = boost::edges(cut);
-	if(cutedge_range.first != cutedge_range.second){
-		std::cerr << "ERROR: Cutting edge not found - " << cut.vertexname1_fromedge(*(cutedge_range.first)) << ", " << cut.vertexname2_fromedge(*(cutedge_range.first)) << std::endl;
-		return 1;
-	}
-	
-	for(std::vector<ChinesePostman::Graph::edge_descriptor>::iterator ite = removed_edges_later_rn.begin(); ite != removed_edges_later_rn.end(); ++ite){
-		boost::remove_edge(*ite, rn);
-	}
-	
-	// ---------- Avfɕ
-	ChinesePostman::RouteNetworkList division_result;
-	ChinesePostman::VertexMapping vmap; // vmaṕũOtł̒_L[ÃOtł̒_lƂAzzv
-	rn.connectedcomponents(division_result, vmap);
-	
-	// ---------- Avf̂ꂼɂāA2ʂ钸_肷
-	// ̂ƂAE̒_͊ʂ邩ʂ邩ŏꍇ킯Kv
-	// Ȃ킿Ai2^[E̒_]jʂKv
-	// tOĂ΁uE瓖Yw𗘗p񐔂͋v
-	// łȂΊ
-	
-	std::vector< std::map< masked_vector<ChinesePostman::Graph::vertex_descriptor>::mask_type, std::deque<ChinesePostman::SubRoute> > > doubling_result(division_result.size());
-	std::vector< masked_vector<ChinesePostman::Graph::vertex_descriptor> > masked_vertices_orig(division_result.size());
-	std::vector< masked_vector<ChinesePostman::Graph::vertex_descriptor> > masked_vertices_sub(division_result.size());
-	
-	size_t graph_component_id;
-	
-	graph_component_id = 0;
-	for(ChinesePostman::RouteNetworkList::iterator itg = division_result.begin(); itg != division_result.end(); ++itg){
-		std::pair<ChinesePostman::Graph::vertex_iterator, ChinesePostman::Graph::vertex_iterator> vertex_range = boost::vertices(*itg);
-		std::cerr << "Computing the graph of Stations[0] = \"" << (vertex_range.first == vertex_range.second ? std::string("<none>") : itg->vertexname(*vertex_range.first)) << "\", ";
-		std::cerr << "Stations.size = " << boost::num_vertices(*itg) << ", ";
-		std::cerr << "Edges.size = " << boost::num_edges(*itg) << std::endl;
-		
-		// border_vertices_subgraph
-		// ̃Otł̒_L[ÃOti*itgjł̒_lƂ
-		// AzzŁAEɈʒuĂ̂̂ݏW߂
-		std::map<ChinesePostman::Graph::vertex_descriptor, ChinesePostman::Graph::vertex_descriptor> border_vertices_subgraph;
-		
-		for(ChinesePostman::Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
-			std::map< ChinesePostman::Graph::vertex_descriptor, std::pair<size_t, size_t> >::iterator itvb = std::find_if(border_vertices.begin(), border_vertices.end(), [&](const std::pair< ChinesePostman::Graph::vertex_descriptor, std::pair<size_t, size_t> > & v){ return vmap.at(v.first) == *itv; });
-			if(itvb != border_vertices.end()){
-				itvb->second.first = graph_component_id;
-				border_vertices_subgraph[itvb->first] = *itv;
-				border_vertices_count[*itv] = border_vertices_count_tmp[itvb->first];
-			}
-		}
-		
-		// ԍtmasked_vertices_*Ɋi[
-		size_t count = 0;
-		for(std::map<ChinesePostman::Graph::vertex_descriptor, ChinesePostman::Graph::vertex_descriptor>::iterator itv = border_vertices_subgraph.begin(); itv != border_vertices_subgraph.end(); ++itv){
-			border_vertices[itv->first].second = count;
-			++count;
-			masked_vertices_orig[graph_component_id].push_back(itv->first);
-			masked_vertices_sub[graph_component_id].push_back(itv->second);
-		}
-		
-		// tCh[V
-		ChinesePostman::DistanceMatrix distance_table;
-		boost::floyd_warshall_all_pairs_shortest_paths(*itg, distance_table);
-		
-		// ׂĂborder_vertices_subgraphu̕Wvɂ
-		// 2ʂׂӂ肷
-#ifdef CHINESE_POSTMAN_DEBUG_PROGRESS
-		glp_term_out(GLP_ON);
-#else
-		glp_term_out(GLP_OFF);
-#endif // CHINESE_POSTMAN_DEBUG_PROGRESS
-		
-		do{
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-			std::cerr << "    Border nodes visited for even-number times (mask: " << masked_vertices_sub[graph_component_id].mask() << ", size: " << masked_vertices_sub[graph_component_id].size() << ")";
-			std::cerr << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			
-			masked_vertices_orig[graph_component_id].next();
-			masked_vertices_sub[graph_component_id].next();
-			
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-			std::cerr << "    Border nodes visited for even-number times (mask: " << masked_vertices_sub[graph_component_id].mask() << ", size: " << masked_vertices_sub[graph_component_id].size() << ")";
-			for(size_t i = 0; i < masked_vertices_sub[graph_component_id].size(); ++i){
-				if(masked_vertices_sub[graph_component_id].has(i)){
-					std::cerr << " " << itg->vertexname(masked_vertices_sub[graph_component_id][i]);
-				}
-			}
-			std::cerr << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			
-			// gݍ킹߂
-			if(itg->find_doubled_edges(distance_table, doubling_result[graph_component_id][masked_vertices_sub[graph_component_id].mask()], masked_vertices_sub[graph_component_id], border_vertices_count)){
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-				std::cerr << "[[Computed!!]]" << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			}else{
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-				std::cerr << "[[Skipped!]]" << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-				doubling_result[graph_component_id].erase(masked_vertices_sub[graph_component_id].mask());
-			}
-		}while(!(masked_vertices_sub[graph_component_id].emptymask()));
-		
-		++graph_component_id;
-	}
-	
-	// Jbgp̕ӂ1ʂ/2ʂƂׂĂ̑gݍ킹ɂ
-	// e̋Ƒgݍ킹Ă
-	masked_vector<ChinesePostman::VirtualEdge> border_edge_subsets(border_edges);
-	
-	std::vector< masked_vector<ChinesePostman::Graph::vertex_descriptor>::mask_type > mask_compo(division_result.size());
-	ChinesePostman::EdgeWeightType best_distance = 0;
-	std::vector<const std::deque<ChinesePostman::SubRoute> *> temp_doubling_result(division_result.size()), best_doubling_result(division_result.size());
-	masked_vector<ChinesePostman::VirtualEdge>::mask_type best_border_edge_subset_mask;
-	
-	boost::multiprecision::cpp_int percentage = 0, new_percentage;
-	boost::multiprecision::cpp_int max_mask = 1;
-	max_mask = (max_mask << border_edge_subsets.size()) - 1;
-	if(max_mask == 0) max_mask = 1;
-	
-	do{
-		new_percentage = border_edge_subsets.mask() * 100 / max_mask;
-		if(new_percentage == 100 || new_percentage >= percentage + 10){
-			percentage = new_percentage;
-			std::cerr << "Border edge doubling: " << percentage << "%" << std::endl;
-		}
-		
-		border_edge_subsets.next();
-		
-		// Jbgp̕ӂ1ʂ/2ʂƂgݍ킹iborder_edge_subsetsjɂ
-		// Ή鋫E̒_ʂ邩ʂ邩肷
-		std::fill(mask_compo.begin(), mask_compo.end(), 0);
-		
-		std::pair<size_t, size_t> flag4vertex;
-		ChinesePostman::EdgeWeightType cut_distance = 0;
-		ChinesePostman::EdgeWeightType compo_distance = 0;
-		
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-		std::cerr << "----------";
-		std::cerr << "Doubling the following cut edges:";
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-		for(size_t i = 0; i < border_edge_subsets.size(); ++i){
-			if(border_edge_subsets.has(i)){
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-				std::cerr << " " << rn.vertexname(border_edge_subsets[i].v1);
-				std::cerr << "-" << rn.vertexname(border_edge_subsets[i].v2);
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-				cut_distance += border_edge_subsets[i].weight;
-				
-				flag4vertex = border_vertices[border_edge_subsets[i].v1];
-				boost::multiprecision::bit_flip(mask_compo[flag4vertex.first], flag4vertex.second);
-				flag4vertex = border_vertices[border_edge_subsets[i].v2];
-				boost::multiprecision::bit_flip(mask_compo[flag4vertex.first], flag4vertex.second);
-			}
-		}
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-		std::cerr << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-		
-		// E̒_ʂ邩ʂ邩̑gݍ킹
-		// ۂɎ\mF
-		ChinesePostman::RouteNetworkList::iterator itg;
-		graph_component_id = 0;
-		for(itg = division_result.begin(); itg != division_result.end(); ++itg){
-			if(doubling_result[graph_component_id].find(mask_compo[graph_component_id]) == doubling_result[graph_component_id].end()) break;
-			++graph_component_id;
-		}
-		if(itg != division_result.end()){
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-			std::cerr << "Not possible" << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			continue;
-		}
-		
-		// iۂɉ\ȂjẐ擾
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-		std::cerr << "Doubled edges optimization: " << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-		graph_component_id = 0;
-		for(itg = division_result.begin(); itg != division_result.end(); ++itg){
-			temp_doubling_result[graph_component_id] = &(doubling_result[graph_component_id][mask_compo[graph_component_id]]);
-			
-			for(std::deque<ChinesePostman::SubRoute>::const_iterator its = temp_doubling_result[graph_component_id]->cbegin(); its != temp_doubling_result[graph_component_id]->cend(); ++its){
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-				std::cerr << " " << its->v1;
-				std::cerr << "-" << its->v2;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-			}
-			
-			compo_distance += sum_of_distance(*(temp_doubling_result[graph_component_id]));
-			
-			++graph_component_id;
-		}
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-		std::cerr << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-		
-#ifdef CHINESE_POSTMAN_DEBUG_DUMP
-		std::cout << "Doubled edge weight in cuts: " << cut_distance << std::endl;
-		std::cout << "Doubled edge weight in optimization: " << compo_distance << std::endl;
-#endif // CHINESE_POSTMAN_DEBUG_DUMP
-		
-		if(best_distance == 0 || best_distance > cut_distance + compo_distance){
-			best_distance = cut_distance + compo_distance;
-			best_doubling_result.swap(temp_doubling_result);
-			best_border_edge_subset_mask = border_edge_subsets.mask();
-		}
-	}while(!(border_edge_subsets.emptymask()));
-	
-	std::cout << "# ---------- Best Result ----------" << std::endl;
-	std::cout << "# Total distance of all graph edges = " << total_distance << std::endl;
-	std::cout << "# Total distance of doubled edges = " << best_distance << std::endl;
-	std::cout << "# Total distance of traversed edges = " << total_distance + best_distance << std::endl;
-	std::cout << "# Edges traversed twice in cuts" << std::endl;
-	border_edge_subsets.set_mask(best_border_edge_subset_mask);
-	for(size_t i = 0; i < border_edge_subsets.size(); ++i){
-		if(border_edge_subsets.has(i)){
-			std::cout << border_edge_subsets[i].weight << " ";
-			std::cout << rn.vertexname(border_edge_subsets[i].v1) << " ";
-			std::cout << rn.vertexname(border_edge_subsets[i].v2) << std::endl;
-		}
-	}
-	
-	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
-		std::cout << "# Edges traversed twice in component " << (graph_component_id+1) << std::endl;
-		for(std::deque<ChinesePostman::SubRoute>::const_iterator its = best_doubling_result[graph_component_id]->cbegin(); its != best_doubling_result[graph_component_id]->cend(); ++its){
-			std::cout << its->weight << " ";
-			std::cout << its->v1 << " ";
-			std::cout << its->v2 << std::endl;
-		}
-	}
-	
-	return 0;
-}
+#include "ChinesePostman.hpp"
+#include "masked_vector.hpp"
+#include "CutCombiner.hpp"
+#include "GraphPartition.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+// 最小マッチングを求める1つの仕事で調べる、境界の頂点のマスクの個数
+#define SOLVE_CHINESE_POSTMAN_MASKS_PER_TASK 64
+
+// カットする辺の一覧のファイルを読み込み、辺をcut_edgesに加える（駅名はnamesに登録する）。
+// 向きを区別しないよう、辺の両端は番号の小さい方をv1とする。返り値はread_edges_fromを参照。
+ChinesePostman::EdgeWeightType read_cut_edges(const char * fname, ChinesePostman::NameTable & names, std::multiset<ChinesePostman::VirtualEdge> & cut_edges){
+	return ChinesePostman::read_edges_from(fname, [&](ChinesePostman::EdgeWeightType distance, const boost::string_ref & name1, const boost::string_ref & name2){
+		ChinesePostman::VertexId v1 = names.intern(name1);
+		ChinesePostman::VertexId v2 = names.intern(name2);
+		cut_edges.insert(ChinesePostman::VirtualEdge(std::min(v1, v2), std::max(v1, v2), distance));
+	});
+}
+
+// カットする辺を、次数2の頂点でつないだ鎖。
+// 鎖の途中の頂点は次数2で、その2本の辺がともにカットされるので、その頂点を偶数回通るには
+// 2本の辺を2回通るかどうかが一致していなければならない。すなわち鎖の辺は、すべて2回通るか、
+// すべて1回通るかのどちらかになるので、2回通るかどうかは鎖ごとに決めればよい
+// （RouteNetwork::remove_trivial_verticesで次数2の頂点を除去するのと同じ考え方）。
+struct CutChain{
+	ChinesePostman::VertexId v1, v2; // 両端の頂点（鎖が輪になっている場合は同じ頂点）
+	ChinesePostman::EdgeWeightType weight; // 鎖の辺の距離の和
+	std::vector<ChinesePostman::VirtualEdge> edges; // 鎖の辺（v1の側から順に）
+};
+
+// カットする辺cut_edgesを鎖にまとめてchainsに格納する。
+// degree[v]は、カットする前の路線網での頂点v（駅名の表での番号）の次数。
+// 次数が2で、接する2本の辺がともにカットされる頂点を鎖の途中の頂点とし、
+// 途中でない頂点から、途中の頂点を通り抜けて次の途中でない頂点まで辿る。
+// 残った辺は途中の頂点だけからなる輪なので、1つの頂点を両端とする鎖にする。
+void group_cut_chains(const std::vector<ChinesePostman::VirtualEdge> & cut_edges, const std::vector<size_t> & degree, std::vector<CutChain> & chains){
+	// 頂点ごとの、接するカットする辺の番号（自己ループは1回だけ数える）
+	std::map< ChinesePostman::VertexId, std::vector<size_t> > incident;
+	for(size_t i = 0; i < cut_edges.size(); ++i){
+		incident[cut_edges[i].v1].push_back(i);
+		if(cut_edges[i].v2 != cut_edges[i].v1) incident[cut_edges[i].v2].push_back(i);
+	}
+	auto is_interior = [&](ChinesePostman::VertexId v){
+		return degree[v] == 2 && incident[v].size() == 2;
+	};
+	
+	std::vector<bool> used(cut_edges.size(), false);
+	auto walk = [&](ChinesePostman::VertexId start, size_t first_edge){
+		CutChain chain;
+		chain.v1 = start;
+		chain.weight = 0;
+		ChinesePostman::VertexId v = start;
+		size_t e = first_edge;
+		for(;;){
+			used[e] = true;
+			chain.edges.push_back(cut_edges[e]);
+			chain.weight += cut_edges[e].weight;
+			v = (cut_edges[e].v1 == v ? cut_edges[e].v2 : cut_edges[e].v1);
+			if(v == start || !is_interior(v)) break;
+			e = (incident[v][0] == e ? incident[v][1] : incident[v][0]);
+		}
+		chain.v2 = v;
+		chains.push_back(chain);
+	};
+	
+	chains.clear();
+	for(std::map< ChinesePostman::VertexId, std::vector<size_t> >::const_iterator iti = incident.begin(); iti != incident.end(); ++iti){
+		if(is_interior(iti->first)) continue;
+		for(std::vector<size_t>::const_iterator ite = iti->second.begin(); ite != iti->second.end(); ++ite){
+			if(!used[*ite]) walk(iti->first, *ite);
+		}
+	}
+	for(size_t i = 0; i < cut_edges.size(); ++i){
+		if(!used[i]) walk(cut_edges[i].v1, i);
+	}
+}
+
+// 路線網rnの辺edgeを、端の頂点fromの側から元の駅の区間に展開し（RouteNetwork::expand_edgeを参照）、
+// 区間ごとに元の路線網networkの辺を探してresultに加える（最短経路を求め直すことはない）。
+// networkにない区間があった場合はfalseを返す。
+bool expand_to_network(const ChinesePostman::RouteNetwork & rn, ChinesePostman::Graph::edge_descriptor edge, ChinesePostman::Graph::vertex_descriptor from, const ChinesePostman::CompactGraph & network, std::vector<ChinesePostman::EdgeId> & result){
+	bool found = true;
+	rn.expand_edge(edge, from, [&](ChinesePostman::VertexId v1, ChinesePostman::EdgeWeightType weight, ChinesePostman::VertexId v2){
+		ChinesePostman::EdgeId e = network.find_edge(v1, v2, weight);
+		if(e == network.num_edges()){
+			found = false;
+		}else{
+			result.push_back(e);
+		}
+	});
+	return found;
+}
+
+// 経路を出力する場合（--tour）に、除去した辺を元の路線網の辺に展開したもの
+struct TourRoutes{
+	const ChinesePostman::CompactGraph * network; // 辺を除去する前の路線網（頂点の番号は駅名の表での番号）
+	ChinesePostman::VertexId start; // 出発する駅
+	std::vector<ChinesePostman::EdgeId> bridge_edges; // 橋を展開したnetworkの辺
+	// カットする辺（両端は番号の小さい方をv1とする）を展開したnetworkの辺。
+	// 両端と距離が同じ辺はどれを展開しても、経路の各駅を通る回数の偶奇と距離は変わらないので、1つだけ覚えておく
+	std::map< ChinesePostman::VirtualEdge, std::vector<ChinesePostman::EdgeId> > cut_edges;
+	bool expanded; // すべての辺を展開できたか
+	
+	TourRoutes(const ChinesePostman::CompactGraph * nnetwork, ChinesePostman::VertexId sstart)
+	: network(nnetwork), start(sstart), expanded(true) {}
+};
+
+ChinesePostman::EdgeWeightType sum_of_distance(const std::deque<ChinesePostman::SubRoute> & route){
+	ChinesePostman::EdgeWeightType result = 0;
+	for(auto it = route.cbegin(); it != route.cend(); ++it){
+		result += it->weight;
+	}
+	return result;
+}
+
+// 分割後の各連結要素について、境界の頂点のマスクごとに2回通る辺を求め、
+// カット用の辺（の鎖。CutChainを参照）と組み合わせて最小のものを出力する。
+// MaskTypeは境界の頂点のマスクの型で、境界の頂点の数がそのビット数を超えてはならない。
+// bridgesが与えられた場合（--divide-by-bridge）は、その辺（除去した橋）も2回通るものとして出力する。
+// tour_routesが与えられた場合（--tour）は、経路も出力する。
+template <class MaskType>
+int solve_divided(
+	const ChinesePostman::RouteNetwork & rn,
+	const ChinesePostman::RouteNetworkList & division_result,
+	const std::vector< std::vector<ChinesePostman::Graph::vertex_descriptor> > & border_vertices_sub,
+	const std::map< ChinesePostman::VertexId, std::pair<size_t, size_t> > & border_vertices,
+	const std::map< ChinesePostman::Graph::vertex_descriptor, size_t > & border_vertices_count,
+	const std::vector<CutChain> & cut_chains,
+	const std::vector<ChinesePostman::VirtualEdge> * bridges,
+	const ChinesePostman::MatchingOptions & matching_options,
+	bool use_floyd_warshall,
+	ChinesePostman::EdgeWeightType total_distance,
+	const TourRoutes * tour_routes){
+	
+	ChinesePostman::Instrumentation * instrumentation = matching_options.instrumentation;
+	size_t graph_component_id;
+	std::vector< std::map< MaskType, std::deque<ChinesePostman::SubRoute> > > doubling_result(division_result.size());
+	std::vector< masked_vector<ChinesePostman::Graph::vertex_descriptor, MaskType> > border(division_result.size());
+	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+		border[graph_component_id] = masked_vector<ChinesePostman::Graph::vertex_descriptor, MaskType>(border_vertices_sub[graph_component_id]);
+	}
+	
+	// ---------- 各連結要素について、奇数次になりうる頂点同士の最短距離を求める
+	// 経路を出力する場合は、最短経路木も記録する（2回通る区間は、それを辿って元の路線網の辺に展開する）
+	std::vector<ChinesePostman::DistanceMatrix> distance_tables(division_result.size());
+	std::vector<ChinesePostman::GraphPathTrees> path_trees(tour_routes != NULL ? division_result.size() : 0);
+	{
+		ChinesePostman::ScopedPhase phase(instrumentation, "shortest_paths");
+		ChinesePostman::parallel_for(division_result.size(), matching_options.num_threads, [&](size_t id){
+			std::vector<ChinesePostman::Graph::vertex_descriptor> odd_vertices;
+			if(!use_floyd_warshall || tour_routes != NULL){
+				division_result[id].odd_vertex_candidates(odd_vertices, border[id]);
+			}
+			if(use_floyd_warshall){
+				ChinesePostman::all_pairs_shortest_distances(division_result[id], distance_tables[id]);
+				if(tour_routes != NULL){
+					ChinesePostman::DistanceMatrix unused;
+					ChinesePostman::terminal_shortest_distances(division_result[id], odd_vertices, unused, &path_trees[id]);
+				}
+			}else{
+				ChinesePostman::count(instrumentation, "odd_vertex_candidates", static_cast<long long>(odd_vertices.size()));
+				ChinesePostman::terminal_shortest_distances(division_result[id], odd_vertices, distance_tables[id], (tour_routes != NULL ? &path_trees[id] : NULL));
+			}
+		});
+	}
+	
+	// ---------- 各連結要素について、マスクの実現可能性と2回通る辺の距離の下限を求める準備をする
+	// （ChinesePostman::BorderMaskBoundを参照）
+	typedef ChinesePostman::BorderMaskBound<MaskType> MaskBound;
+	typedef masked_vector<ChinesePostman::Graph::vertex_descriptor, MaskType> BorderVector;
+	std::vector< std::unique_ptr<MaskBound> > bounds(division_result.size());
+	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+		bounds[graph_component_id].reset(new MaskBound(division_result[graph_component_id], distance_tables[graph_component_id], border[graph_component_id], border_vertices_count));
+	}
+	
+	// 境界の頂点ごとの、接するカット用の辺の鎖の距離の最小値
+	// （マスクのビットが立つ境界の頂点には、2回通る鎖が少なくとも1本接する）
+	std::vector< std::vector<ChinesePostman::EdgeWeightType> > nearest_chain(division_result.size());
+	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+		nearest_chain[graph_component_id].assign(border[graph_component_id].size(), std::numeric_limits<ChinesePostman::EdgeWeightType>::max());
+	}
+	for(std::vector<CutChain>::const_iterator itc = cut_chains.begin(); itc != cut_chains.end(); ++itc){
+		const std::pair<size_t, size_t> & flag4vertex1 = border_vertices.at(itc->v1);
+		const std::pair<size_t, size_t> & flag4vertex2 = border_vertices.at(itc->v2);
+		ChinesePostman::EdgeWeightType & nearest1 = nearest_chain[flag4vertex1.first][flag4vertex1.second];
+		nearest1 = std::min(nearest1, itc->weight);
+		ChinesePostman::EdgeWeightType & nearest2 = nearest_chain[flag4vertex2.first][flag4vertex2.second];
+		nearest2 = std::min(nearest2, itc->weight);
+	}
+	
+	// 2回通る鎖の距離を両端の連結要素に半分ずつ割り振ると、組み合わせの距離は
+	// 「連結要素ごとの、2回通る辺の距離＋マスクのビットが立つ境界の頂点のnearest_chainの和の半分」の和以上になる。
+	// 端数が出ないよう、これを2倍した値（以下、調整した距離）で比べる
+	auto adjusted = [&](size_t id, const BorderVector & border_vertices, ChinesePostman::EdgeWeightType distance){
+		ChinesePostman::EdgeWeightType result = distance * 2;
+		for(size_t i = 0; i < border_vertices.size(); ++i){
+			if(border_vertices.has(i)) result += nearest_chain[id][i];
+		}
+		return result;
+	};
+	
+	// カット用の辺の鎖を、CutCombinerの辺とする（鎖を1本の辺として扱う）。
+	// component_costsには、連結要素ごとに、求めたマスクでの2回通る辺の距離を格納していく
+	typedef ChinesePostman::BasicCutCombiner<MaskType> CutCombiner;
+	std::vector<typename CutCombiner::CostTable> component_costs(division_result.size());
+	std::vector<typename CutCombiner::CutEdge> combiner_edges;
+	size_t num_cut_edges = 0;
+	for(size_t i = 0; i < cut_chains.size(); ++i){
+		const std::pair<size_t, size_t> & flag4vertex1 = border_vertices.at(cut_chains[i].v1);
+		const std::pair<size_t, size_t> & flag4vertex2 = border_vertices.at(cut_chains[i].v2);
+		combiner_edges.push_back(typename CutCombiner::CutEdge(flag4vertex1.first, flag4vertex1.second, flag4vertex2.first, flag4vertex2.second, cut_chains[i].weight));
+		num_cut_edges += cut_chains[i].edges.size();
+	}
+	
+#ifdef CHINESE_POSTMAN_USE_GLPK
+	glp_term_out(instrumentation != NULL && instrumentation->showing_progress() ? GLP_ON : GLP_OFF);
+#endif // CHINESE_POSTMAN_USE_GLPK
+	
+	// ---------- すべてのborder_vertices_subgraph「の部分集合」について
+	// 2回通るべき辺を決定する
+	// 連結要素とマスクの組をSOLVE_CHINESE_POSTMAN_MASKS_PER_TASK個ずつの仕事に分け、スレッドプールで並行して求める。
+	// 仕事の分け方はスレッド数によらないので、結果もスレッド数によらない。
+	typedef MaskType VertexMask;
+	struct MaskTask{
+		size_t component_id;
+		VertexMask first_mask, last_mask; // first_mask以上last_mask未満のマスクを調べる
+		std::vector< std::pair< VertexMask, std::deque<ChinesePostman::SubRoute> > > results;
+		size_t memo_hits;
+		size_t infeasible, pruned; // 実現できないので飛ばしたマスクの数、下限によって飛ばしたマスクの数
+		ChinesePostman::EdgeWeightType min_adjusted_bound; // 調べるマスクの、調整した距離の下限の最小値
+	};
+	std::vector<MaskTask> mask_tasks;
+	std::vector<size_t> task_begin(division_result.size() + 1); // 連結要素ごとの仕事の範囲
+	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+		task_begin[graph_component_id] = mask_tasks.size();
+		VertexMask num_masks = 1;
+		num_masks <<= border[graph_component_id].size();
+		for(VertexMask first = 0; first < num_masks; first += SOLVE_CHINESE_POSTMAN_MASKS_PER_TASK){
+			MaskTask task;
+			task.component_id = graph_component_id;
+			task.first_mask = first;
+			task.last_mask = (first + SOLVE_CHINESE_POSTMAN_MASKS_PER_TASK < num_masks ? VertexMask(first + SOLVE_CHINESE_POSTMAN_MASKS_PER_TASK) : num_masks);
+			task.memo_hits = 0;
+			task.infeasible = 0;
+			task.pruned = 0;
+			task.min_adjusted_bound = std::numeric_limits<ChinesePostman::EdgeWeightType>::max();
+			mask_tasks.push_back(task);
+		}
+	}
+	task_begin[division_result.size()] = mask_tasks.size();
+	
+	ChinesePostman::count(instrumentation, "mask_tasks", static_cast<long long>(mask_tasks.size()));
+	
+	// 最初に、ビットが2つ以下しか立たないマスクを求め、それらをCutCombinerで組み合わせたものを暫定解とする
+	// （それらのマスクでの距離は、BorderMaskBoundの下限の基準にも用いる）。
+	// 残りのマスクは、最小マッチングを求める前に、次のものを飛ばす。
+	// ・奇数次の頂点が奇数個になり、実現できないもの
+	// ・このマスクの調整した距離の下限と、ほかの連結要素の調整した距離の最小値（の下限）の和が、
+	// 　暫定解の2倍以上になり、暫定解より短くなりえないもの
+	// 飛ばしたマスクはCutCombinerで実現不可能なものとして扱われるが、暫定解の組み合わせは必ず残るので最小の距離は変わらない。
+	// 境界の頂点が少ない連結要素から順に求め、求め終えた連結要素については、下限の代わりに
+	// 飛ばさなかったマスクでの調整した距離の最小値を使う
+	// （最初に飛ばされたマスクを含む組み合わせを考えれば、飛ばされたマスクを含む組み合わせはどれも暫定解より短くならない）。
+	// 連結要素を1つ求め終えるごとに、それまでに求めたマスクをCutCombinerで組み合わせ直して暫定解を更新する。
+	ChinesePostman::EdgeWeightType incumbent = std::numeric_limits<ChinesePostman::EdgeWeightType>::max();
+	bool incumbent_found = false;
+	auto update_incumbent = [&](){
+		CutCombiner partial_combiner(component_costs, combiner_edges);
+		if(!partial_combiner.solve() || partial_combiner.best_distance() >= incumbent) return;
+		incumbent = partial_combiner.best_distance();
+		incumbent_found = true;
+		if(instrumentation != NULL && instrumentation->showing_progress()){
+			std::ostringstream message;
+			message << "  Incumbent: " << incumbent;
+			instrumentation->progress(message.str());
+		}
+	};
+	std::vector<ChinesePostman::EdgeWeightType> min_adjusted(division_result.size(), std::numeric_limits<ChinesePostman::EdgeWeightType>::max());
+	{
+		ChinesePostman::ScopedPhase phase(instrumentation, "matching");
+		
+		// ビットが2つ以下しか立たないマスク
+		std::vector< std::pair<size_t, VertexMask> > seeds;
+		for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+			BorderVector border_of_component = border[graph_component_id];
+			auto add_seed = [&](VertexMask mask){
+				border_of_component.set_mask(mask);
+				if(bounds[graph_component_id]->feasible(border_of_component)) seeds.push_back(std::make_pair(graph_component_id, mask));
+			};
+			auto single_bit = [](size_t i){
+				VertexMask result = 1;
+				result <<= i;
+				return result;
+			};
+			add_seed(VertexMask(0));
+			for(size_t i = 0; i < border_of_component.size(); ++i){
+				add_seed(single_bit(i));
+				for(size_t j = i + 1; j < border_of_component.size(); ++j) add_seed(single_bit(i) | single_bit(j));
+			}
+		}
+		std::vector< std::deque<ChinesePostman::SubRoute> > seed_results(seeds.size());
+		std::vector<unsigned char> seed_found(seeds.size(), 0);
+		ChinesePostman::parallel_for(seeds.size(), matching_options.effective_num_threads(), [&](size_t k){
+			BorderVector border_of_seed = border[seeds[k].first];
+			border_of_seed.set_mask(seeds[k].second);
+			seed_found[k] = (division_result[seeds[k].first].find_doubled_edges(distance_tables[seeds[k].first], seed_results[k], border_of_seed, border_vertices_count, matching_options) ? 1 : 0);
+		});
+		for(size_t k = 0; k < seeds.size(); ++k){
+			if(!seed_found[k]) continue;
+			size_t id = seeds[k].first;
+			ChinesePostman::EdgeWeightType distance = sum_of_distance(seed_results[k]);
+			doubling_result[id][seeds[k].second].swap(seed_results[k]);
+			component_costs[id][seeds[k].second] = distance;
+			BorderVector border_of_seed = border[id];
+			border_of_seed.set_mask(seeds[k].second);
+			bounds[id]->add_reference(border_of_seed, distance);
+			ChinesePostman::count(instrumentation, "masks_solved");
+		}
+		update_incumbent();
+		
+		// 連結要素ごとの、調整した距離の下限の最小値
+		ChinesePostman::parallel_for(mask_tasks.size(), matching_options.num_threads, [&](size_t task_id){
+			MaskTask & task = mask_tasks[task_id];
+			BorderVector border_of_task = border[task.component_id];
+			for(VertexMask mask = task.first_mask; mask < task.last_mask; ++mask){
+				border_of_task.set_mask(mask);
+				if(!bounds[task.component_id]->feasible(border_of_task)) continue;
+				task.min_adjusted_bound = std::min(task.min_adjusted_bound, adjusted(task.component_id, border_of_task, bounds[task.component_id]->lower_bound(border_of_task)));
+			}
+		});
+		for(typename std::vector<MaskTask>::const_iterator itt = mask_tasks.begin(); itt != mask_tasks.end(); ++itt){
+			min_adjusted[itt->component_id] = std::min(min_adjusted[itt->component_id], itt->min_adjusted_bound);
+		}
+		
+		std::vector<size_t> component_order(division_result.size());
+		for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id) component_order[graph_component_id] = graph_component_id;
+		std::stable_sort(component_order.begin(), component_order.end(), [&](size_t c1, size_t c2){ return border[c1].size() < border[c2].size(); });
+		
+		// すべての連結要素の調整した距離の最小値（の下限）の和。
+		// 暫定解が見つかった時点で一度だけ求め、以後は連結要素を求め終えるごとに差分だけ更新する
+		// （暫定解があれば、どの連結要素にも実現できるマスクがあるので、どの値も有限）
+		ChinesePostman::EdgeWeightType min_adjusted_sum = 0;
+		bool min_adjusted_summed = false;
+		for(std::vector<size_t>::const_iterator itc = component_order.begin(); itc != component_order.end(); ++itc){
+			const size_t id = *itc;
+			if(incumbent_found && !min_adjusted_summed){
+				for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+					min_adjusted_sum += min_adjusted[graph_component_id];
+				}
+				min_adjusted_summed = true;
+			}
+			// ほかの連結要素の調整した距離の最小値（の下限）の和
+			ChinesePostman::EdgeWeightType others = (min_adjusted_summed ? min_adjusted_sum - min_adjusted[id] : 0);
+			
+			ChinesePostman::parallel_for(task_begin[id + 1] - task_begin[id], matching_options.effective_num_threads(), [&](size_t k){
+				MaskTask & task = mask_tasks[task_begin[id] + k];
+				const ChinesePostman::RouteNetwork & component = division_result[id];
+				const MaskBound & bound = *bounds[id];
+				BorderVector border_of_task = border[id];
+				
+				// 奇数次の頂点の集合が同じになるマスクについては、一度求めた結果を使い回す
+				ChinesePostman::MatchingMemo matching_memo;
+				
+				for(VertexMask mask = task.first_mask; mask < task.last_mask; ++mask){
+					if(doubling_result[id].count(mask) != 0) continue; // 最初に求めた
+					border_of_task.set_mask(mask);
+					if(!bound.feasible(border_of_task)){
+						++task.infeasible;
+						continue;
+					}
+					if(incumbent_found && adjusted(id, border_of_task, bound.lower_bound(border_of_task)) + others >= incumbent * 2){
+						++task.pruned;
+						continue;
+					}
+					if(ChinesePostman::dumping(instrumentation)){
+						std::ostringstream text;
+						text << "    Border nodes visited for even-number times (mask: " << border_of_task.mask() << ", size: " << border_of_task.size() << ")";
+						for(size_t i = 0; i < border_of_task.size(); ++i){
+							if(border_of_task.has(i)){
+								text << " " << component.vertexname(border_of_task[i]);
+							}
+						}
+						text << std::endl;
+						instrumentation->dump(text.str());
+					}
+					
+					// 組み合わせを求める
+					std::deque<ChinesePostman::SubRoute> result;
+					if(component.find_doubled_edges(distance_tables[id], result, border_of_task, border_vertices_count, matching_options, &matching_memo)){
+						task.results.push_back(std::make_pair(mask, std::deque<ChinesePostman::SubRoute>()));
+						task.results.back().second.swap(result);
+					}
+				}
+				task.memo_hits = matching_memo.hits;
+			});
+			
+			// 仕事の順（マスクの順）に結果をまとめ、調整した距離の最小値を求める
+			bool solved_any = false;
+			for(size_t t = task_begin[id]; t < task_begin[id + 1]; ++t){
+				for(typename std::vector< std::pair< VertexMask, std::deque<ChinesePostman::SubRoute> > >::iterator itr = mask_tasks[t].results.begin(); itr != mask_tasks[t].results.end(); ++itr){
+					component_costs[id][itr->first] = sum_of_distance(itr->second);
+					doubling_result[id][itr->first].swap(itr->second);
+					solved_any = true;
+				}
+			}
+			BorderVector border_of_component = border[id];
+			if(min_adjusted_summed) min_adjusted_sum -= min_adjusted[id];
+			min_adjusted[id] = std::numeric_limits<ChinesePostman::EdgeWeightType>::max();
+			for(typename ChinesePostman::BasicCutCombiner<MaskType>::CostTable::const_iterator itr = component_costs[id].begin(); itr != component_costs[id].end(); ++itr){
+				border_of_component.set_mask(itr->first);
+				min_adjusted[id] = std::min(min_adjusted[id], adjusted(id, border_of_component, itr->second));
+			}
+			if(min_adjusted_summed) min_adjusted_sum += min_adjusted[id];
+			
+			if(solved_any && itc + 1 != component_order.end()) update_incumbent();
+		}
+	}
+	
+	std::vector<size_t> memo_hits(division_result.size(), 0);
+	for(typename std::vector<MaskTask>::iterator itt = mask_tasks.begin(); itt != mask_tasks.end(); ++itt){
+		memo_hits[itt->component_id] += itt->memo_hits;
+		ChinesePostman::count(instrumentation, "masks_solved", static_cast<long long>(itt->results.size()));
+		ChinesePostman::count(instrumentation, "masks_infeasible", static_cast<long long>(itt->infeasible));
+		ChinesePostman::count(instrumentation, "masks_pruned", static_cast<long long>(itt->pruned));
+	}
+	if(instrumentation != NULL && instrumentation->showing_progress()){
+		for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+			std::ostringstream message;
+			message << "  Component " << (graph_component_id+1) << ": matchings reused: " << memo_hits[graph_component_id] << " / " << doubling_result[graph_component_id].size();
+			instrumentation->progress(message.str());
+		}
+	}
+	
+	// カット用の辺の鎖を1回通る/2回通るという組み合わせのうち、
+	// 各部分の距離と合わせて最小になるものを求める（CutCombiner.hppを参照）
+	std::cerr << "Combining " << division_result.size() << " component(s) with " << combiner_edges.size() << " chain(s) of " << num_cut_edges << " cut edge(s)" << std::endl;
+	CutCombiner combiner(component_costs, combiner_edges);
+	{
+		ChinesePostman::ScopedPhase phase(instrumentation, "combining");
+		if(!combiner.solve()){
+			std::cerr << "ERROR: No feasible combination of doubled cut edges" << std::endl;
+			return 1;
+		}
+	}
+	ChinesePostman::count(instrumentation, "combiner_max_states", static_cast<long long>(combiner.max_states()));
+	
+	ChinesePostman::EdgeWeightType best_distance = combiner.best_distance();
+	std::vector<const std::deque<ChinesePostman::SubRoute> *> best_doubling_result(division_result.size());
+	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+		best_doubling_result[graph_component_id] = &(doubling_result[graph_component_id][combiner.component_masks()[graph_component_id]]);
+	}
+	
+	ChinesePostman::EdgeWeightType bridge_distance = 0;
+	if(bridges != NULL){
+		for(std::vector<ChinesePostman::VirtualEdge>::const_iterator itb = bridges->begin(); itb != bridges->end(); ++itb){
+			bridge_distance += itb->weight;
+		}
+	}
+	
+	std::cout << "# ---------- Best Result ----------" << std::endl;
+	std::cout << "# Total distance of all graph edges = " << total_distance << std::endl;
+	if(bridges != NULL){
+		std::cout << "# Total distance of bridge edges = " << bridge_distance << std::endl;
+		std::cout << "# Total distance of doubled edges other than bridge = " << best_distance << std::endl;
+	}
+	std::cout << "# Total distance of doubled edges = " << bridge_distance + best_distance << std::endl;
+	std::cout << "# Total distance of traversed edges = " << total_distance + bridge_distance + best_distance << std::endl;
+	if(bridges != NULL){
+		std::cout << "# Edges traversed twice as bridges" << std::endl;
+		for(std::vector<ChinesePostman::VirtualEdge>::const_iterator itb = bridges->begin(); itb != bridges->end(); ++itb){
+			std::cout << itb->weight << " ";
+			std::cout << rn.names().name(itb->v1) << " ";
+			std::cout << rn.names().name(itb->v2) << std::endl;
+		}
+	}
+	std::cout << "# Edges traversed twice in cuts" << std::endl;
+	for(size_t i = 0; i < cut_chains.size(); ++i){
+		if(!combiner.doubled()[i]) continue;
+		for(std::vector<ChinesePostman::VirtualEdge>::const_iterator ite = cut_chains[i].edges.begin(); ite != cut_chains[i].edges.end(); ++ite){
+			std::cout << ite->weight << " ";
+			std::cout << rn.names().name(ite->v1) << " ";
+			std::cout << rn.names().name(ite->v2) << std::endl;
+		}
+	}
+	
+	for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+		if(boost::num_edges(division_result[graph_component_id]) == 0) continue; // 孤立した駅
+		std::cout << "# Edges traversed twice in component " << (graph_component_id+1) << std::endl;
+		for(std::deque<ChinesePostman::SubRoute>::const_iterator its = best_doubling_result[graph_component_id]->cbegin(); its != best_doubling_result[graph_component_id]->cend(); ++its){
+			std::cout << its->weight << " ";
+			std::cout << rn.names().name(its->v1) << " ";
+			std::cout << rn.names().name(its->v2) << std::endl;
+		}
+	}
+	
+	// ---------- 経路の出力（--tourを指定した場合）
+	// 2回通る辺を元の路線網の辺に展開し、オイラー閉路を1本ずつ出力する。
+	// 橋とカットする辺は読み込んだときに展開したものを、連結要素の2回通る区間は記録した最短経路木を辿って
+	// 縮約した辺の表で展開したものを使う（区間ごとに最短経路を求め直さない）
+	if(tour_routes != NULL){
+		ChinesePostman::ScopedPhase phase(instrumentation, "tour");
+		const ChinesePostman::CompactGraph * tour_network = tour_routes->network;
+		const ChinesePostman::VertexId tour_start = tour_routes->start;
+		ChinesePostman::PostmanTour tour(*tour_network);
+		bool tour_found = tour_routes->expanded;
+		for(std::vector<ChinesePostman::EdgeId>::const_iterator ite = tour_routes->bridge_edges.begin(); ite != tour_routes->bridge_edges.end(); ++ite){
+			tour.add_doubled_edge(*ite);
+		}
+		for(size_t i = 0; i < cut_chains.size(); ++i){
+			if(!combiner.doubled()[i]) continue;
+			for(std::vector<ChinesePostman::VirtualEdge>::const_iterator ite = cut_chains[i].edges.begin(); ite != cut_chains[i].edges.end(); ++ite){
+				std::map< ChinesePostman::VirtualEdge, std::vector<ChinesePostman::EdgeId> >::const_iterator itr = tour_routes->cut_edges.find(ChinesePostman::VirtualEdge(std::min(ite->v1, ite->v2), std::max(ite->v1, ite->v2), ite->weight));
+				if(itr == tour_routes->cut_edges.end()){
+					tour_found = false;
+					continue;
+				}
+				for(std::vector<ChinesePostman::EdgeId>::const_iterator itn = itr->second.begin(); itn != itr->second.end(); ++itn){
+					tour.add_doubled_edge(*itn);
+				}
+			}
+		}
+		std::vector<ChinesePostman::EdgeId> route_edges;
+		for(graph_component_id = 0; graph_component_id < division_result.size(); ++graph_component_id){
+			const ChinesePostman::RouteNetwork & component = division_result[graph_component_id];
+			for(std::deque<ChinesePostman::SubRoute>::const_iterator its = best_doubling_result[graph_component_id]->cbegin(); its != best_doubling_result[graph_component_id]->cend(); ++its){
+				route_edges.clear();
+				bool expanded = true;
+				bool path_found = path_trees[graph_component_id].for_each_path_edge(its->v1, its->v2, [&](ChinesePostman::Graph::vertex_descriptor from, ChinesePostman::Graph::edge_descriptor e, ChinesePostman::Graph::vertex_descriptor){
+					expanded = expand_to_network(component, e, from, *tour_network, route_edges) && expanded;
+				});
+				tour_found = tour_found && path_found && expanded;
+				for(std::vector<ChinesePostman::EdgeId>::const_iterator ite = route_edges.begin(); ite != route_edges.end(); ++ite){
+					tour.add_doubled_edge(*ite);
+				}
+			}
+		}
+		
+		std::cout << "# Tour from " << rn.names().name(tour_start) << std::endl;
+		size_t steps = 0;
+		ChinesePostman::EdgeWeightType tour_distance = 0;
+		tour_found = tour_found && tour.write(tour_start, [&](ChinesePostman::VertexId from, ChinesePostman::EdgeId edge, ChinesePostman::VertexId to){
+			// 経路は長くなりうるので、1行ごとにはflushしない
+			std::cout << tour_network->edge_weight(edge) << " " << rn.names().name(from) << " " << rn.names().name(to) << "\n";
+			tour_distance += tour_network->edge_weight(edge);
+		}, &steps);
+		std::cout.flush();
+		if(!tour_found){
+			std::cerr << "ERROR: Failed to construct the tour" << std::endl;
+			return 1;
+		}
+		std::cout << "# Total distance of the tour = " << tour_distance << std::endl;
+		if(tour_distance != tour.total_distance()){
+			std::cerr << "Warning: The tour covers only the connected component containing \"" << rn.names().name(tour_start) << "\"" << std::endl;
+		}
+	}
+	
+	return 0;
+}
+
+// 路線網（filenames[0]）と、カットする辺の一覧（filenames[1]以降）を読み込んで解き、結果を出力する。
+// divide_by_bridgeが真なら、DivideByBridgeと同じ手順で橋を除去してから解く。
+// auto_cut_verticesが正なら、頂点がその数以下の部分に分かれるようにカットする辺を選んで加える。返り値はmainの返り値
+int solve(const std::vector<const char *> & filenames, const char * tour_start_name, bool divide_by_bridge, size_t auto_cut_vertices, const ChinesePostman::MatchingOptions & matching_options, bool use_floyd_warshall){
+	ChinesePostman::Instrumentation * instrumentation = matching_options.instrumentation;
+	
+	// グラフと駅名の表を共有し、同じ駅が同じ番号になるようにする
+	std::shared_ptr<ChinesePostman::NameTable> names = std::make_shared<ChinesePostman::NameTable>();
+	ChinesePostman::RouteNetwork rn;
+	// 辺を除去する前の路線網（経路の出力と、バイナリ形式のファイルに記録された橋の参照に使う）
+	ChinesePostman::CompactGraph network;
+	std::multiset<ChinesePostman::VirtualEdge> cut;
+	ChinesePostman::EdgeWeightType total_distance;
+	{
+		ChinesePostman::ScopedPhase phase(instrumentation, "read");
+		
+		// ---------- グラフ（バイナリ形式のファイルなら、その駅名の表をそのまま共有する）
+		total_distance = ChinesePostman::read_from(filenames[0], rn, names, (tour_start_name != NULL || divide_by_bridge ? &network : NULL));
+		if(total_distance == 0){
+			std::cerr << "Error: When reading \"" << filenames[0] << "\"" << std::endl;
+			return 1;
+		}
+		
+		// ---------- カットする辺の一覧（複数のファイルで与えた場合は、すべての辺をカットする）
+		for(size_t i = 1; i < filenames.size(); ++i){
+			ChinesePostman::EdgeWeightType cut_distance = read_cut_edges(filenames[i], *names, cut);
+			if(cut_distance == 0){
+				std::cerr << "Error: When reading \"" << filenames[i] << "\"" << std::endl;
+				return 1;
+			}
+		}
+	}
+	
+	// ---------- 経路を出力する場合は、辺を除去する前の路線網を使う
+	// （除去する辺は、除去する前にその路線網の辺に展開しておく）
+	std::unique_ptr<TourRoutes> tour_routes;
+	if(tour_start_name != NULL){
+		ChinesePostman::VertexId tour_start;
+		if(!names->find(boost::string_ref(tour_start_name), tour_start)){
+			std::cerr << "Error: Station \"" << tour_start_name << "\" not found" << std::endl;
+			return 1;
+		}
+		tour_routes.reset(new TourRoutes(&network, tour_start));
+	}
+	
+	// ---------- 橋で分割する場合（--divide-by-bridge）は、DivideByBridgeと同じく
+	// 次数2の頂点を除去し、橋を2回通る辺として除去してから、もう一度次数2の頂点を除去する。
+	// 橋を除いた各部分は、以下で連結要素として（カットする辺があればそれで更に分割して）まとめて解く。
+	// カットする辺は、DivideByBridgeが出力する各部分（subgraph-*.edges）の辺で指定する
+	std::vector<ChinesePostman::VirtualEdge> bridges;
+	if(divide_by_bridge){
+		ChinesePostman::ScopedPhase phase(instrumentation, "bridges");
+		rn.remove_trivial_vertices();
+		ChinesePostman::BridgeDetector bd(rn, network);
+		for(std::vector<ChinesePostman::Graph::edge_descriptor>::const_iterator ite = bd.result().begin(); ite != bd.result().end(); ++ite){
+			bridges.push_back(ChinesePostman::VirtualEdge(rn.vertexid(boost::source(*ite, rn)), rn.vertexid(boost::target(*ite, rn)), rn.edgeweight(*ite)));
+			if(tour_routes && !expand_to_network(rn, *ite, boost::source(*ite, rn), network, tour_routes->bridge_edges)) tour_routes->expanded = false;
+			boost::remove_edge(*ite, rn);
+		}
+		rn.remove_trivial_vertices();
+	}
+	ChinesePostman::count(instrumentation, "bridges", static_cast<long long>(bridges.size()));
+	
+	// ---------- カットする辺を自動で選ぶ場合（--auto-cut）は、この時点の路線網
+	// （--divide-by-bridgeなら次数2の頂点を除去したもの）を、頂点がauto_cut_vertices個以下の部分に分ける。
+	// 両端と距離が同じ辺（並行する辺）は、選ばれた本数だけ加える。カットする辺の一覧に既にある辺は、
+	// 一覧にある本数の分だけ重ねて加えない
+	if(auto_cut_vertices != 0){
+		ChinesePostman::ScopedPhase phase(instrumentation, "auto_cut");
+		ChinesePostman::CompactGraph compact;
+		rn.to_compact_graph(compact);
+		std::vector<size_t> part;
+		size_t num_parts = ChinesePostman::partition_graph(compact, auto_cut_vertices, part);
+		std::vector<ChinesePostman::EdgeId> auto_cut_edges;
+		ChinesePostman::partition_cut_edges(compact, part, auto_cut_edges);
+		std::multiset<ChinesePostman::VirtualEdge> selected;
+		for(std::vector<ChinesePostman::EdgeId>::const_iterator ite = auto_cut_edges.begin(); ite != auto_cut_edges.end(); ++ite){
+			ChinesePostman::VertexId v1 = compact.edge_source(*ite), v2 = compact.edge_target(*ite);
+			selected.insert(ChinesePostman::VirtualEdge(std::min(v1, v2), std::max(v1, v2), compact.edge_weight(*ite)));
+		}
+		for(std::multiset<ChinesePostman::VirtualEdge>::const_iterator ite = selected.begin(); ite != selected.end(); ite = selected.upper_bound(*ite)){
+			for(size_t k = cut.count(*ite); k < selected.count(*ite); ++k) cut.insert(*ite);
+		}
+		
+		size_t max_border_vertices = 0;
+		if(num_parts > 0){
+			std::vector<size_t> border_vertices;
+			ChinesePostman::partition_border_vertices(compact, part, num_parts, border_vertices);
+			max_border_vertices = *std::max_element(border_vertices.begin(), border_vertices.end());
+		}
+		std::cerr << "Selected " << auto_cut_edges.size() << " cutting edge(s) automatically into " << num_parts << " part(s) (max border vertices per part: " << max_border_vertices << ")" << std::endl;
+		if(max_border_vertices > ChinesePostman::max_recommended_border_vertices()){
+			std::cerr << "Warning: A part has more than " << ChinesePostman::max_recommended_border_vertices() << " border vertices; solving it may take very long (try a larger --auto-cut)" << std::endl;
+		}
+	}
+	
+	// ---------- 「カットする辺の一覧」にある辺を除去するとともに、除去された辺に接する頂点を列挙する
+	std::pair<ChinesePostman::Graph::edge_iterator, ChinesePostman::Graph::edge_iterator> edge_range = boost::edges(rn);
+	std::vector<ChinesePostman::Graph::edge_descriptor> removed_edges_later_rn;
+	
+	// border_verticesの
+	// キー：頂点（駅名の表での番号。分割後のグラフでも同じ）
+	// 値のfirst：当該頂点が分割後のグラフのいくつめに属しているか（後ほど指定）
+	// 値のsecond：当該頂点がborder_vertices_subの何番目の要素であるか（後ほど指定）
+	std::map< ChinesePostman::VertexId, std::pair<size_t, size_t> > border_vertices;
+	
+	// カットする辺の鎖の端として頂点が何度出現しているか
+	// （border_vertices_countは分割後のグラフの頂点、border_vertices_count_tmpは駅名の表での番号がキー）
+	std::map< ChinesePostman::Graph::vertex_descriptor, size_t > border_vertices_count;
+	std::map< ChinesePostman::VertexId, size_t > border_vertices_count_tmp;
+	
+	std::multiset<ChinesePostman::VirtualEdge> border_edges;
+	std::vector<CutChain> cut_chains;
+	
+	{
+		ChinesePostman::ScopedPhase phase(instrumentation, "cut_edges");
+		std::vector<size_t> degree(names->size(), 0); // カットする前の次数
+		for(ChinesePostman::Graph::edge_iterator ite = edge_range.first; ite != edge_range.second; ++ite){
+			ChinesePostman::VertexId v1, v2;
+			v1 = rn.vertexid(boost::source(*ite, rn));
+			v2 = rn.vertexid(boost::target(*ite, rn));
+			++degree[v1];
+			++degree[v2];
+			std::multiset<ChinesePostman::VirtualEdge>::iterator itc = cut.find(ChinesePostman::VirtualEdge(std::min(v1, v2), std::max(v1, v2), rn.edgeweight(*ite)));
+			if(itc == cut.end()) continue;
+			
+			cut.erase(itc);
+			removed_edges_later_rn.push_back(*ite);
+			if(tour_routes){
+				std::vector<ChinesePostman::EdgeId> & cut_route = tour_routes->cut_edges[ChinesePostman::VirtualEdge(std::min(v1, v2), std::max(v1, v2), rn.edgeweight(*ite))];
+				if(cut_route.empty() && !expand_to_network(rn, *ite, boost::source(*ite, rn), network, cut_route)) tour_routes->expanded = false;
+			}
+			border_edges.insert(ChinesePostman::VirtualEdge(v1, v2, rn.edgeweight(*ite)));
+		}
+		
+		if(!cut.empty()){
+			std::cerr << "ERROR: Cutting edge not found - " << names->name(cut.begin()->v1) << ", " << names->name(cut.begin()->v2) << std::endl;
+			return 1;
+		}
+		
+		for(std::vector<ChinesePostman::Graph::edge_descriptor>::iterator ite = removed_edges_later_rn.begin(); ite != removed_edges_later_rn.end(); ++ite){
+			boost::remove_edge(*ite, rn);
+		}
+		
+		// カットする辺を鎖にまとめ、鎖の両端だけを境界の頂点とする
+		// （鎖の途中の頂点は、カットした後は孤立した頂点になる）
+		group_cut_chains(std::vector<ChinesePostman::VirtualEdge>(border_edges.begin(), border_edges.end()), degree, cut_chains);
+		for(std::vector<CutChain>::const_iterator itc = cut_chains.begin(); itc != cut_chains.end(); ++itc){
+			border_vertices.insert(std::make_pair(itc->v1, std::make_pair(-1, -1)));
+			border_vertices.insert(std::make_pair(itc->v2, std::make_pair(-1, -1)));
+			border_vertices_count_tmp[itc->v1] += 1;
+			border_vertices_count_tmp[itc->v2] += 1;
+		}
+	}
+	ChinesePostman::count(instrumentation, "cut_edges", static_cast<long long>(border_edges.size()));
+	ChinesePostman::count(instrumentation, "cut_chains", static_cast<long long>(cut_chains.size()));
+	
+	// ---------- 連結要素に分割
+	ChinesePostman::RouteNetworkList division_result;
+	{
+		ChinesePostman::ScopedPhase phase(instrumentation, "components");
+		rn.connectedcomponents(division_result);
+	}
+	ChinesePostman::count(instrumentation, "components", static_cast<long long>(division_result.size()));
+	
+	// ---------- 連結要素のそれぞれについて、2回通る頂点を決定する
+	// ただしこのとき、境界の頂点は奇数回通るか偶数回通るかで場合わけする必要がある
+	// すなわち、（2^[境界の頂点数]）通りを試す必要がある
+	// フラグが立っていれば「境界側から当該駅を利用する回数は偶数回」
+	// そうでなければ奇数回
+	
+	// border_vertices_sub[i]は、i番目の連結要素（分割後のグラフ）上での境界の頂点の列
+	std::vector< std::vector<ChinesePostman::Graph::vertex_descriptor> > border_vertices_sub(division_result.size());
+	size_t max_border_vertices = 0;
+	
+	size_t graph_component_id;
+	
+	graph_component_id = 0;
+	for(ChinesePostman::RouteNetworkList::iterator itg = division_result.begin(); itg != division_result.end(); ++itg){
+		std::pair<ChinesePostman::Graph::vertex_iterator, ChinesePostman::Graph::vertex_iterator> vertex_range = boost::vertices(*itg);
+		if(boost::num_edges(*itg) != 0){
+			// 辺のない連結要素（橋などを除去して孤立した駅）は表示しない
+			std::cerr << "Computing the graph of Stations[0] = \"" << (vertex_range.first == vertex_range.second ? boost::string_ref("<none>") : itg->vertexname(*vertex_range.first)) << "\", ";
+			std::cerr << "Stations.size = " << boost::num_vertices(*itg) << ", ";
+			std::cerr << "Edges.size = " << boost::num_edges(*itg) << std::endl;
+		}
+		
+		// border_vertices_subgraphは
+		// 駅名の表での番号をキー、分割後のグラフ（*itg）上での頂点を値とする
+		// 連想配列で、分割境界上に位置しているもののみ集めたもの
+		std::map<ChinesePostman::VertexId, ChinesePostman::Graph::vertex_descriptor> border_vertices_subgraph;
+		
+		for(ChinesePostman::Graph::vertex_iterator itv = vertex_range.first; itv != vertex_range.second; ++itv){
+			std::map< ChinesePostman::VertexId, std::pair<size_t, size_t> >::iterator itvb = border_vertices.find(itg->vertexid(*itv));
+			if(itvb != border_vertices.end()){
+				itvb->second.first = graph_component_id;
+				border_vertices_subgraph[itvb->first] = *itv;
+				border_vertices_count[*itv] = border_vertices_count_tmp[itvb->first];
+			}
+		}
+		
+		// 番号付けしてborder_vertices_subに格納する
+		size_t count = 0;
+		for(std::map<ChinesePostman::VertexId, ChinesePostman::Graph::vertex_descriptor>::iterator itv = border_vertices_subgraph.begin(); itv != border_vertices_subgraph.end(); ++itv){
+			border_vertices[itv->first].second = count;
+			++count;
+			border_vertices_sub[graph_component_id].push_back(itv->second);
+		}
+		max_border_vertices = std::max(max_border_vertices, count);
+		
+		++graph_component_id;
+	}
+	
+	// 境界の頂点のマスクは、どの連結要素でも境界の頂点が64個未満なら64ビット整数で、
+	// そうでなければ多倍長整数で表す
+	ChinesePostman::count(instrumentation, "max_border_vertices", static_cast<long long>(max_border_vertices));
+	if(max_border_vertices < 64){
+		return solve_divided<boost::uint64_t>(rn, division_result, border_vertices_sub, border_vertices, border_vertices_count, cut_chains, (divide_by_bridge ? &bridges : NULL), matching_options, use_floyd_warshall, total_distance, tour_routes.get());
+	}else{
+		return solve_divided<boost::multiprecision::cpp_int>(rn, division_result, border_vertices_sub, border_vertices, border_vertices_count, cut_chains, (divide_by_bridge ? &bridges : NULL), matching_options, use_floyd_warshall, total_distance, tour_routes.get());
+	}
+}
+
+int main(int argc, char ** argv){
+	// ---------- オプションの解釈
+	// --glpk : 最小マッチングをGLPK（整数計画法）で求める（検算用）
+	// --neighbors K : 最小マッチングの候補を、各頂点から近いK個の頂点との組に絞る（0なら絞らない）
+	// --floyd-warshall : 最短距離を全頂点対についてFloyd-Warshall法で求める（検算用）
+	// --threads N : 連結要素やマスクごとの計算をNスレッドで並行して行う（0ならCPUのコア数）
+	// --tour STATION : 駅STATIONから出発してSTATIONに戻る経路を、通る順に出力する
+	// --divide-by-bridge : DivideByBridgeと同じく橋で分割し、各部分をまとめて解く
+	//                      （CUT_FILENAMEには、DivideByBridgeが出力する各部分の辺を指定する）
+	// --auto-cut N : 頂点がN個以下の部分に分かれるように、カットする辺を自動で選ぶ
+	//                （--divide-by-bridgeと合わせて指定すると、次数2の頂点を除去した路線網で選ぶ）
+	// --progress : 各段階の開始と終了を、経過時間とともに標準エラー出力に表示する
+	// --dump : 途中の計算結果の詳細を標準エラー出力に表示する
+	// --report FILE : 段階ごとの時間と、奇数次の頂点の数などのカウンタをFILEに書き出す
+	//                 （FILEの名前が.csvで終わればCSV、そうでなければJSON）
+	std::vector<const char *> filenames;
+	const char * tour_start_name = NULL;
+	const char * report_filename = NULL;
+	bool divide_by_bridge = false;
+	size_t auto_cut_vertices = 0;
+	bool show_progress = false, dump = false;
+	ChinesePostman::MatchingOptions matching_options;
+	bool use_floyd_warshall = false;
+	for(int i = 1; i < argc; ++i){
+		std::string arg(argv[i]);
+		if(arg == "--floyd-warshall"){
+			use_floyd_warshall = true;
+		}else if(arg == "--neighbors" && i + 1 < argc){
+			matching_options.candidate_neighbors = std::strtoul(argv[++i], NULL, 10);
+		}else if(arg == "--threads" && i + 1 < argc){
+			matching_options.num_threads = std::strtoul(argv[++i], NULL, 10);
+		}else if(arg == "--tour" && i + 1 < argc){
+			tour_start_name = argv[++i];
+		}else if(arg == "--divide-by-bridge"){
+			divide_by_bridge = true;
+		}else if(arg == "--auto-cut" && i + 1 < argc){
+			auto_cut_vertices = std::strtoul(argv[++i], NULL, 10);
+			if(auto_cut_vertices == 0){
+				std::cerr << "Error: The argument of --auto-cut must be a positive integer" << std::endl;
+				return 1;
+			}
+		}else if(arg == "--progress"){
+			show_progress = true;
+		}else if(arg == "--dump"){
+			dump = true;
+		}else if(arg == "--report" && i + 1 < argc){
+			report_filename = argv[++i];
+		}else if(arg == "--glpk"){
+#ifdef CHINESE_POSTMAN_USE_GLPK
+			matching_options.backend = ChinesePostman::MATCHING_GLPK;
+#else
+			std::cerr << "Error: GLPK support is not compiled in (rebuild with USE_GLPK=1)" << std::endl;
+			return 1;
+#endif // CHINESE_POSTMAN_USE_GLPK
+		}else if(arg.compare(0, 2, "--") == 0){
+			std::cerr << "Error: Unknown option \"" << arg << "\"" << std::endl;
+			return 1;
+		}else{
+			filenames.push_back(argv[i]);
+		}
+	}
+	
+	if(filenames.size() < 1){
+		std::cerr << "Usage: " << argv[0] << " [--glpk] [--neighbors K] [--floyd-warshall] [--threads N] [--tour STATION] [--divide-by-bridge] [--auto-cut N] [--progress] [--dump] [--report FILE] GRAPH_FILENAME (CUT_FILENAME ...)" << std::endl;
+		return 1;
+	}
+	
+	// ---------- 計測（どれも指定しなければ計測しない）
+	std::unique_ptr<ChinesePostman::Instrumentation> instrumentation;
+	if(show_progress || dump || report_filename != NULL){
+		instrumentation.reset(new ChinesePostman::Instrumentation());
+		if(show_progress) instrumentation->set_progress_stream(&std::cerr);
+		if(dump) instrumentation->set_dump_stream(&std::cerr);
+		matching_options.instrumentation = instrumentation.get();
+	}
+	
+	int result = solve(filenames, tour_start_name, divide_by_bridge, auto_cut_vertices, matching_options, use_floyd_warshall);
+	
+	if(report_filename != NULL && !instrumentation->write(report_filename)){
+		std::cerr << "Error: When writing \"" << report_filename << "\"" << std::endl;
+		return 1;
+	}
+	return result;
+}
@@ -0,0 +1,232 @@
+#ifndef SYNTHETIC_NETWORK_HPP_
+#define SYNTHETIC_NETWORK_HPP_
+
+#include "ChinesePostmanUtil.hpp"
+#include <random>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <ostream>
+#include <cmath>
+
+namespace ChinesePostman{
+	// 合成グラフの形
+	enum SyntheticShape{
+		SYNTHETIC_GRID, // 格子
+		SYNTHETIC_PLANAR, // 頂点の位置をずらした格子に、ランダムに対角線を加えた平面グラフ
+		SYNTHETIC_CYCLES // 輪を木の形につなげたもの（次数2の頂点が続く、路線網に近い形）
+	};
+	
+	struct SyntheticOptions{
+		SyntheticShape shape;
+		
+		// 盲腸線（橋）を除いた部分の頂点の数の目安
+		size_t num_vertices;
+		
+		// 辺のうち、橋（盲腸線の辺）が占める割合の目安（0以上1未満）
+		double bridge_ratio;
+		
+		// 奇数次の頂点の数（負なら調整しない）。
+		// 奇数次の頂点の数は必ず偶数なので、奇数を与えた場合は1つ少なくなる。
+		// 盲腸線の終点は必ず奇数次なので、それより少なくはできない。
+		long num_odd_vertices;
+		
+		unsigned int seed;
+		
+		SyntheticOptions(SyntheticShape sshape = SYNTHETIC_GRID, size_t nnum_vertices = 10000, double bbridge_ratio = 0.1, long nnum_odd_vertices = -1, unsigned int sseed = 1)
+		: shape(sshape), num_vertices(nnum_vertices), bridge_ratio(bbridge_ratio), num_odd_vertices(nnum_odd_vertices), seed(sseed) {}
+	};
+	
+	// ベンチマーク用に、路線網に似た合成グラフを作る。
+	// 乱数はstd::mt19937の出力だけを用いる（分布のクラスは処理系によって結果が異なるので使わない）ので、
+	// 同じSyntheticOptionsからは、処理系によらず同じグラフができる。
+	// 頂点の番号は0から順に振り、駅名はvertex_nameで得る。
+	class SyntheticNetwork{
+	private:
+		std::mt19937 random_;
+		std::vector<VirtualEdge> edges_;
+		std::vector<size_t> degree_;
+		size_t num_core_vertices_; // 盲腸線以外の頂点の数（番号は0からnum_core_vertices_-1）
+		size_t num_bridges_;
+		
+		inline size_t random_below(size_t n){
+			return static_cast<size_t>(random_()) % n;
+		}
+		inline EdgeWeightType random_weight(EdgeWeightType min_weight, EdgeWeightType max_weight){
+			return min_weight + static_cast<EdgeWeightType>(random_below(static_cast<size_t>(max_weight - min_weight + 1)));
+		}
+		
+		VertexId add_vertex(){
+			degree_.push_back(0);
+			return static_cast<VertexId>(degree_.size() - 1);
+		}
+		void add_edge(VertexId v1, VertexId v2, EdgeWeightType weight){
+			edges_.push_back(VirtualEdge(v1, v2, weight));
+			++degree_[v1];
+			++degree_[v2];
+		}
+		
+		// 格子を作る。planarなら頂点の位置をずらし、距離を位置から求め、各マスに確率1/2で対角線を加える
+		void make_grid(size_t num_vertices, bool planar){
+			size_t width = std::max<size_t>(2, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_vertices)))));
+			size_t height = std::max<size_t>(2, (num_vertices + width - 1) / width);
+			std::vector<double> px(width * height), py(width * height);
+			for(size_t y = 0; y < height; ++y){
+				for(size_t x = 0; x < width; ++x){
+					VertexId v = add_vertex();
+					px[v] = x * 100.0 + (planar ? static_cast<double>(random_below(61)) - 30.0 : 0.0);
+					py[v] = y * 100.0 + (planar ? static_cast<double>(random_below(61)) - 30.0 : 0.0);
+				}
+			}
+			
+			auto connect = [&](VertexId v1, VertexId v2){
+				if(planar){
+					double dx = px[v1] - px[v2], dy = py[v1] - py[v2];
+					add_edge(v1, v2, std::max<EdgeWeightType>(1, static_cast<EdgeWeightType>(std::sqrt(dx * dx + dy * dy) + 0.5)));
+				}else{
+					add_edge(v1, v2, random_weight(10, 100));
+				}
+			};
+			for(size_t y = 0; y < height; ++y){
+				for(size_t x = 0; x < width; ++x){
+					VertexId v = static_cast<VertexId>(y * width + x);
+					if(x + 1 < width) connect(v, v + 1);
+					if(y + 1 < height) connect(v, static_cast<VertexId>(v + width));
+					if(planar && x + 1 < width && y + 1 < height && random_below(2) == 0){
+						if(random_below(2) == 0){
+							connect(v, static_cast<VertexId>(v + width + 1));
+						}else{
+							connect(v + 1, static_cast<VertexId>(v + width));
+						}
+					}
+				}
+			}
+		}
+		
+		// 3から12頂点の輪を、既存の頂点を1つ共有させながら次々につなげる
+		void make_cycles(size_t num_vertices){
+			while(degree_.size() < num_vertices){
+				size_t length = 3 + random_below(10);
+				VertexId first = (degree_.empty() ? add_vertex() : static_cast<VertexId>(random_below(degree_.size())));
+				VertexId prev = first;
+				for(size_t i = 1; i < length; ++i){
+					VertexId v = add_vertex();
+					add_edge(prev, v, random_weight(10, 100));
+					prev = v;
+				}
+				add_edge(prev, first, random_weight(10, 100));
+			}
+		}
+		
+		// 盲腸線（1から6区間の道）を、辺のうち橋の割合がbridge_ratioになるまで加える
+		void add_branch_lines(double bridge_ratio){
+			if(bridge_ratio <= 0.0 || bridge_ratio >= 1.0) return;
+			size_t target = static_cast<size_t>(edges_.size() * bridge_ratio / (1.0 - bridge_ratio) + 0.5);
+			while(num_bridges_ < target){
+				VertexId prev = static_cast<VertexId>(random_below(num_core_vertices_));
+				size_t length = std::min<size_t>(1 + random_below(6), target - num_bridges_);
+				for(size_t i = 0; i < length; ++i){
+					VertexId v = add_vertex();
+					add_edge(prev, v, random_weight(10, 100));
+					prev = v;
+				}
+				num_bridges_ += length;
+			}
+		}
+		
+		// 盲腸線以外の頂点の間に辺を加え、奇数次の頂点の数をtargetに近づける。
+		// 減らす場合は番号の近い奇数次の頂点同士を、増やす場合は番号の近い偶数次の頂点同士を結ぶ
+		// （盲腸線以外の部分には橋がないので、辺を加えても橋は変わらない）。
+		void adjust_odd_vertices(long target){
+			if(target < 0) return;
+			size_t wanted = static_cast<size_t>(target) & ~static_cast<size_t>(1);
+			size_t odd = num_odd_vertices();
+			
+			VertexId pending = static_cast<VertexId>(-1);
+			for(VertexId v = 0; v < num_core_vertices_ && odd > wanted; ++v){
+				if(degree_[v] % 2 == 0) continue;
+				if(pending == static_cast<VertexId>(-1)){
+					pending = v;
+				}else{
+					add_edge(pending, v, random_weight(10, 300));
+					pending = static_cast<VertexId>(-1);
+					odd -= 2;
+				}
+			}
+			
+			size_t attempts = 0;
+			while(odd < wanted && attempts < 4 * num_core_vertices_){
+				++attempts;
+				VertexId v1 = static_cast<VertexId>(random_below(num_core_vertices_));
+				if(degree_[v1] % 2 == 1) continue;
+				for(size_t step = 1; step < num_core_vertices_; ++step){
+					VertexId v2 = static_cast<VertexId>((v1 + step) % num_core_vertices_);
+					if(degree_[v2] % 2 == 1) continue;
+					add_edge(v1, v2, random_weight(10, 300));
+					odd += 2;
+					break;
+				}
+			}
+		}
+	
+	public:
+		explicit SyntheticNetwork(const SyntheticOptions & options)
+		: random_(options.seed), num_core_vertices_(0), num_bridges_(0){
+			switch(options.shape){
+			case SYNTHETIC_GRID:
+				make_grid(options.num_vertices, false);
+				break;
+			case SYNTHETIC_PLANAR:
+				make_grid(options.num_vertices, true);
+				break;
+			case SYNTHETIC_CYCLES:
+				make_cycles(options.num_vertices);
+				break;
+			}
+			num_core_vertices_ = degree_.size();
+			add_branch_lines(options.bridge_ratio);
+			adjust_odd_vertices(options.num_odd_vertices);
+		}
+		
+		// 形の名前（grid, planar, cycles）を解釈する。解釈できなければfalseを返す。
+		static bool parse_shape(const std::string & name, SyntheticShape & shape){
+			if(name == "grid"){
+				shape = SYNTHETIC_GRID;
+			}else if(name == "planar"){
+				shape = SYNTHETIC_PLANAR;
+			}else if(name == "cycles"){
+				shape = SYNTHETIC_CYCLES;
+			}else{
+				return false;
+			}
+			return true;
+		}
+		
+		static std::string vertex_name(VertexId v){
+			std::ostringstream name;
+			name << "v" << v;
+			return name.str();
+		}
+		
+		inline const std::vector<VirtualEdge> & edges() const{ return edges_; }
+		inline size_t num_vertices() const{ return degree_.size(); }
+		inline size_t num_bridges() const{ return num_bridges_; }
+		
+		size_t num_odd_vertices() const{
+			size_t result = 0;
+			for(std::vector<size_t>::const_iterator itd = degree_.begin(); itd != degree_.end(); ++itd){
+				if(*itd % 2 == 1) ++result;
+			}
+			return result;
+		}
+		
+		// 辺の一覧の形式（距離 駅名1 駅名2）で書き出す
+		void write(std::ostream & os) const{
+			for(std::vector<VirtualEdge>::const_iterator ite = edges_.begin(); ite != edges_.end(); ++ite){
+				os << ite->weight << " " << vertex_name(ite->v1) << " " << vertex_name(ite->v2) << "\n";
+			}
+		}
+	};
+} // namespace ChinesePostman
+
+#endif // SYNTHETIC_NETWORK_HPP_
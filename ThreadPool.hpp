@@ -0,0 +1,170 @@
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+
+namespace ChinesePostman{
+	// 使用するスレッド数を決める。0を与えた場合はCPUのコア数とする。
+	inline size_t resolve_num_threads(size_t num_threads){
+		if(num_threads != 0) return num_threads;
+		size_t hardware = std::thread::hardware_concurrency();
+		return(hardware == 0 ? 1 : hardware);
+	}
+	
+	// work stealing方式のスレッドプール。
+	// スレッドごとに仕事の列を持ち、submitされた仕事は順番に各列へ振り分けられる。
+	// 各スレッドは自分の列の末尾から仕事を取り、自分の列が空になったら
+	// ほかのスレッドの列の先頭から仕事を奪う。
+	// 仕事の中で発生した例外は、wait()で最初の1つが再送出される。
+	class WorkStealingPool{
+	private:
+		typedef std::function<void()> Task;
+		
+		struct TaskQueue{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+		
+		std::vector< std::unique_ptr<TaskQueue> > queues_;
+		std::vector<std::thread> threads_;
+		
+		std::mutex mutex_; // 以下の変数を保護する
+		std::condition_variable task_available_, all_done_;
+		size_t queued_; // 列に入っていて、まだどのスレッドも取ることを決めていない仕事の数
+		size_t unfinished_; // 終わっていない仕事の数
+		size_t next_queue_;
+		bool stopping_;
+		std::exception_ptr error_;
+		
+		// 自分の列の末尾、またはほかの列の先頭から仕事を1つ取る
+		bool take(size_t id, Task & task){
+			{
+				std::lock_guard<std::mutex> lock(queues_[id]->mutex);
+				if(!queues_[id]->tasks.empty()){
+					task.swap(queues_[id]->tasks.back());
+					queues_[id]->tasks.pop_back();
+					return true;
+				}
+			}
+			for(size_t k = 1; k < queues_.size(); ++k){
+				TaskQueue & victim = *(queues_[(id + k) % queues_.size()]);
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if(!victim.tasks.empty()){
+					task.swap(victim.tasks.front());
+					victim.tasks.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+		
+		void work(size_t id){
+			for(;;){
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					task_available_.wait(lock, [&](){ return stopping_ || queued_ > 0; });
+					if(queued_ == 0) return; // stopping_
+					--queued_; // 仕事を1つ取ることを予約する
+				}
+				
+				// 予約した分の仕事はどこかの列に必ず残っている
+				Task task;
+				while(!take(id, task)) std::this_thread::yield();
+				
+				try{
+					task();
+				}catch(...){
+					std::lock_guard<std::mutex> lock(mutex_);
+					if(!error_) error_ = std::current_exception();
+				}
+				
+				std::lock_guard<std::mutex> lock(mutex_);
+				if(--unfinished_ == 0) all_done_.notify_all();
+			}
+		}
+	
+	public:
+		// num_threadsが0の場合はCPUのコア数とする
+		explicit WorkStealingPool(size_t num_threads) : queued_(0), unfinished_(0), next_queue_(0), stopping_(false){
+			num_threads = resolve_num_threads(num_threads);
+			for(size_t i = 0; i < num_threads; ++i){
+				queues_.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+			}
+			for(size_t i = 0; i < num_threads; ++i){
+				threads_.push_back(std::thread(&WorkStealingPool::work, this, i));
+			}
+		}
+		
+		~WorkStealingPool(){
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stopping_ = true;
+			}
+			task_available_.notify_all();
+			for(std::vector<std::thread>::iterator itt = threads_.begin(); itt != threads_.end(); ++itt){
+				itt->join();
+			}
+		}
+		
+		inline size_t num_threads() const{ return threads_.size(); }
+		
+		void submit(Task task){
+			size_t id;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				id = (next_queue_++) % queues_.size();
+				++unfinished_;
+			}
+			{
+				std::lock_guard<std::mutex> lock(queues_[id]->mutex);
+				queues_[id]->tasks.push_back(Task());
+				queues_[id]->tasks.back().swap(task);
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				++queued_;
+			}
+			task_available_.notify_one();
+		}
+		
+		// submitしたすべての仕事が終わるまで待つ
+		void wait(){
+			std::unique_lock<std::mutex> lock(mutex_);
+			all_done_.wait(lock, [&](){ return unfinished_ == 0; });
+			if(error_){
+				std::exception_ptr error = error_;
+				error_ = std::exception_ptr();
+				std::rethrow_exception(error);
+			}
+		}
+	};
+	
+	// task(0)～task(count-1)を実行する。
+	// num_threadsが1の場合はスレッドを作らずに順番に実行する（0の場合はCPUのコア数）。
+	// 各taskは互いに独立でなければならない。結果はtaskの番号ごとに別の場所へ書き込み、
+	// 終了後に番号順にまとめれば、スレッド数によらず同じ結果が得られる。
+	template <class TaskFunction>
+	void parallel_for(size_t count, size_t num_threads, TaskFunction task){
+		num_threads = std::min(resolve_num_threads(num_threads), count);
+		if(num_threads <= 1){
+			for(size_t i = 0; i < count; ++i) task(i);
+			return;
+		}
+		
+		WorkStealingPool pool(num_threads);
+		for(size_t i = 0; i < count; ++i){
+			pool.submit([&task, i](){ task(i); });
+		}
+		pool.wait();
+	}
+} // namespace ChinesePostman
+
+#endif // THREAD_POOL_HPP_
@@ -1,91 +1,141 @@
-#ifndef MASKED_VECTOR_HPP_
-#define MASKED_VECTOR_HPP_
-
-#include <vector>
-#include <boost/multiprecision/cpp_int.hpp>
-
-// Ql: http://txt-txt.hateblo.jp/entry/2013/07/11/184157
-
-template <class ElementType> class masked_vector{
-public:
-	typedef boost::multiprecision::cpp_int mask_type;
-	
-private:
-	std::vector<ElementType> elements_;
-	mask_type mask_;
-	
-public:
-	masked_vector() : elements_(), mask_(0){}
-	
-	template <class ContainerType> masked_vector(const ContainerType & container)
-	: elements_(container.begin(), container.end()),
-	  mask_(0){}
-	
-	inline bool has(size_t pos) const{ return boost::multiprecision::bit_test(mask_, pos); }
-	inline ElementType & operator[](size_t pos){ return elements_[pos]; }
-	inline const ElementType & operator[](size_t pos) const{ return elements_[pos]; }
-	inline size_t size() const{ return elements_.size(); }
-	inline size_t length() const{ return elements_.size(); }
-	inline mask_type mask() const{ return mask_; }
-	inline void set_mask(mask_type new_mask){ mask_ = new_mask; }
-	
-	size_t mask_size() const{
-		size_t result = 0;
-		for(size_t i = 0; i < size(); ++i){
-			result += (has(i) ? 1 : 0);
-		}
-		return result;
-	}
-	
-	inline void push_back(const ElementType & elem){
-		elements_.push_back(elem);
-	}
-	
-	void next(){
-		++mask_;
-		boost::multiprecision::bit_unset(mask_, size());
-	}
-	
-	inline bool emptymask(){
-		return(mask_ == 0);
-	}
-	
-	// Ԗڂ̈ʒuɏo邩ԂB
-	// oȂꍇ size() ԂB
-	// }XN킸ȀWɊ܂܂ĂΏoƂ݂ȂB
-	// 2^ꂽꍇAɃ}XN̒li[B
-	size_t index_orig(const ElementType & key, bool & appearing) const{
-		appearing = false;
-		size_t i;
-		for(i = 0; i < size(); ++i){
-			if(key == elements_[i]){
-				appearing = has(i);
-				break;
-			}
-		}
-		return i;
-	}
-	
-	size_t index_orig(const ElementType & key) const{
-		size_t i;
-		for(i = 0; i < size(); ++i){
-			if(key == elements_[i]){
-				break;
-			}
-		}
-		return i;
-	}
-	
-	// Ԗڂ̈ʒuɏo邩ԂB
-	// oȂꍇ size() ԂB
-	// A}XNɂāu܂łvƔ肳ꂽꍇ̂ݏoƂ݂ȂB
-	size_t index(const ElementType & key) const{
-		size_t i;
-		for(i = 0; i < size(); ++i){
-			if(has(i) && key == elements_[i]) break;
-		}
-		return i;
-	}
-};
-
-#endif // MASKED_VECTOR_HPP_
+#ifndef MASKED_VECTOR_HPP_
+#define MASKED_VECTOR_HPP_
+
+#include <vector>
+#include <bitset>
+#include <unordered_map>
+#include <boost/cstdint.hpp>
+#include <boost/multiprecision/cpp_int.hpp>
+
+// 参考: http://txt-txt.hateblo.jp/entry/2013/07/11/184157
+
+// マスクの型ごとのビット操作。
+// max_bits()はその型で表せるビット数（制限がなければ size_t の最大値）。
+template <class MaskType> struct masked_vector_mask_traits;
+
+// 任意のビット数を扱える（ただし遅い）
+template <> struct masked_vector_mask_traits<boost::multiprecision::cpp_int>{
+	typedef boost::multiprecision::cpp_int mask_type;
+	static inline size_t max_bits(){ return static_cast<size_t>(-1); }
+	static inline bool test(const mask_type & mask, size_t pos){ return boost::multiprecision::bit_test(mask, pos); }
+	static inline void set(mask_type & mask, size_t pos){ boost::multiprecision::bit_set(mask, pos); }
+	static inline void flip(mask_type & mask, size_t pos){ boost::multiprecision::bit_flip(mask, pos); }
+	static inline bool none(const mask_type & mask){ return mask == 0; }
+	static inline void increment(mask_type & mask, size_t bits){
+		++mask;
+		boost::multiprecision::bit_unset(mask, bits);
+	}
+};
+
+// 64ビット以下ならこちらが速い
+template <> struct masked_vector_mask_traits<boost::uint64_t>{
+	typedef boost::uint64_t mask_type;
+	static inline size_t max_bits(){ return 64; }
+	static inline bool test(mask_type mask, size_t pos){ return ((mask >> pos) & 1) != 0; }
+	static inline void set(mask_type & mask, size_t pos){ mask |= (static_cast<mask_type>(1) << pos); }
+	static inline void flip(mask_type & mask, size_t pos){ mask ^= (static_cast<mask_type>(1) << pos); }
+	static inline bool none(mask_type mask){ return mask == 0; }
+	static inline void increment(mask_type & mask, size_t bits){
+		++mask;
+		if(bits < 64) mask &= ((static_cast<mask_type>(1) << bits) - 1);
+	}
+};
+
+template <size_t N> struct masked_vector_mask_traits< std::bitset<N> >{
+	typedef std::bitset<N> mask_type;
+	static inline size_t max_bits(){ return N; }
+	static inline bool test(const mask_type & mask, size_t pos){ return mask.test(pos); }
+	static inline void set(mask_type & mask, size_t pos){ mask.set(pos); }
+	static inline void flip(mask_type & mask, size_t pos){ mask.flip(pos); }
+	static inline bool none(const mask_type & mask){ return mask.none(); }
+	static inline void increment(mask_type & mask, size_t bits){
+		// 下位のビットから繰り上げる
+		for(size_t pos = 0; pos < bits; ++pos){
+			mask.flip(pos);
+			if(mask.test(pos)) return;
+		}
+	}
+};
+
+// 要素の列と、そのうちどれを「含む」かを表すマスクの組。
+// マスクの型はMaskTypeで指定する（masked_vector_mask_traitsを参照）。
+// 要素数が64以下なら boost::uint64_t を使うと、多倍長整数より速い。
+template <class ElementType, class MaskType = boost::multiprecision::cpp_int> class masked_vector{
+public:
+	typedef MaskType mask_type;
+	typedef masked_vector_mask_traits<MaskType> traits_type;
+	
+private:
+	std::vector<ElementType> elements_;
+	std::unordered_map<ElementType, size_t> positions_; // 要素→最初に現れる位置
+	mask_type mask_;
+	
+public:
+	masked_vector() : elements_(), mask_(){}
+	
+	template <class ContainerType> masked_vector(const ContainerType & container)
+	: elements_(), mask_(){
+		for(typename ContainerType::const_iterator it = container.begin(); it != container.end(); ++it){
+			push_back(*it);
+		}
+	}
+	
+	inline bool has(size_t pos) const{ return traits_type::test(mask_, pos); }
+	inline ElementType & operator[](size_t pos){ return elements_[pos]; }
+	inline const ElementType & operator[](size_t pos) const{ return elements_[pos]; }
+	inline size_t size() const{ return elements_.size(); }
+	inline size_t length() const{ return elements_.size(); }
+	inline const mask_type & mask() const{ return mask_; }
+	inline void set_mask(const mask_type & new_mask){ mask_ = new_mask; }
+	
+	size_t mask_size() const{
+		size_t result = 0;
+		for(size_t i = 0; i < size(); ++i){
+			result += (has(i) ? 1 : 0);
+		}
+		return result;
+	}
+	
+	// マスクの型で表せる要素数を超えてはならない
+	inline void push_back(const ElementType & elem){
+		positions_.insert(std::make_pair(elem, elements_.size()));
+		elements_.push_back(elem);
+	}
+	
+	void next(){
+		traits_type::increment(mask_, size());
+	}
+	
+	inline bool emptymask() const{
+		return traits_type::none(mask_);
+	}
+	
+	// 何番目の位置に出現するかを返す。
+	// 出現しない場合は size() を返す。
+	// マスクを問わず、元の集合に含まれていれば出現するとみなす。
+	// 第2引数が与えられた場合、そこにマスクの値が格納される。
+	size_t index_orig(const ElementType & key, bool & appearing) const{
+		size_t i = index_orig(key);
+		appearing = (i != size() && has(i));
+		return i;
+	}
+	
+	size_t index_orig(const ElementType & key) const{
+		typename std::unordered_map<ElementType, size_t>::const_iterator it = positions_.find(key);
+		return(it == positions_.end() ? size() : it->second);
+	}
+	
+	// 何番目の位置に出現するかを返す。
+	// 出現しない場合は size() を返す。
+	// ただし、マスクによって「含んでいる」と判定された場合のみ出現するとみなす。
+	// （同じ要素が複数ある場合は、マスクで含まれている最初の位置）
+	size_t index(const ElementType & key) const{
+		size_t i;
+		for(i = index_orig(key); i < size(); ++i){
+			if(has(i) && key == elements_[i]) break;
+		}
+		return i;
+	}
+};
+
+#endif // MASKED_VECTOR_HPP_